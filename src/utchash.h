@@ -0,0 +1,437 @@
+/*
+Copyright (c) 2008-2012, Troy D. Hanson   http://uthash.sourceforge.net
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS
+IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER
+OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+/* hash tables for many concurrent writers, using macros: a striped-lock
+ * table (CHASH_*), and sharded uthash tables (HASH_SHARD_*, below)
+ * see http://uthash.sourceforge.net/utchash.html
+ *
+ * Like uthash, the table is intrusive: each item embeds a UT_chash_handle.
+ * Unlike uthash, there is no app-order list and no tail, which every add
+ * and delete would have to update under one lock. Instead the buckets are
+ * guarded by CHASH_STRIPES locks, bucket b by lock b % CHASH_STRIPES.
+ * Since the bucket count is a power of two no smaller than CHASH_STRIPES,
+ * the stripe of an item is just the low bits of its hash value, whatever
+ * the table size: doubling the table splits each bucket into two buckets
+ * of the same stripe. An add, find or delete holds only the lock of its
+ * stripe. Expansion takes every lock, in order, so it excludes them all.
+ */
+#ifndef UTCHASH_H
+#define UTCHASH_H
+
+#define UTCHASH_VERSION 1.9.6
+
+#include "uthash.h"   /* HASH_FCN, HASH_KEYCMP, UT_hash_size, UT_hash_value */
+
+#ifndef utchash_lock_t
+#include <pthread.h>
+#define utchash_lock_t pthread_mutex_t
+#define utchash_lock_init(l) pthread_mutex_init(l,NULL)
+#define utchash_lock_fini(l) pthread_mutex_destroy(l)
+#define utchash_lock(l) pthread_mutex_lock(l)
+#define utchash_unlock(l) pthread_mutex_unlock(l)
+#endif
+#ifndef utchash_expand_fyi
+#define utchash_expand_fyi(tbl)           /* can be defined to log expands   */
+#endif
+
+#ifndef CHASH_STRIPES
+#define CHASH_STRIPES 64         /* bucket locks; a power of two           */
+#endif
+#ifndef CHASH_LOAD
+#define CHASH_LOAD 4             /* items per bucket of a stripe to expand */
+#endif
+#ifndef CHASH_LINE
+#define CHASH_LINE 64            /* cache line size, to pad the stripes    */
+#endif
+
+typedef struct UT_chash_handle {
+   struct UT_chash_handle *hh_next;  /* next item in the bucket chain */
+   const void *key;                  /* ptr to enclosing struct's key */
+   UT_hash_size keylen;              /* enclosing struct's key len    */
+   UT_hash_value hashv;              /* result of hash-fcn(key)       */
+} UT_chash_handle;
+
+/* a lock and the number of items in the buckets it guards, alone on their
+ * cache line(s) so that threads working on different stripes do not share */
+typedef union UT_chash_stripe {
+   struct {
+      utchash_lock_t lock;
+      UT_hash_size count;
+   } s;
+   char pad[CHASH_LINE * ((sizeof(utchash_lock_t) + sizeof(UT_hash_size) +
+                           CHASH_LINE - 1) / CHASH_LINE)];
+} UT_chash_stripe;
+
+typedef struct UT_chash_table {
+   UT_chash_handle **buckets;        /* head of each bucket chain     */
+   UT_hash_size num_buckets;
+   ptrdiff_t hho;                    /* offset of the handle in items */
+   char pad[CHASH_LINE];             /* keep the above off the stripes */
+   UT_chash_stripe stripes[CHASH_STRIPES];
+} UT_chash_table;
+
+#define CHASH_ELMT(tbl,hhp) ((void*)(((char*)(hhp)) - ((tbl)->hho)))
+#define CHASH_STRIPE(tbl,hashv) (&((tbl)->stripes[(hashv) & (CHASH_STRIPES-1)].s))
+
+/* a stripe holding more than CHASH_LOAD items per bucket doubles the table */
+#define CHASH_STRIPE_MAX(num_bkts) (((num_bkts) / CHASH_STRIPES) * CHASH_LOAD)
+
+/* the hash value of a key under HASH_FCN, the same in every table; the
+ * bucket is taken later, under the lock */
+#define CHASH_VALUE(keyptr,keylen_in,hashv)                                      \
+do {                                                                             \
+  UT_hash_size _chv_bkt;                                                         \
+  HASH_FCN(keyptr,keylen_in,(UT_hash_size)1,hashv,_chv_bkt);                     \
+  (void)_chv_bkt;                                                                \
+} while(0)
+
+/* set up the table tbl for items of the given type, whose UT_chash_handle
+ * is the field hh. The table itself is the caller's to allocate. */
+#define CHASH_INIT(tbl,type,hh)                                                  \
+do {                                                                             \
+  unsigned _chi_s, _chi_log2;                                                    \
+  HASH_LOG2_FOR(CHASH_STRIPES, _chi_log2);                                       \
+  (tbl)->num_buckets = (UT_hash_size)1 << _chi_log2;                             \
+  (tbl)->hho = offsetof(type,hh);                                                \
+  (tbl)->buckets = (UT_chash_handle**)uthash_malloc(                             \
+                   (tbl)->num_buckets * sizeof(UT_chash_handle*));               \
+  if (!(tbl)->buckets) { uthash_fatal( "out of memory"); }                       \
+  memset((tbl)->buckets, 0, (tbl)->num_buckets * sizeof(UT_chash_handle*));      \
+  for(_chi_s = 0; _chi_s < CHASH_STRIPES; _chi_s++) {                            \
+    utchash_lock_init(&((tbl)->stripes[_chi_s].s.lock));                         \
+    (tbl)->stripes[_chi_s].s.count = 0;                                          \
+  }                                                                              \
+} while(0)
+
+/* release the buckets and locks of tbl; the items are the caller's */
+#define CHASH_FREE(tbl)                                                          \
+do {                                                                             \
+  unsigned _chx_s;                                                               \
+  for(_chx_s = 0; _chx_s < CHASH_STRIPES; _chx_s++) {                            \
+    utchash_lock_fini(&((tbl)->stripes[_chx_s].s.lock));                         \
+  }                                                                              \
+  uthash_free((tbl)->buckets, (tbl)->num_buckets * sizeof(UT_chash_handle*));    \
+  (tbl)->buckets = NULL;                                                         \
+} while(0)
+
+/* double the bucket array, unless another thread already did since this
+ * one saw seen_num buckets */
+#define CHASH_EXPAND(tbl,seen_num)                                               \
+do {                                                                             \
+  unsigned _che_s;                                                               \
+  UT_hash_size _che_i, _che_n, _che_bkt;                                         \
+  UT_chash_handle **_che_new, *_che_thh, *_che_nxt;                              \
+  for(_che_s = 0; _che_s < CHASH_STRIPES; _che_s++) {                            \
+    utchash_lock(&((tbl)->stripes[_che_s].s.lock));                              \
+  }                                                                              \
+  _che_n = (tbl)->num_buckets;                                                   \
+  if (_che_n == (seen_num)) {                                                    \
+    _che_new = (UT_chash_handle**)uthash_malloc(                                 \
+               2 * _che_n * sizeof(UT_chash_handle*));                           \
+    if (!_che_new) { uthash_fatal( "out of memory"); }                           \
+    memset(_che_new, 0, 2 * _che_n * sizeof(UT_chash_handle*));                  \
+    for(_che_i = 0; _che_i < _che_n; _che_i++) {                                 \
+      for(_che_thh = (tbl)->buckets[_che_i]; _che_thh; _che_thh = _che_nxt) {    \
+        _che_nxt = _che_thh->hh_next;                                            \
+        _che_bkt = _che_thh->hashv & (2 * _che_n - 1);                           \
+        _che_thh->hh_next = _che_new[_che_bkt];                                  \
+        _che_new[_che_bkt] = _che_thh;                                           \
+      }                                                                          \
+    }                                                                            \
+    uthash_free((tbl)->buckets, _che_n * sizeof(UT_chash_handle*));              \
+    (tbl)->buckets = _che_new;                                                   \
+    (tbl)->num_buckets = 2 * _che_n;                                             \
+    utchash_expand_fyi(tbl);                                                     \
+  }                                                                              \
+  for(_che_s = 0; _che_s < CHASH_STRIPES; _che_s++) {                            \
+    utchash_unlock(&((tbl)->stripes[_che_s].s.lock));                            \
+  }                                                                              \
+} while(0)
+
+/* with the stripe of hashval locked, find the item with the given key */
+#define CHASH_FIND_LOCKED(tbl,keyptr,keylen_in,hashval,out)                      \
+do {                                                                             \
+  UT_chash_handle *_chf_thh;                                                     \
+  out=NULL;                                                                      \
+  for(_chf_thh = (tbl)->buckets[(hashval) & ((tbl)->num_buckets-1)];             \
+      _chf_thh; _chf_thh = _chf_thh->hh_next) {                                  \
+    if ((_chf_thh->hashv == (hashval)) && (_chf_thh->keylen == (keylen_in)) &&   \
+        (HASH_KEYCMP(_chf_thh->key,keyptr,keylen_in) == 0)) {                    \
+      DECLTYPE_ASSIGN(out,CHASH_ELMT(tbl,_chf_thh));                             \
+      break;                                                                     \
+    }                                                                            \
+  }                                                                              \
+} while(0)
+
+/* with the stripe of its hash value locked, link the handle addhh into its
+ * bucket; grow is set if the table should now be expanded */
+#define CHASH_ADD_LOCKED(tbl,addhh,seen_num,grow)                                \
+do {                                                                             \
+  UT_hash_size _chl_bkt;                                                         \
+  UT_chash_handle *_chl_hh = (addhh);                                            \
+  seen_num = (tbl)->num_buckets;                                                 \
+  _chl_bkt = _chl_hh->hashv & ((seen_num)-1);                                    \
+  _chl_hh->hh_next = (tbl)->buckets[_chl_bkt];                                   \
+  (tbl)->buckets[_chl_bkt] = _chl_hh;                                            \
+  grow = (++(CHASH_STRIPE(tbl,_chl_hh->hashv)->count) >                          \
+          CHASH_STRIPE_MAX(seen_num));                                           \
+} while(0)
+
+#define CHASH_FIND(hh,tbl,keyptr,keylen,out)                                     \
+do {                                                                             \
+  UT_hash_value _chf_hashv;                                                      \
+  CHASH_VALUE(keyptr,keylen,_chf_hashv);                                         \
+  utchash_lock(&(CHASH_STRIPE(tbl,_chf_hashv)->lock));                           \
+  CHASH_FIND_LOCKED(tbl,keyptr,(UT_hash_size)(keylen),_chf_hashv,out);           \
+  utchash_unlock(&(CHASH_STRIPE(tbl,_chf_hashv)->lock));                         \
+} while(0)
+
+#define CHASH_ADD(hh,tbl,fieldname,keylen_in,add)                                \
+        CHASH_ADD_KEYPTR(hh,tbl,&((add)->fieldname),keylen_in,add)
+
+#define CHASH_ADD_KEYPTR(hh,tbl,keyptr,keylen_in,add)                            \
+do {                                                                             \
+  UT_hash_size _cha_n;                                                           \
+  int _cha_grow;                                                                 \
+  (add)->hh.key = (keyptr);                                                      \
+  (add)->hh.keylen = (UT_hash_size)(keylen_in);                                  \
+  CHASH_VALUE(keyptr,keylen_in,(add)->hh.hashv);                                 \
+  utchash_lock(&(CHASH_STRIPE(tbl,(add)->hh.hashv)->lock));                      \
+  CHASH_ADD_LOCKED(tbl,&((add)->hh),_cha_n,_cha_grow);                           \
+  utchash_unlock(&(CHASH_STRIPE(tbl,(add)->hh.hashv)->lock));                    \
+  if (_cha_grow) { CHASH_EXPAND(tbl,_cha_n); }                                   \
+} while(0)
+
+/* With several writers, finding a key and then adding it is a race: two
+ * threads may both miss, and both add. This does both under one lock. If
+ * an item with the key of add is present, out is set to it and add is left
+ * alone; otherwise add is added, and out is set to add. */
+#define CHASH_FIND_OR_ADD(hh,tbl,fieldname,keylen_in,add,out)                    \
+        CHASH_FIND_OR_ADD_KEYPTR(hh,tbl,&((add)->fieldname),keylen_in,add,out)
+
+#define CHASH_FIND_OR_ADD_KEYPTR(hh,tbl,keyptr,keylen_in,add,out)                \
+do {                                                                             \
+  UT_hash_value _cho_hashv;                                                      \
+  UT_hash_size _cho_n;                                                           \
+  int _cho_grow = 0;                                                             \
+  CHASH_VALUE(keyptr,keylen_in,_cho_hashv);                                      \
+  utchash_lock(&(CHASH_STRIPE(tbl,_cho_hashv)->lock));                           \
+  CHASH_FIND_LOCKED(tbl,keyptr,(UT_hash_size)(keylen_in),_cho_hashv,out);        \
+  if (!(out)) {                                                                  \
+    (add)->hh.key = (keyptr);                                                    \
+    (add)->hh.keylen = (UT_hash_size)(keylen_in);                                \
+    (add)->hh.hashv = _cho_hashv;                                                \
+    CHASH_ADD_LOCKED(tbl,&((add)->hh),_cho_n,_cho_grow);                         \
+    DECLTYPE_ASSIGN(out,add);                                                    \
+  }                                                                              \
+  utchash_unlock(&(CHASH_STRIPE(tbl,_cho_hashv)->lock));                         \
+  if (_cho_grow) { CHASH_EXPAND(tbl,_cho_n); }                                   \
+} while(0)
+
+/* unlink delptr, which must be in the table. Other threads may have found
+ * it before, so the caller must know that none is still using it before
+ * freeing it. */
+#define CHASH_DELETE(hh,tbl,delptr)                                              \
+do {                                                                             \
+  UT_chash_handle **_chd_pp, *_chd_hh = &((delptr)->hh);                         \
+  utchash_lock(&(CHASH_STRIPE(tbl,_chd_hh->hashv)->lock));                       \
+  _chd_pp = &((tbl)->buckets[_chd_hh->hashv & ((tbl)->num_buckets-1)]);          \
+  while (*_chd_pp != _chd_hh) { _chd_pp = &((*_chd_pp)->hh_next); }             \
+  *_chd_pp = _chd_hh->hh_next;                                                   \
+  CHASH_STRIPE(tbl,_chd_hh->hashv)->count--;                                     \
+  utchash_unlock(&(CHASH_STRIPE(tbl,_chd_hh->hashv)->lock));                     \
+} while(0)
+
+/* the number of items; only a snapshot while other threads add or delete */
+#define CHASH_COUNT(tbl,n)                                                       \
+do {                                                                             \
+  unsigned _chc_s;                                                               \
+  (n) = 0;                                                                       \
+  for(_chc_s = 0; _chc_s < CHASH_STRIPES; _chc_s++) {                            \
+    utchash_lock(&((tbl)->stripes[_chc_s].s.lock));                              \
+    (n) += (tbl)->stripes[_chc_s].s.count;                                       \
+    utchash_unlock(&((tbl)->stripes[_chc_s].s.lock));                            \
+  }                                                                              \
+} while(0)
+
+/* convenience forms, for a handle named hh */
+#define CHASH_FIND_STR(tbl,findstr,out)                                          \
+    CHASH_FIND(hh,tbl,findstr,strlen(findstr),out)
+#define CHASH_ADD_STR(tbl,strfield,add)                                          \
+    CHASH_ADD(hh,tbl,strfield,strlen(add->strfield),add)
+#define CHASH_FIND_INT(tbl,findint,out)                                          \
+    CHASH_FIND(hh,tbl,findint,sizeof(int),out)
+#define CHASH_ADD_INT(tbl,intfield,add)                                          \
+    CHASH_ADD(hh,tbl,intfield,sizeof(int),add)
+#define CHASH_DEL(tbl,delptr)                                                    \
+    CHASH_DELETE(hh,tbl,delptr)
+
+/* Sharded uthash tables. A UT_hash_shards(type,log2) holds 2^log2 ordinary
+ * uthash tables (heads of type*), each with its own lock. An operation
+ * hashes the key once, with CHASH_VALUE, and its top log2 bits choose the
+ * shard; the table of that shard then takes the bucket from the low bits.
+ * Each shard expands on its own, so instead of one large doubling there are
+ * many small ones, and threads on different shards do not contend. Since
+ * each shard is a uthash table, HASH_CNT and the other statistics apply to
+ * it alone (sh->shard[i].head). With -DHASH_SEEDED or -DHASH_TABLE_FCN the
+ * shard tables hash the key again, their own way. */
+#define UT_hash_shards(type,log2)                                                \
+  struct {                                                                       \
+    struct {                                                                     \
+      type *head;                                                                \
+      utchash_lock_t lock;                                                       \
+      char pad[CHASH_LINE];   /* keep the shards off each other's lines */       \
+    } shard[1 << (log2)];                                                        \
+    unsigned log2_num_shards;                                                    \
+  }
+
+#define HASH_SHARDS_NUM(sh) (sizeof((sh)->shard) / sizeof((sh)->shard[0]))
+#define HASH_SHARD_OF(sh,hashv)                                                  \
+  ((sh)->log2_num_shards ?                                                       \
+   (unsigned)((hashv) >> (sizeof(UT_hash_value)*8 - (sh)->log2_num_shards)) : 0)
+#define HASH_SHARD_LOCK(sh,i) utchash_lock(&((sh)->shard[i].lock))
+#define HASH_SHARD_UNLOCK(sh,i) utchash_unlock(&((sh)->shard[i].lock))
+
+#if defined(HASH_SEEDED) || defined(HASH_TABLE_FCN)
+#define HASH_SHARD_ITEM_VALUE(hh,item,val)                                       \
+  CHASH_VALUE(HASH_HH_KEY(&((item)->hh)), (item)->hh.keylen, val)
+#define HASH_SHARD_FIND_IN(hh,head,keyptr,keylen,hashv,out)                      \
+  HASH_FIND(hh,head,keyptr,keylen,out)
+#define HASH_SHARD_ADD_IN(hh,head,keyptr,keylen,hashv,add)                       \
+  HASH_ADD_KEYPTR(hh,head,keyptr,keylen,add)
+#else
+#define HASH_SHARD_ITEM_VALUE(hh,item,val) ((val) = (item)->hh.hashv)
+#define HASH_SHARD_FIND_IN(hh,head,keyptr,keylen,hashv,out)                      \
+  HASH_FIND_BYHASHVALUE(hh,head,keyptr,keylen,hashv,out)
+#define HASH_SHARD_ADD_IN(hh,head,keyptr,keylen,hashv,add)                       \
+  HASH_ADD_KEYPTR_BYHASHVALUE(hh,head,keyptr,keylen,hashv,add)
+#endif
+
+#define HASH_SHARDS_INIT(sh)                                                     \
+do {                                                                             \
+  unsigned _hsi_i;                                                               \
+  (sh)->log2_num_shards = 0;                                                     \
+  while ((1U << (sh)->log2_num_shards) < HASH_SHARDS_NUM(sh)) {                  \
+    (sh)->log2_num_shards++;                                                     \
+  }                                                                              \
+  for(_hsi_i = 0; _hsi_i < HASH_SHARDS_NUM(sh); _hsi_i++) {                      \
+    (sh)->shard[_hsi_i].head = NULL;                                             \
+    utchash_lock_init(&((sh)->shard[_hsi_i].lock));                              \
+  }                                                                              \
+} while(0)
+
+/* clear every shard, as HASH_CLEAR, and release the locks */
+#define HASH_SHARDS_FREE(hh,sh)                                                  \
+do {                                                                             \
+  unsigned _hsx_i;                                                               \
+  for(_hsx_i = 0; _hsx_i < HASH_SHARDS_NUM(sh); _hsx_i++) {                      \
+    HASH_CLEAR(hh,(sh)->shard[_hsx_i].head);                                     \
+    utchash_lock_fini(&((sh)->shard[_hsx_i].lock));                              \
+  }                                                                              \
+} while(0)
+
+#define HASH_SHARD_FIND(hh,sh,keyptr,keylen,out)                                 \
+do {                                                                             \
+  UT_hash_value _hsf_hashv;                                                      \
+  unsigned _hsf_i;                                                               \
+  CHASH_VALUE(keyptr,keylen,_hsf_hashv);                                         \
+  _hsf_i = HASH_SHARD_OF(sh,_hsf_hashv);                                         \
+  HASH_SHARD_LOCK(sh,_hsf_i);                                                    \
+  HASH_SHARD_FIND_IN(hh,(sh)->shard[_hsf_i].head,keyptr,keylen,_hsf_hashv,out);  \
+  HASH_SHARD_UNLOCK(sh,_hsf_i);                                                  \
+} while(0)
+
+#define HASH_SHARD_ADD(hh,sh,fieldname,keylen_in,add)                            \
+        HASH_SHARD_ADD_KEYPTR(hh,sh,&((add)->fieldname),keylen_in,add)
+
+#define HASH_SHARD_ADD_KEYPTR(hh,sh,keyptr,keylen_in,add)                        \
+do {                                                                             \
+  UT_hash_value _hsa_hashv;                                                      \
+  unsigned _hsa_i;                                                               \
+  CHASH_VALUE(keyptr,keylen_in,_hsa_hashv);                                      \
+  _hsa_i = HASH_SHARD_OF(sh,_hsa_hashv);                                         \
+  HASH_SHARD_LOCK(sh,_hsa_i);                                                    \
+  HASH_SHARD_ADD_IN(hh,(sh)->shard[_hsa_i].head,keyptr,keylen_in,_hsa_hashv,add);\
+  HASH_SHARD_UNLOCK(sh,_hsa_i);                                                  \
+} while(0)
+
+/* as CHASH_FIND_OR_ADD: add add unless its key is present, under one lock */
+#define HASH_SHARD_FIND_OR_ADD(hh,sh,fieldname,keylen_in,add,out)                \
+do {                                                                             \
+  UT_hash_value _hso_hashv;                                                      \
+  unsigned _hso_i;                                                               \
+  CHASH_VALUE(&((add)->fieldname),keylen_in,_hso_hashv);                         \
+  _hso_i = HASH_SHARD_OF(sh,_hso_hashv);                                         \
+  HASH_SHARD_LOCK(sh,_hso_i);                                                    \
+  HASH_SHARD_FIND_IN(hh,(sh)->shard[_hso_i].head,&((add)->fieldname),            \
+                     keylen_in,_hso_hashv,out);                                  \
+  if (!(out)) {                                                                  \
+    HASH_SHARD_ADD_IN(hh,(sh)->shard[_hso_i].head,&((add)->fieldname),           \
+                      keylen_in,_hso_hashv,add);                                 \
+    DECLTYPE_ASSIGN(out,add);                                                    \
+  }                                                                              \
+  HASH_SHARD_UNLOCK(sh,_hso_i);                                                  \
+} while(0)
+
+#define HASH_SHARD_DELETE(hh,sh,delptr)                                          \
+do {                                                                             \
+  UT_hash_value _hsd_hashv;                                                      \
+  unsigned _hsd_i;                                                               \
+  HASH_SHARD_ITEM_VALUE(hh,delptr,_hsd_hashv);                                   \
+  _hsd_i = HASH_SHARD_OF(sh,_hsd_hashv);                                         \
+  HASH_SHARD_LOCK(sh,_hsd_i);                                                    \
+  HASH_DELETE(hh,(sh)->shard[_hsd_i].head,delptr);                               \
+  HASH_SHARD_UNLOCK(sh,_hsd_i);                                                  \
+} while(0)
+
+/* the number of items in all shards, taking each lock in turn */
+#define HASH_SHARDS_COUNT(hh,sh,n)                                               \
+do {                                                                             \
+  unsigned _hsc_i;                                                               \
+  (n) = 0;                                                                       \
+  for(_hsc_i = 0; _hsc_i < HASH_SHARDS_NUM(sh); _hsc_i++) {                      \
+    HASH_SHARD_LOCK(sh,_hsc_i);                                                  \
+    (n) += HASH_CNT(hh,(sh)->shard[_hsc_i].head);                                \
+    HASH_SHARD_UNLOCK(sh,_hsc_i);                                                \
+  }                                                                              \
+} while(0)
+
+/* iterate over the items of every shard, shard by shard, with i (an
+ * unsigned) as the shard index. No lock is taken: the caller must keep
+ * writers out, or else lock each shard itself and use HASH_ITER on it. */
+#define HASH_SHARDS_ITER(hh,sh,i,el,tmp)                                         \
+  for((i) = 0; (i) < HASH_SHARDS_NUM(sh); (i)++)                                 \
+    HASH_ITER(hh,(sh)->shard[i].head,el,tmp)
+
+#define HASH_SHARD_FIND_STR(sh,findstr,out)                                      \
+    HASH_SHARD_FIND(hh,sh,findstr,strlen(findstr),out)
+#define HASH_SHARD_ADD_STR(sh,strfield,add)                                      \
+    HASH_SHARD_ADD(hh,sh,strfield,strlen(add->strfield),add)
+#define HASH_SHARD_FIND_INT(sh,findint,out)                                      \
+    HASH_SHARD_FIND(hh,sh,findint,sizeof(int),out)
+#define HASH_SHARD_ADD_INT(sh,intfield,add)                                      \
+    HASH_SHARD_ADD(hh,sh,intfield,sizeof(int),add)
+#define HASH_SHARD_DEL(sh,delptr)                                                \
+    HASH_SHARD_DELETE(hh,sh,delptr)
+
+#endif /* UTCHASH_H */
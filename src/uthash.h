@@ -59,22 +59,78 @@ do {
 /* a number of the hash function use uint32_t which isn't defined on win32 */
 #ifdef _MSC_VER
 typedef unsigned int uint32_t;
+typedef int int32_t;
+typedef unsigned __int64 uint64_t;
 typedef unsigned char uint8_t;
 #else
 #include <inttypes.h>   /* uint32_t */
 #endif
 
+/* item and bucket counts, key lengths and hash values. HASH_64BIT widens
+ * them so that a table can hold more than 2^32 items, at the cost of two
+ * more words in every hash handle and table. */
+#ifdef HASH_64BIT
+typedef uint64_t UT_hash_size;
+typedef uint64_t UT_hash_value;
+#define HASH_JOIN32(hi,lo) ((((uint64_t)(hi)) << 32) | (uint32_t)(lo))
+#else
+typedef unsigned UT_hash_size;
+typedef unsigned UT_hash_value;
+#define HASH_JOIN32(hi,lo) (lo)
+#endif
+
+/* a hash function that can be chosen per table (-DHASH_TABLE_FCN). It sets
+ * *hashv to the hash of the keylen bytes at key, under the given seed. */
+#if defined(HASH_AUTO_FCN) && !defined(HASH_TABLE_FCN)
+#define HASH_TABLE_FCN
+#endif
+typedef void (UT_hash_fcn)(const void *key, UT_hash_size keylen, uint64_t seed,
+                           UT_hash_value *hashv);
+
+/* the few functions defined here are static inline only so that unused ones
+ * draw no warning */
+#if defined(__cplusplus) || (defined(__STDC_VERSION__) && (__STDC_VERSION__ >= 199901L))
+#define HASH_INLINE inline
+#elif defined(__GNUC__)
+#define HASH_INLINE __inline__
+#elif defined(_MSC_VER)
+#define HASH_INLINE __inline
+#else
+#define HASH_INLINE
+#endif
+
 #define UTHASH_VERSION 1.9.6
 
 #ifndef uthash_fatal
 #define uthash_fatal(msg) exit(-1)        /* fatal error (out of memory,etc) */
 #endif
+/* a program with its own uthash_malloc or uthash_free but no uthash_realloc
+ * has blocks resized by copying them between blocks of its own allocator */
+#if !defined(uthash_realloc) && (defined(uthash_malloc) || defined(uthash_free))
+#define HASH_REALLOC_COPY
+#endif
 #ifndef uthash_malloc
 #define uthash_malloc(sz) malloc(sz)      /* malloc fcn                      */
 #endif
 #ifndef uthash_free
 #define uthash_free(ptr,sz) free(ptr)     /* free fcn                        */
 #endif
+#ifndef uthash_realloc
+#define uthash_realloc(ptr,old_sz,sz) realloc(ptr,sz)  /* realloc fcn        */
+#endif
+/* out (a void*) = the block at ptr, of old_sz bytes, resized to sz bytes;
+ * the block at ptr is then no longer valid, unless out is NULL (no memory) */
+#ifdef HASH_REALLOC_COPY
+#define HASH_REALLOC(ptr,old_sz,sz,out)                                          \
+do {                                                                             \
+  if (((out) = uthash_malloc(sz)) != NULL) {                                     \
+    memcpy((out), (ptr), ((old_sz) < (sz)) ? (old_sz) : (sz));                   \
+    uthash_free(ptr, old_sz);                                                    \
+  }                                                                              \
+} while(0)
+#else
+#define HASH_REALLOC(ptr,old_sz,sz,out) ((out) = uthash_realloc(ptr,old_sz,sz))
+#endif
 
 #ifndef uthash_noexpand_fyi
 #define uthash_noexpand_fyi(tbl)          /* can be defined to log noexpand  */
@@ -82,78 +138,939 @@ typedef unsigned char uint8_t;
 #ifndef uthash_expand_fyi
 #define uthash_expand_fyi(tbl)            /* can be defined to log expands   */
 #endif
+#ifndef uthash_capacity_hint
+#define uthash_capacity_hint(head) 0      /* expected items, sizes new table */
+#endif
+#ifdef HASH_SEEDED
+#include <time.h>     /* time(),clock() */
+#ifndef uthash_seed
+#if defined(__linux__) && defined(__GLIBC__) &&                                  \
+    ((__GLIBC__ > 2) || ((__GLIBC__ == 2) && (__GLIBC_MINOR__ >= 25)))
+#include <sys/random.h>   /* getrandom() */
+#define HASH_ENTROPY_GETRANDOM
+#elif defined(__APPLE__) || defined(__FreeBSD__) || defined(__OpenBSD__) ||      \
+      defined(__NetBSD__) || defined(__DragonFly__)
+#define HASH_ENTROPY_ARC4RANDOM /* arc4random_buf(), in stdlib.h */
+#elif defined(__unix__)
+#include <fcntl.h>        /* open() */
+#include <unistd.h>       /* read(), close() */
+#define HASH_ENTROPY_URANDOM
+#endif
+#define uthash_seed(tbl) HASH_SEED_DEFAULT(tbl) /* 64-bit seed for a table   */
+#endif
+#ifndef uthash_reseed_fyi
+#define uthash_reseed_fyi(tbl)            /* can be defined to log reseeds   */
+#endif
+#endif
+#ifdef HASH_TABLE_ALLOC
+#ifndef uthash_table_alloc
+#define uthash_table_alloc(head) NULL     /* UT_hash_alloc of a new table    */
+#endif
+#endif
+#ifdef HASH_RCU
+#ifndef uthash_rcu_domain
+#define uthash_rcu_domain(head) NULL      /* UT_hash_rcu of the table's readers */
+#endif
+#ifndef uthash_rcu_wait
+#include <sched.h>    /* sched_yield() */
+#define uthash_rcu_wait() sched_yield()   /* while waiting out a grace period */
+#endif
+#endif
+#ifdef HASH_AUTO_FCN
+#ifndef uthash_fcn_clock
+#include <time.h>     /* clock() */
+#define uthash_fcn_clock() clock()        /* times candidate hash functions  */
+#ifndef HASH_FCN_TIME_TICKS               /* 100us, or 20 ticks if coarser   */
+#define HASH_FCN_TIME_TICKS                                                      \
+  ((CLOCKS_PER_SEC / 10000 > 20) ? (CLOCKS_PER_SEC / 10000) : 20)
+#endif
+#endif
+#ifndef HASH_FCN_TIME_TICKS
+#define HASH_FCN_TIME_TICKS 1000          /* ticks of a clock of your own    */
+#endif
+#ifndef uthash_fcn_fyi
+#define uthash_fcn_fyi(tbl)               /* can be defined to log the choice */
+#endif
+#endif
 
 /* initial number of buckets */
 #define HASH_INITIAL_NUM_BUCKETS 32      /* initial number of buckets        */
 #define HASH_INITIAL_NUM_BUCKETS_LOG2 5  /* lg2 of initial number of buckets */
 #define HASH_BKT_CAPACITY_THRESH 10      /* expand when bucket count reaches */
 
+/* log2 of the bucket count that holds n items at no more than one per
+ * bucket, and is no smaller than the initial bucket count */
+#define HASH_LOG2_FOR(n,log2)                                                    \
+do {                                                                             \
+  log2 = HASH_INITIAL_NUM_BUCKETS_LOG2;                                          \
+  while ((log2 < sizeof(UT_hash_size)*8-1) &&                                   \
+         (((UT_hash_size)1 << log2) < (UT_hash_size)(n))) log2++;                \
+} while(0)
+
 /* calculate the element whose hash handle address is hhe */
 #define ELMT_FROM_HH(tbl,hhp) ((void*)(((char*)(hhp)) - ((tbl)->hho)))
 
+/* A relocatable table (-DHASH_RELOCATABLE) holds no absolute addresses, so
+ * it can live in a shared memory region that each process maps at its own
+ * address. Every pointer the table keeps (the table of each handle, the
+ * bucket array, the head of each bucket, the tail and the Bloom filter) is
+ * instead a byte offset from uthash_reloc_base, which the program defines
+ * as the address of the region in the calling process; 0 stands for NULL.
+ * The links between handles are those of HASH_COMPACT (which this implies),
+ * counted from uthash_reloc_base too, and the key is an offset from its
+ * handle. The table, its buckets, items and keys must all lie in the region;
+ * typically uthash_malloc and uthash_free are defined to carve them from
+ * it. These fields are only accessed through the macros below (and the
+ * HASH_HH_ link accessors), which take and give plain pointers. */
+#ifdef HASH_RELOCATABLE
+#ifndef uthash_reloc_base
+#error "HASH_RELOCATABLE needs uthash_reloc_base, the address of the region"
+#endif
+#if defined(HASH_TABLE_FCN) || defined(HASH_TABLE_ALLOC) ||                      \
+    defined(HASH_HUGE_BUCKETS) || defined(HASH_INCREMENTAL) ||                   \
+    defined(HASH_FINGERPRINT) || defined(HASH_RCU)
+#error "HASH_RELOCATABLE cannot be combined with HASH_TABLE_FCN, HASH_TABLE_ALLOC, HASH_HUGE_BUCKETS, HASH_INCREMENTAL, HASH_FINGERPRINT or HASH_RCU"
+#endif
+#ifndef HASH_COMPACT
+#define HASH_COMPACT
+#endif
+#ifndef uthash_compact_base
+#define uthash_compact_base uthash_reloc_base
+#endif
+/* the offset of p in the region, and the pointer of type at offset off;
+ * HASH_REL_AT is HASH_REL_PTR for an offset known not to stand for NULL */
+#define HASH_REL_OFF(p)                                                          \
+  ((p) ? (ptrdiff_t)((char*)(p) - (char*)(uthash_reloc_base)) : (ptrdiff_t)0)
+#define HASH_REL_PTR(type,off)                                                   \
+  ((off) ? (type)((char*)(uthash_reloc_base) + (off)) : (type)NULL)
+#define HASH_REL_AT(type,off) ((type)((char*)(uthash_reloc_base) + (off)))
+#define HASH_HH_TBL(hhp) HASH_REL_PTR(UT_hash_table*, (hhp)->tbl)
+#define HASH_HH_SET_TBL(hhp,t) ((hhp)->tbl = HASH_REL_OFF(t))
+#define HASH_TBL_BUCKETS(tbl) HASH_REL_AT(UT_hash_bucket*, (tbl)->buckets)
+#define HASH_TBL_SET_BUCKETS(tbl,b) ((tbl)->buckets = HASH_REL_OFF(b))
+#define HASH_TBL_TAIL(tbl) HASH_REL_PTR(UT_hash_handle*, (tbl)->tail)
+#define HASH_TBL_SET_TAIL(tbl,hhp) ((tbl)->tail = HASH_REL_OFF(hhp))
+#define HASH_TBL_BLOOM_BV(tbl) HASH_REL_AT(uint8_t*, (tbl)->bloom_bv)
+#define HASH_TBL_SET_BLOOM_BV(tbl,bv) ((tbl)->bloom_bv = HASH_REL_OFF(bv))
+#define HASH_BKT_HEAD(bktp) HASH_REL_PTR(UT_hash_handle*, (bktp)->hh_head)
+#define HASH_BKT_SET_HEAD(bktp,hhp) ((bktp)->hh_head = HASH_REL_OFF(hhp))
+#else
+#define HASH_HH_TBL(hhp) ((hhp)->tbl)
+#define HASH_HH_SET_TBL(hhp,t) ((hhp)->tbl = (t))
+#define HASH_TBL_BUCKETS(tbl) ((tbl)->buckets)
+#define HASH_TBL_SET_BUCKETS(tbl,b) HASH_RCU_STORE((tbl)->buckets, b)
+#define HASH_TBL_TAIL(tbl) ((tbl)->tail)
+#define HASH_TBL_SET_TAIL(tbl,hhp) ((tbl)->tail = (hhp))
+#define HASH_TBL_BLOOM_BV(tbl) ((tbl)->bloom_bv)
+#define HASH_TBL_SET_BLOOM_BV(tbl,bv) ((tbl)->bloom_bv = (bv))
+#define HASH_BKT_HEAD(bktp) HASH_RCU_LOAD((bktp)->hh_head)
+#define HASH_BKT_SET_HEAD(bktp,hhp) HASH_RCU_STORE((bktp)->hh_head, hhp)
+#endif
+/* the table of the hash whose handle field in element head is hh */
+#define HASH_TBL(hh,head) HASH_HH_TBL(&(head)->hh)
+
+/* With -DHASH_RCU, HASH_FIND needs no lock: any number of threads may look
+ * up keys while a single writer (or writers serialized by a lock of their
+ * own) adds and deletes. Each reader takes a slot of a UT_hash_rcu domain,
+ * and brackets its lookups, and its use of the items they return, with
+ * HASH_RCU_READ_LOCK and HASH_RCU_READ_UNLOCK. These only write to the
+ * reader's own cache line. The writer publishes every pointer that readers
+ * follow (the head, bucket array, bucket heads and chain links) with a
+ * release store, after the thing it points to is complete, and readers load
+ * them with acquire loads. A lookup takes the bucket count from in front
+ * of the bucket array it loaded (see HASH_BKT_ALLOC). A bucket array
+ * replaced by a resize, or the table freed by the last delete, is released
+ * only after a grace period:
+ * HASH_RCU_SYNCHRONIZE advances the domain epoch and waits until no reader
+ * is still inside a section that it entered under an earlier epoch.
+ * While the items are being redistributed, a lookup may miss a key that is
+ * present; the table carries a sequence count, odd while a redistribution
+ * is under way, and a lookup that misses retries if it has changed. Items
+ * the application deletes must likewise only be freed or reused after a
+ * HASH_RCU_SYNCHRONIZE. Readers may only use HASH_FIND (and its convenience
+ * forms); iteration and the other macros still need the writer excluded. */
+#ifdef HASH_RCU
+#if defined(HASH_INCREMENTAL) || defined(HASH_COMPACT) || defined(HASH_FINGERPRINT)
+#error "HASH_RCU cannot be combined with HASH_INCREMENTAL, HASH_COMPACT or HASH_FINGERPRINT"
+#endif
+#ifndef HASH_RCU_READERS
+#define HASH_RCU_READERS 64      /* reader slots in a UT_hash_rcu domain   */
+#endif
+#ifndef HASH_RCU_LINE
+#define HASH_RCU_LINE 64         /* cache line size, to pad reader slots   */
+#endif
+#define HASH_RCU_LOAD(p) __atomic_load_n(&(p), __ATOMIC_ACQUIRE)
+#define HASH_RCU_STORE(p,v) __atomic_store_n(&(p), (v), __ATOMIC_RELEASE)
+#define HASH_RCU_ASSIGN(dst,src)                                                 \
+  __atomic_store_n(&(dst), DECLTYPE(dst)(src), __ATOMIC_RELEASE)
+#define HASH_RCU_INIT(tbl,head) ((tbl)->rcu = uthash_rcu_domain(head))
+
+/* reader is the slot, below HASH_RCU_READERS, that the calling thread owns */
+#define HASH_RCU_READ_LOCK(rcu,reader)                                           \
+do {                                                                             \
+  __atomic_store_n(&(rcu)->readers[reader].epoch,                                \
+                   __atomic_load_n(&(rcu)->epoch, __ATOMIC_RELAXED) + 1,         \
+                   __ATOMIC_RELAXED);                                            \
+  __atomic_thread_fence(__ATOMIC_SEQ_CST);                                       \
+} while(0)
+#define HASH_RCU_READ_UNLOCK(rcu,reader)                                         \
+  __atomic_store_n(&(rcu)->readers[reader].epoch, 0UL, __ATOMIC_RELEASE)
+#define HASH_RCU_SYNCHRONIZE(rcu)                                                \
+do {                                                                             \
+  unsigned _hrs_i;                                                               \
+  unsigned long _hrs_e, _hrs_r;                                                  \
+  _hrs_e = __atomic_add_fetch(&(rcu)->epoch, 1UL, __ATOMIC_SEQ_CST);             \
+  __atomic_thread_fence(__ATOMIC_SEQ_CST);                                       \
+  for(_hrs_i = 0; _hrs_i < HASH_RCU_READERS; _hrs_i++) {                         \
+    while (((_hrs_r = __atomic_load_n(&(rcu)->readers[_hrs_i].epoch,             \
+                                      __ATOMIC_ACQUIRE)) != 0) &&                \
+           (_hrs_r <= _hrs_e)) {                                                 \
+      uthash_rcu_wait();                                                         \
+    }                                                                            \
+  }                                                                              \
+} while(0)
+#define HASH_RCU_SYNC(tbl)                                                       \
+do {                                                                             \
+  if ((tbl)->rcu) { HASH_RCU_SYNCHRONIZE((tbl)->rcu); }                          \
+} while(0)
+#define HASH_RETIRE_BUCKETS(tbl,ptr,n)                                           \
+do {                                                                             \
+  HASH_RCU_SYNC(tbl);                                                            \
+  HASH_BKT_FREE(tbl,ptr,n);                                                      \
+} while(0)
+
+/* the writer brackets each redistribution with HASH_RCU_SEQ_BEGIN/END; a
+ * lookup notes the count with HASH_RCU_SEQ_READ before it starts */
+#define HASH_RCU_SEQ_BEGIN(tbl)                                                  \
+do {                                                                             \
+  __atomic_store_n(&(tbl)->rcu_seq, (tbl)->rcu_seq + 1, __ATOMIC_RELAXED);       \
+  __atomic_thread_fence(__ATOMIC_RELEASE);                                       \
+} while(0)
+#define HASH_RCU_SEQ_END(tbl)                                                    \
+  __atomic_store_n(&(tbl)->rcu_seq, (tbl)->rcu_seq + 1, __ATOMIC_RELEASE)
+#define HASH_RCU_SEQ_READ(tbl) __atomic_load_n(&(tbl)->rcu_seq, __ATOMIC_ACQUIRE)
+#define HASH_RCU_SEQ_RETRY(tbl,seq)                                              \
+  (__atomic_thread_fence(__ATOMIC_ACQUIRE), (((seq) & 1) ||                      \
+   (__atomic_load_n(&(tbl)->rcu_seq, __ATOMIC_RELAXED) != (seq))))
+#else
+#define HASH_RCU_LOAD(p) (p)
+#define HASH_RCU_STORE(p,v) ((p) = (v))
+#define HASH_RCU_ASSIGN(dst,src) DECLTYPE_ASSIGN(dst,src)
+#define HASH_RCU_INIT(tbl,head)
+#define HASH_RCU_SYNC(tbl)
+#define HASH_RETIRE_BUCKETS(tbl,ptr,n) HASH_BKT_FREE(tbl,ptr,n)
+#define HASH_RCU_SEQ_BEGIN(tbl)
+#define HASH_RCU_SEQ_END(tbl)
+#endif
+
+/* With -DHASH_TABLE_ALLOC each table can have an allocator of its own, set
+ * when the table is made by the uthash_table_alloc(head) hook, for instance
+ * an arena that dies with a request or a pool local to a thread. The table,
+ * its buckets and its Bloom filter all come from it. Callbacks get the
+ * allocator's ctx, and the size of any block they free; realloc_fcn may be
+ * NULL, in which case a block is moved by alloc_fcn, memcpy and free_fcn.
+ * A table whose hook gives NULL uses uthash_malloc and uthash_free. Scratch
+ * memory that does not outlive a call, such as that of HASH_SRT, does not
+ * come from the table's allocator. */
+#ifdef HASH_TABLE_ALLOC
+typedef struct UT_hash_alloc {
+  void *(*alloc_fcn)(void *ctx, size_t sz);
+  void (*free_fcn)(void *ctx, void *ptr, size_t sz);
+  void *(*realloc_fcn)(void *ctx, void *ptr, size_t old_sz, size_t sz);
+  void *ctx;
+} UT_hash_alloc;
+#define HASH_ALLOC_MALLOC(a,sz)                                                  \
+  ((a) ? (a)->alloc_fcn((a)->ctx, (sz)) : uthash_malloc(sz))
+#define HASH_MAKE_ALLOC_DECL(a,head)                                             \
+  UT_hash_alloc *a = (UT_hash_alloc*)(uthash_table_alloc(head))
+#define HASH_ALLOC_INIT(tbl,a) ((tbl)->alloc = (a))
+#define HASH_TBL_MALLOC(tbl,sz) HASH_ALLOC_MALLOC((tbl)->alloc, sz)
+#define HASH_TBL_FREE(tbl,ptr,sz)                                                \
+do {                                                                             \
+  if ((tbl)->alloc) { (tbl)->alloc->free_fcn((tbl)->alloc->ctx, (ptr), (sz)); } \
+  else { uthash_free(ptr,sz); }                                                  \
+} while(0)
+/* as HASH_REALLOC, through the table's allocator */
+#define HASH_TBL_REALLOC(tbl,ptr,old_sz,sz,out)                                  \
+do {                                                                             \
+  UT_hash_alloc *_htr_a = (tbl)->alloc;                                          \
+  if (!_htr_a) {                                                                 \
+    HASH_REALLOC(ptr, old_sz, sz, out);                                          \
+  } else if (_htr_a->realloc_fcn) {                                              \
+    (out) = _htr_a->realloc_fcn(_htr_a->ctx, (ptr), (old_sz), (sz));             \
+  } else if (((out) = _htr_a->alloc_fcn(_htr_a->ctx, (sz))) != NULL) {           \
+    memcpy((out), (ptr), ((old_sz) < (sz)) ? (old_sz) : (sz));                   \
+    _htr_a->free_fcn(_htr_a->ctx, (ptr), (old_sz));                              \
+  }                                                                              \
+} while(0)
+#else
+#define HASH_MAKE_ALLOC_DECL(a,head)
+#define HASH_ALLOC_MALLOC(a,sz) uthash_malloc(sz)
+#define HASH_ALLOC_INIT(tbl,a)
+#define HASH_TBL_MALLOC(tbl,sz) uthash_malloc(sz)
+#define HASH_TBL_FREE(tbl,ptr,sz) uthash_free(ptr,sz)
+#define HASH_TBL_REALLOC(tbl,ptr,old_sz,sz,out) HASH_REALLOC(ptr,old_sz,sz,out)
+#endif
+
+/* Bucket arrays of HASH_HUGE_MIN bytes or more (-DHASH_HUGE_BUCKETS) are not
+ * allocated but mapped anonymously, aligned to HASH_HUGE_PAGE and advised to
+ * use transparent huge pages, so that the random bucket accesses of a large
+ * table miss the TLB less. With -DHASH_HUGE_TLB, explicit huge pages
+ * (MAP_HUGETLB) are tried first. A mapping comes zeroed, so it's not
+ * memset, and it is freed with munmap. Smaller arrays come from the table's
+ * allocator as usual. */
+#ifdef HASH_HUGE_BUCKETS
+#include <sys/mman.h>   /* mmap, madvise, munmap */
+#ifndef HASH_HUGE_MIN
+#define HASH_HUGE_MIN (2UL*1024*1024) /* smallest bucket array that's mapped */
+#endif
+#ifndef HASH_HUGE_PAGE
+#define HASH_HUGE_PAGE (2UL*1024*1024) /* huge page size                     */
+#endif
+#if !defined(MAP_ANONYMOUS) && defined(MAP_ANON)
+#define MAP_ANONYMOUS MAP_ANON
+#endif
+#ifndef MAP_ANONYMOUS
+#error "HASH_HUGE_BUCKETS needs MAP_ANONYMOUS (try -D_DEFAULT_SOURCE)"
+#endif
+#define HASH_HUGE_LEN(sz) (((sz) + HASH_HUGE_PAGE - 1) & ~(HASH_HUGE_PAGE - 1))
+
+static HASH_INLINE void *uthash_huge_alloc(size_t sz) {
+  size_t len = HASH_HUGE_LEN(sz), lead;
+  char *p;
+#if defined(HASH_HUGE_TLB) && defined(MAP_HUGETLB)
+  p = (char*)mmap(NULL, len, PROT_READ|PROT_WRITE,
+                  MAP_PRIVATE|MAP_ANONYMOUS|MAP_HUGETLB, -1, 0);
+  if (p != (char*)MAP_FAILED) return p;
+#endif
+  /* over-map by a page, then trim both ends to align the region */
+  p = (char*)mmap(NULL, len + HASH_HUGE_PAGE, PROT_READ|PROT_WRITE,
+                  MAP_PRIVATE|MAP_ANONYMOUS, -1, 0);
+  if (p == (char*)MAP_FAILED) return NULL;
+  lead = (HASH_HUGE_PAGE - ((size_t)p & (HASH_HUGE_PAGE - 1))) &
+         (HASH_HUGE_PAGE - 1);
+  if (lead) munmap(p, lead);
+  munmap(p + lead + len, HASH_HUGE_PAGE - lead);
+  p += lead;
+#ifdef MADV_HUGEPAGE
+  madvise(p, len, MADV_HUGEPAGE);
+#endif
+  return p;
+}
+
+/* grow a mapped array of old_sz bytes to sz bytes; the new tail is zero */
+static HASH_INLINE void *uthash_huge_realloc(void *ptr, size_t old_sz,
+                                             size_t sz) {
+  void *p;
+#if defined(MREMAP_MAYMOVE) && !defined(HASH_HUGE_TLB)
+  p = mremap(ptr, HASH_HUGE_LEN(old_sz), HASH_HUGE_LEN(sz), MREMAP_MAYMOVE);
+  if (p == MAP_FAILED) return NULL;
+#ifdef MADV_HUGEPAGE
+  madvise(p, HASH_HUGE_LEN(sz), MADV_HUGEPAGE);
+#endif
+#else
+  if ((p = uthash_huge_alloc(sz)) == NULL) return NULL;
+  memcpy(p, ptr, old_sz);
+  munmap(ptr, HASH_HUGE_LEN(old_sz));
+#endif
+  return p;
+}
+
+#define HASH_BKT_ARRAY_ALLOC(tbl,n,out)                                          \
+do {                                                                             \
+  size_t _hba_sz = (size_t)(n) * sizeof(struct UT_hash_bucket);                  \
+  if (_hba_sz >= HASH_HUGE_MIN) {                                                \
+    (out) = (UT_hash_bucket*)uthash_huge_alloc(_hba_sz);                         \
+    if (!(out)) { uthash_fatal( "out of memory"); }                              \
+  } else {                                                                       \
+    (out) = (UT_hash_bucket*)HASH_TBL_MALLOC(tbl, _hba_sz);                      \
+    if (!(out)) { uthash_fatal( "out of memory"); }                              \
+    memset((out), 0, _hba_sz);                                                   \
+  }                                                                              \
+} while(0)
+#define HASH_BKT_ARRAY_FREE(tbl,ptr,n)                                           \
+do {                                                                             \
+  size_t _hbf_sz = (size_t)(n) * sizeof(struct UT_hash_bucket);                  \
+  if (_hbf_sz >= HASH_HUGE_MIN) {                                                \
+    munmap((void*)(ptr), HASH_HUGE_LEN(_hbf_sz));                                \
+  } else {                                                                       \
+    HASH_TBL_FREE(tbl, ptr, _hbf_sz);                                            \
+  }                                                                              \
+} while(0)
+/* out = the array of old_n buckets at ptr grown to n buckets, the new ones
+ * zeroed; ptr is no longer valid afterwards */
+#define HASH_BKT_REALLOC(tbl,ptr,old_n,n,out)                                    \
+do {                                                                             \
+  size_t _hbr_old = (size_t)(old_n) * sizeof(struct UT_hash_bucket);             \
+  size_t _hbr_sz = (size_t)(n) * sizeof(struct UT_hash_bucket);                  \
+  void *_hbr_p;                                                                  \
+  if (_hbr_sz < HASH_HUGE_MIN) {                                                 \
+    HASH_TBL_REALLOC(tbl, ptr, _hbr_old, _hbr_sz, _hbr_p);                       \
+    if (!_hbr_p) { uthash_fatal( "out of memory"); }                             \
+    memset((char*)_hbr_p + _hbr_old, 0, _hbr_sz - _hbr_old);                     \
+  } else if (_hbr_old < HASH_HUGE_MIN) {                                         \
+    _hbr_p = uthash_huge_alloc(_hbr_sz);                                         \
+    if (!_hbr_p) { uthash_fatal( "out of memory"); }                             \
+    memcpy(_hbr_p, (ptr), _hbr_old);                                             \
+    HASH_TBL_FREE(tbl, ptr, _hbr_old);                                           \
+  } else {                                                                       \
+    _hbr_p = uthash_huge_realloc((ptr), _hbr_old, _hbr_sz);                      \
+    if (!_hbr_p) { uthash_fatal( "out of memory"); }                             \
+  }                                                                              \
+  (out) = (UT_hash_bucket*)_hbr_p;                                               \
+} while(0)
+/* nonzero if an array of n buckets is mapped */
+#define HASH_BKT_ARRAY_HUGE(n)                                                   \
+  ((size_t)(n) * sizeof(struct UT_hash_bucket) >= HASH_HUGE_MIN)
+#else
+/* out = a zeroed array of n buckets, from the table's allocator */
+#define HASH_BKT_ARRAY_ALLOC(tbl,n,out)                                          \
+do {                                                                             \
+  (out) = (UT_hash_bucket*)HASH_TBL_MALLOC(tbl,                                  \
+                                (n) * sizeof(struct UT_hash_bucket));            \
+  if (!(out)) { uthash_fatal( "out of memory"); }                                \
+  memset((out), 0, (n) * sizeof(struct UT_hash_bucket));                         \
+} while(0)
+#define HASH_BKT_ARRAY_FREE(tbl,ptr,n)                                           \
+  HASH_TBL_FREE(tbl, ptr, (n) * sizeof(struct UT_hash_bucket))
+/* out = the array of old_n buckets at ptr grown to n buckets, the new ones
+ * zeroed; ptr is no longer valid afterwards */
+#define HASH_BKT_REALLOC(tbl,ptr,old_n,n,out)                                    \
+do {                                                                             \
+  size_t _hbr_old = (size_t)(old_n) * sizeof(struct UT_hash_bucket);             \
+  size_t _hbr_sz = (size_t)(n) * sizeof(struct UT_hash_bucket);                  \
+  void *_hbr_p;                                                                  \
+  HASH_TBL_REALLOC(tbl, ptr, _hbr_old, _hbr_sz, _hbr_p);                         \
+  if (!_hbr_p) { uthash_fatal( "out of memory"); }                               \
+  memset((char*)_hbr_p + _hbr_old, 0, _hbr_sz - _hbr_old);                       \
+  (out) = (UT_hash_bucket*)_hbr_p;                                               \
+} while(0)
+#define HASH_BKT_ARRAY_HUGE(n) 0
+#endif
+
+/* With HASH_RCU a bucket array is preceded by one more bucket, whose count
+ * holds the number of buckets in the array. A lookup takes the size from
+ * the array it loaded, never from the table, so that the size and the array
+ * it indexes were always published together, however the table has been
+ * resized in between. */
+#ifdef HASH_RCU
+#define HASH_BKT_ALLOC(tbl,n,out)                                                \
+do {                                                                             \
+  UT_hash_bucket *_hba_arr;                                                      \
+  HASH_BKT_ARRAY_ALLOC(tbl, (n) + 1, _hba_arr);                                  \
+  _hba_arr[0].count = (UT_hash_size)(n);                                         \
+  (out) = _hba_arr + 1;                                                          \
+} while(0)
+#define HASH_BKT_FREE(tbl,ptr,n) HASH_BKT_ARRAY_FREE(tbl, (ptr) - 1, (n) + 1)
+#define HASH_BKT_HUGE(n) HASH_BKT_ARRAY_HUGE((n) + 1)
+#define HASH_BKT_ARRAY_LEN(bkts) ((bkts)[-1].count)
+#else
+#define HASH_BKT_ALLOC(tbl,n,out) HASH_BKT_ARRAY_ALLOC(tbl,n,out)
+#define HASH_BKT_FREE(tbl,ptr,n) HASH_BKT_ARRAY_FREE(tbl,ptr,n)
+#define HASH_BKT_HUGE(n) HASH_BKT_ARRAY_HUGE(n)
+#endif
+
+/* The links between hash handles are only read and written through these
+ * accessors, which deal in handle pointers (NULL at either end):
+ *   HASH_HH_NEXT/HASH_HH_PREV          app order
+ *   HASH_HH_CHAIN_NEXT                 bucket order
+ *   HASH_HH_KEY                        the key
+ * and their HASH_HH_SET_ counterparts. HASH_HH_LINK_CHAIN_PREV sets the
+ * back links around a handle just put at the head of its bucket chain.
+ *
+ * By default the handle holds plain pointers. With -DHASH_COMPACT each link
+ * is instead a 32-bit signed offset, counted in units of HASH_COMPACT_UNIT
+ * bytes from uthash_compact_base, and the key is a 32-bit byte offset from
+ * the handle itself. The program defines uthash_compact_base as the start
+ * of the region its items are allocated from (an arena, or an array of
+ * them), so that the offsets are in range by construction rather than by
+ * where the allocator happens to place the items: every item must lie in
+ * the first 2^31 units of the region (16 gigabytes with the default unit),
+ * and uthash_fatal is called if one does not. Bucket chains lose their back
+ * links, so a delete walks its chain to find the predecessor. This shrinks
+ * the handle from 56 to 32 bytes on 64-bit hosts. Application code must not
+ * read hh.next or hh.prev directly in this mode; HASH_ITER, HASH_NEXT and
+ * HASH_PREV work in both. */
+#ifdef HASH_COMPACT
+#ifndef uthash_compact_base
+#error "HASH_COMPACT needs uthash_compact_base, the address of the region holding the items"
+#endif
+#ifndef HASH_COMPACT_UNIT
+#define HASH_COMPACT_UNIT sizeof(void*)   /* the alignment of a hash handle */
+#endif
+#define HASH_CPT_NIL ((int32_t)(-2147483647-1))
+#define HASH_CPT_HH(tbl,off)                                                     \
+  (((off) == HASH_CPT_NIL) ? NULL :                                              \
+   (UT_hash_handle*)(HASH_CPT_BASE(tbl) + (ptrdiff_t)(off) * HASH_COMPACT_UNIT))
+#define HASH_CPT_SET(tbl,field,nhh)                                              \
+do {                                                                             \
+  UT_hash_handle *_hc_nhh = (nhh);                                               \
+  ptrdiff_t _hc_d;                                                               \
+  if (_hc_nhh) {                                                                 \
+    _hc_d = (char*)_hc_nhh - HASH_CPT_BASE(tbl);                                 \
+    if ((_hc_d % (ptrdiff_t)HASH_COMPACT_UNIT) ||                                \
+        (_hc_d < 0) ||                                                           \
+        (_hc_d / (ptrdiff_t)HASH_COMPACT_UNIT > 2147483647)) {                   \
+      uthash_fatal( "item outside the compact region");                          \
+    }                                                                            \
+    field = (int32_t)(_hc_d / (ptrdiff_t)HASH_COMPACT_UNIT);                     \
+  } else {                                                                       \
+    field = HASH_CPT_NIL;                                                        \
+  }                                                                              \
+} while(0)
+#define HASH_HH_NEXT(tbl,hhp) HASH_CPT_HH(tbl,(hhp)->next)
+#define HASH_HH_PREV(tbl,hhp) HASH_CPT_HH(tbl,(hhp)->prev)
+#define HASH_HH_CHAIN_NEXT(tbl,hhp) HASH_CPT_HH(tbl,(hhp)->hh_next)
+#define HASH_HH_SET_NEXT(tbl,hhp,nhh) HASH_CPT_SET(tbl,(hhp)->next,nhh)
+#define HASH_HH_SET_PREV(tbl,hhp,nhh) HASH_CPT_SET(tbl,(hhp)->prev,nhh)
+#define HASH_HH_SET_CHAIN_NEXT(tbl,hhp,nhh) HASH_CPT_SET(tbl,(hhp)->hh_next,nhh)
+#define HASH_HH_LINK_CHAIN_PREV(hhp)
+#define HASH_HH_KEY(hhp) ((void*)((char*)(hhp) + (hhp)->key))
+#define HASH_HH_SET_KEY(hhp,keyptr)                                              \
+do {                                                                             \
+  ptrdiff_t _hc_k = (char*)(keyptr) - (char*)(hhp);                              \
+  if ((_hc_k < -2147483647) || (_hc_k > 2147483647)) {                           \
+    uthash_fatal( "key out of compact handle range");                            \
+  }                                                                              \
+  (hhp)->key = (int32_t)_hc_k;                                                   \
+} while(0)
+#ifdef HASH_RELOCATABLE
+#define HASH_CPT_BASE(tbl) ((char*)(uthash_compact_base))
+#define HASH_HH_BASE(tbl)
+#else
+/* a table whose handle is not at a multiple of the unit within its items
+ * counts from as far into the region */
+#define HASH_CPT_BASE(tbl) ((tbl)->hh_base)
+#define HASH_HH_BASE(tbl)                                                        \
+  ((tbl)->hh_base = (char*)(uthash_compact_base) +                               \
+                    (tbl)->hho % (ptrdiff_t)HASH_COMPACT_UNIT)
+#endif
+#define HASH_NEXT(hh,el)                                                         \
+  (((el)->hh.next == HASH_CPT_NIL) ? NULL :                                      \
+   ELMT_FROM_HH(HASH_TBL(hh,el), HASH_CPT_HH(HASH_TBL(hh,el),(el)->hh.next)))
+#define HASH_PREV(hh,el)                                                         \
+  (((el)->hh.prev == HASH_CPT_NIL) ? NULL :                                      \
+   ELMT_FROM_HH(HASH_TBL(hh,el), HASH_CPT_HH(HASH_TBL(hh,el),(el)->hh.prev)))
+#else
+#define HASH_HH_NEXT(tbl,hhp)                                                    \
+  ((hhp)->next ? (UT_hash_handle*)((char*)((hhp)->next) + (tbl)->hho) : NULL)
+#define HASH_HH_PREV(tbl,hhp)                                                    \
+  ((hhp)->prev ? (UT_hash_handle*)((char*)((hhp)->prev) + (tbl)->hho) : NULL)
+#define HASH_HH_CHAIN_NEXT(tbl,hhp) HASH_RCU_LOAD((hhp)->hh_next)
+#define HASH_HH_SET_NEXT(tbl,hhp,nhh)                                            \
+do {                                                                             \
+  UT_hash_handle *_hc_nhh = (nhh);                                               \
+  (hhp)->next = _hc_nhh ? ELMT_FROM_HH(tbl,_hc_nhh) : NULL;                      \
+} while(0)
+#define HASH_HH_SET_PREV(tbl,hhp,nhh)                                            \
+do {                                                                             \
+  UT_hash_handle *_hc_nhh = (nhh);                                               \
+  (hhp)->prev = _hc_nhh ? ELMT_FROM_HH(tbl,_hc_nhh) : NULL;                      \
+} while(0)
+#define HASH_HH_SET_CHAIN_NEXT(tbl,hhp,nhh) HASH_RCU_STORE((hhp)->hh_next,nhh)
+#define HASH_HH_LINK_CHAIN_PREV(hhp)                                             \
+do {                                                                             \
+  (hhp)->hh_prev = NULL;                                                         \
+  if ((hhp)->hh_next) { (hhp)->hh_next->hh_prev = (hhp); }                       \
+} while(0)
+#define HASH_HH_KEY(hhp) ((hhp)->key)
+#define HASH_HH_SET_KEY(hhp,keyptr) ((hhp)->key = (char*)(keyptr))
+#define HASH_HH_BASE(tbl)
+#define HASH_NEXT(hh,el) ((el)->hh.next)
+#define HASH_PREV(hh,el) ((el)->hh.prev)
+#endif
+
+#ifndef HASH_RCU
 #define HASH_FIND(hh,head,keyptr,keylen,out)                                     \
 do {                                                                             \
-  unsigned _hf_bkt,_hf_hashv;                                                    \
+  UT_hash_size _hf_bkt;                                                          \
+  UT_hash_value _hf_hashv;                                                       \
+  out=NULL;                                                                      \
+  if (head) {                                                                    \
+     HASH_FCN_TBL(HASH_TBL(hh,head), keyptr,keylen,                              \
+                  HASH_TBL(hh,head)->num_buckets,                                \
+                  _hf_hashv, _hf_bkt);                                           \
+     if (HASH_BLOOM_TEST(HASH_TBL(hh,head), _hf_hashv)) {                        \
+       HASH_FIND_IN_BKT(HASH_TBL(hh,head), hh,                                   \
+                        HASH_BKT(HASH_TBL(hh,head), _hf_hashv, _hf_bkt),         \
+                        keyptr,keylen,_hf_hashv,out);                            \
+     }                                                                           \
+  }                                                                              \
+} while (0)
+#define HASH_FIND_BYHASHVALUE(hh,head,keyptr,keylen,hashval,out)                 \
+do {                                                                             \
+  UT_hash_size _hf_bkt;                                                          \
   out=NULL;                                                                      \
   if (head) {                                                                    \
-     HASH_FCN(keyptr,keylen, (head)->hh.tbl->num_buckets, _hf_hashv, _hf_bkt);   \
-     if (HASH_BLOOM_TEST((head)->hh.tbl, _hf_hashv)) {                           \
-       HASH_FIND_IN_BKT((head)->hh.tbl, hh, (head)->hh.tbl->buckets[ _hf_bkt ],  \
-                        keyptr,keylen,out);                                      \
+     HASH_TO_BKT(hashval, HASH_TBL(hh,head)->num_buckets, _hf_bkt);              \
+     if (HASH_BLOOM_TEST(HASH_TBL(hh,head), (hashval))) {                        \
+       HASH_FIND_IN_BKT(HASH_TBL(hh,head), hh,                                   \
+                        HASH_BKT(HASH_TBL(hh,head), (hashval), _hf_bkt),         \
+                        keyptr,keylen,(hashval),out);                            \
      }                                                                           \
   }                                                                              \
 } while (0)
+#else
+/* the lock-free lookup: the bucket index comes from the size recorded in
+ * front of the bucket array loaded (HASH_BKT_ARRAY_LEN), so it is always
+ * within that array */
+#define HASH_FIND(hh,head,keyptr,keylen,out)                                     \
+do {                                                                             \
+  UT_hash_size _hf_bkt;                                                          \
+  UT_hash_value _hf_hashv;                                                       \
+  unsigned long _hf_seq;                                                         \
+  UT_hash_table *_hf_tbl;                                                        \
+  UT_hash_bucket *_hf_bkts;                                                      \
+  __typeof(head) _hf_head = HASH_RCU_LOAD(head);                                 \
+  out=NULL;                                                                      \
+  if (_hf_head) {                                                                \
+    _hf_tbl = HASH_TBL(hh,_hf_head);                                             \
+    do {                                                                         \
+      _hf_seq = HASH_RCU_SEQ_READ(_hf_tbl);                                      \
+      _hf_bkts = HASH_RCU_LOAD(_hf_tbl->buckets);                                \
+      HASH_FCN_TBL(_hf_tbl, keyptr,keylen, HASH_BKT_ARRAY_LEN(_hf_bkts),         \
+                   _hf_hashv, _hf_bkt);                                          \
+      if (HASH_BLOOM_TEST(_hf_tbl, _hf_hashv)) {                                 \
+        HASH_FIND_IN_BKT(_hf_tbl, hh, _hf_bkts[_hf_bkt],                         \
+                         keyptr,keylen,_hf_hashv,out);                           \
+      }                                                                          \
+    } while (!(out) && HASH_RCU_SEQ_RETRY(_hf_tbl, _hf_seq));                    \
+  }                                                                              \
+} while (0)
+#define HASH_FIND_BYHASHVALUE(hh,head,keyptr,keylen,hashval,out)                 \
+do {                                                                             \
+  UT_hash_size _hf_bkt;                                                          \
+  unsigned long _hf_seq;                                                         \
+  UT_hash_table *_hf_tbl;                                                        \
+  UT_hash_bucket *_hf_bkts;                                                      \
+  __typeof(head) _hf_head = HASH_RCU_LOAD(head);                                 \
+  out=NULL;                                                                      \
+  if (_hf_head) {                                                                \
+    _hf_tbl = HASH_TBL(hh,_hf_head);                                             \
+    do {                                                                         \
+      _hf_seq = HASH_RCU_SEQ_READ(_hf_tbl);                                      \
+      _hf_bkts = HASH_RCU_LOAD(_hf_tbl->buckets);                                \
+      HASH_TO_BKT(hashval, HASH_BKT_ARRAY_LEN(_hf_bkts), _hf_bkt);               \
+      if (HASH_BLOOM_TEST(_hf_tbl, (hashval))) {                                 \
+        HASH_FIND_IN_BKT(_hf_tbl, hh, _hf_bkts[_hf_bkt],                         \
+                         keyptr,keylen,(hashval),out);                           \
+      }                                                                          \
+    } while (!(out) && HASH_RCU_SEQ_RETRY(_hf_tbl, _hf_seq));                    \
+  }                                                                              \
+} while (0)
+#endif
+
+/* HASH_VALUE sets hashv to the hash value of a key in the table head, as
+ * HASH_FIND computes it there: under the table's own seed (-DHASH_SEEDED)
+ * and hash function (-DHASH_TABLE_FCN). It can be passed to
+ * HASH_FIND_BYHASHVALUE and HASH_ADD_BYHASHVALUE on the same table, to hash
+ * a key only once for several operations. It stays valid until the table
+ * draws a new seed or changes its function. An empty table has neither yet,
+ * so the value is that of HASH_FCN; an add that makes the table hashes its
+ * key again (HASH_ADD_HASHV_FIRST). */
+#ifdef HASH_RCU
+#define HASH_HEAD_TBL(hh,head,tbl)                                               \
+do {                                                                             \
+  __typeof(head) _hht_head = HASH_RCU_LOAD(head);                                \
+  (tbl) = _hht_head ? HASH_TBL(hh,_hht_head) : NULL;                             \
+} while(0)
+#else
+#define HASH_HEAD_TBL(hh,head,tbl) ((tbl) = (head) ? HASH_TBL(hh,head) : NULL)
+#endif
+#define HASH_VALUE(hh,head,keyptr,keylen,hashv)                                  \
+do {                                                                             \
+  UT_hash_size _hvl_bkt;                                                         \
+  UT_hash_table *_hvl_tbl;                                                       \
+  HASH_HEAD_TBL(hh,head,_hvl_tbl);                                               \
+  if (_hvl_tbl) {                                                                \
+    HASH_FCN_TBL(_hvl_tbl,keyptr,keylen,(UT_hash_size)1,hashv,_hvl_bkt);         \
+  } else {                                                                       \
+    HASH_FCN(keyptr,keylen,(UT_hash_size)1,hashv,_hvl_bkt);                      \
+  }                                                                              \
+  (void)_hvl_bkt;                                                                \
+} while(0)
+
+/* HASH_PREFETCH asks the CPU to start loading the cache line at addr. */
+#ifndef HASH_PREFETCH
+#if defined(__GNUC__)
+#define HASH_PREFETCH(addr) __builtin_prefetch(addr)
+#else
+#define HASH_PREFETCH(addr)
+#endif
+#endif
+
+/* Look up n keys at once: keyptrs[i] of keylens[i] bytes, for i < n, with
+ * the result (or NULL) going to outs[i]. A single HASH_FIND waits on memory
+ * for the bucket, then for each item along the chain. Here the keys are
+ * taken in groups of HASH_BATCH_GROUP, and each stage is run over the whole
+ * group before the next: hash every key and prefetch its bucket; prefetch
+ * the first handle in each bucket; then, HASH_BATCH_DEPTH-1 times, step to
+ * the next handle of the chains whose current handle has the wrong hashv,
+ * and prefetch it; finally compare. The loads of a group thus overlap,
+ * instead of each one waiting for the last. */
+#ifndef HASH_BATCH_GROUP
+#define HASH_BATCH_GROUP 32      /* keys in flight at once                 */
+#endif
+#ifndef HASH_BATCH_DEPTH
+#define HASH_BATCH_DEPTH 2       /* handles prefetched along each chain    */
+#endif
+#define HASH_FIND_BATCH(hh,head,keyptrs,keylens,n,outs)                          \
+do {                                                                             \
+  size_t _hfb_base, _hfb_i, _hfb_m;                                              \
+  unsigned _hfb_d;                                                               \
+  UT_hash_size _hfb_bkt;                                                         \
+  UT_hash_value _hfb_hashv[HASH_BATCH_GROUP];                                    \
+  UT_hash_bucket *_hfb_bkts[HASH_BATCH_GROUP];                                   \
+  struct UT_hash_handle *_hfb_hh[HASH_BATCH_GROUP];                              \
+  for(_hfb_base = 0; _hfb_base < (size_t)(n); _hfb_base += HASH_BATCH_GROUP) {   \
+    _hfb_m = (size_t)(n) - _hfb_base;                                            \
+    if (_hfb_m > HASH_BATCH_GROUP) _hfb_m = HASH_BATCH_GROUP;                    \
+    for(_hfb_i = 0; _hfb_i < _hfb_m; _hfb_i++) {                                 \
+      (outs)[_hfb_base+_hfb_i] = NULL;                                           \
+    }                                                                            \
+    if (!(head)) continue;                                                       \
+    for(_hfb_i = 0; _hfb_i < _hfb_m; _hfb_i++) {                                 \
+      HASH_FCN_TBL(HASH_TBL(hh,head), (keyptrs)[_hfb_base+_hfb_i],               \
+                   (keylens)[_hfb_base+_hfb_i], HASH_TBL(hh,head)->num_buckets,  \
+                   _hfb_hashv[_hfb_i], _hfb_bkt);                                \
+      _hfb_bkts[_hfb_i] = &HASH_BKT(HASH_TBL(hh,head), _hfb_hashv[_hfb_i],       \
+                                    _hfb_bkt);                                   \
+      HASH_PREFETCH(_hfb_bkts[_hfb_i]);                                          \
+    }                                                                            \
+    for(_hfb_i = 0; _hfb_i < _hfb_m; _hfb_i++) {                                 \
+      _hfb_hh[_hfb_i] = HASH_BKT_HEAD(_hfb_bkts[_hfb_i]);                        \
+      if (_hfb_hh[_hfb_i]) HASH_PREFETCH(_hfb_hh[_hfb_i]);                       \
+    }                                                                            \
+    for(_hfb_d = 1; _hfb_d < HASH_BATCH_DEPTH; _hfb_d++) {                       \
+      for(_hfb_i = 0; _hfb_i < _hfb_m; _hfb_i++) {                               \
+        if (_hfb_hh[_hfb_i] && (_hfb_hh[_hfb_i]->hashv != _hfb_hashv[_hfb_i])) { \
+          _hfb_hh[_hfb_i] = HASH_HH_CHAIN_NEXT(HASH_TBL(hh,head),                \
+                                               _hfb_hh[_hfb_i]);                 \
+          if (_hfb_hh[_hfb_i]) HASH_PREFETCH(_hfb_hh[_hfb_i]);                   \
+        }                                                                        \
+      }                                                                          \
+    }                                                                            \
+    for(_hfb_i = 0; _hfb_i < _hfb_m; _hfb_i++) {                                 \
+      if (HASH_BLOOM_TEST(HASH_TBL(hh,head), _hfb_hashv[_hfb_i])) {              \
+        HASH_FIND_IN_BKT(HASH_TBL(hh,head), hh, *_hfb_bkts[_hfb_i],              \
+                         (keyptrs)[_hfb_base+_hfb_i],                            \
+                         (keylens)[_hfb_base+_hfb_i], _hfb_hashv[_hfb_i],        \
+                         (outs)[_hfb_base+_hfb_i]);                              \
+      }                                                                          \
+    }                                                                            \
+  }                                                                              \
+} while (0)
 
 #ifdef HASH_BLOOM
+#if defined(HASH_BLOOM_BLOCKED) && defined(HASH_BLOOM_COUNTING)
+#error "HASH_BLOOM_COUNTING cannot be combined with HASH_BLOOM_BLOCKED"
+#endif
+#if defined(HASH_BLOOM_GROW) && defined(HASH_RCU)
+#error "HASH_BLOOM_GROW cannot be combined with HASH_RCU"
+#endif
 #define HASH_BLOOM_BITLEN (1ULL << HASH_BLOOM)
 #define HASH_BLOOM_BYTELEN (HASH_BLOOM_BITLEN/8) + ((HASH_BLOOM_BITLEN%8) ? 1:0)
+
+/* a remix of the whole hashv, for filters that should not reuse the low
+ * bits that pick the bucket */
+static HASH_INLINE uint64_t uthash_bloom_mix(UT_hash_value hashv) {
+  uint64_t x = (uint64_t)hashv * 0x9e3779b97f4a7c15ULL;
+  return x ^ (x >> 32);
+}
+
+#ifdef HASH_BLOOM_BLOCKED
+#if HASH_BLOOM < 9
+#error "HASH_BLOOM_BLOCKED needs HASH_BLOOM of at least 9 (one 64-byte block)"
+#endif
+/* a blocked filter: each key sets one bit in each of the eight words of one
+ * 64-byte block, so a test reads one cache line. The block and the bits come
+ * from a remix of the whole hashv, not from the low bits that pick its
+ * bucket. The vector is over-allocated by a line so the blocks are aligned. */
+#define HASH_BLOOM_BYTES(nbits) ((size_t)((1ULL << (nbits))/8) + 63)
+#define HASH_BLOOM_BLOCK(bv,nbits,x)                                             \
+  ((uint64_t*)(void*)((bv) + ((64 - ((size_t)(bv) & 63)) & 63)) +                \
+   8 * ((uint32_t)((x) >> 32) & (uint32_t)((1ULL << ((nbits) - 9)) - 1)))
+#define HASH_BLOOM_SALTS { 0x47b6137bU, 0x44974d91U, 0x8824ad5bU, 0xa2b7289dU,   \
+                           0x705495c7U, 0x2df1424bU, 0x9efc4947U, 0x5c6bfb31U }
+
+static HASH_INLINE void uthash_bloom_add(uint8_t *bv, unsigned nbits,
+                                         UT_hash_value hashv) {
+  static const uint32_t salt[8] = HASH_BLOOM_SALTS;
+  uint64_t x = uthash_bloom_mix(hashv), *blk = HASH_BLOOM_BLOCK(bv, nbits, x);
+  uint32_t key = (uint32_t)x;
+  unsigned i;
+  for (i = 0; i < 8; i++) blk[i] |= (uint64_t)1 << ((key * salt[i]) >> 26);
+}
+
+/* nonzero if all eight bits are set; no early exit, so it vectorizes */
+static HASH_INLINE int uthash_bloom_test(const uint8_t *bv, unsigned nbits,
+                                         UT_hash_value hashv) {
+  static const uint32_t salt[8] = HASH_BLOOM_SALTS;
+  uint64_t x = uthash_bloom_mix(hashv), miss = 0;
+  const uint64_t *blk = HASH_BLOOM_BLOCK(bv, nbits, x);
+  uint32_t key = (uint32_t)x;
+  unsigned i;
+  for (i = 0; i < 8; i++) {
+    miss |= ~blk[i] & ((uint64_t)1 << ((key * salt[i]) >> 26));
+  }
+  return !miss;
+}
+
+#define HASH_BLOOM_ADD(tbl,hashv)                                                \
+  uthash_bloom_add(HASH_TBL_BLOOM_BV(tbl), (unsigned)(tbl)->bloom_nbits, (hashv))
+
+#define HASH_BLOOM_TEST(tbl,hashv)                                               \
+  uthash_bloom_test(HASH_TBL_BLOOM_BV(tbl), (unsigned)(tbl)->bloom_nbits, (hashv))
+
+#define HASH_BLOOM_DEL(tbl,hashv)
+
+#elif defined(HASH_BLOOM_COUNTING)
+/* a counting filter (-DHASH_BLOOM_COUNTING): 4-bit counters instead of
+ * bits, so that HASH_DELETE can take its item back out. Each key counts in
+ * two counters, picked by the two halves of a remix of its hashv. A counter
+ * that reaches 15 sticks there, as it may have overflowed. */
+#define HASH_BLOOM_BYTES(nbits) ((size_t)((1ULL << (nbits))/2))
+#define HASH_BLOOM_IDX(x,nbits) ((uint32_t)(x) >> (32 - (nbits)))
+
+static HASH_INLINE void uthash_bloom_count(uint8_t *bv, unsigned nbits,
+                                           UT_hash_value hashv, int delta) {
+  uint64_t x = uthash_bloom_mix(hashv);
+  uint32_t idx[2];
+  unsigned i, shift, c;
+  idx[0] = HASH_BLOOM_IDX(x >> 32, nbits);
+  idx[1] = HASH_BLOOM_IDX(x, nbits);
+  if ((idx[1] == idx[0]) && (nbits > 1)) idx[1] ^= 1;
+  for (i = 0; i < 2; i++) {
+    shift = 4 * (idx[i] % 2);
+    c = (bv[idx[i]/2] >> shift) & 0xf;
+    if ((c == 15) || ((c == 0) && (delta < 0))) continue;
+    bv[idx[i]/2] = (uint8_t)((bv[idx[i]/2] & ~(0xfU << shift)) |
+                             ((c + delta) << shift));
+  }
+}
+
+static HASH_INLINE int uthash_bloom_test(const uint8_t *bv, unsigned nbits,
+                                         UT_hash_value hashv) {
+  uint64_t x = uthash_bloom_mix(hashv);
+  uint32_t i0 = HASH_BLOOM_IDX(x >> 32, nbits), i1 = HASH_BLOOM_IDX(x, nbits);
+  if ((i1 == i0) && (nbits > 1)) i1 ^= 1;
+  return ((bv[i0/2] >> (4*(i0%2))) & 0xf) && ((bv[i1/2] >> (4*(i1%2))) & 0xf);
+}
+
+#define HASH_BLOOM_ADD(tbl,hashv)                                                \
+  uthash_bloom_count(HASH_TBL_BLOOM_BV(tbl), (unsigned)(tbl)->bloom_nbits, (hashv), 1)
+
+#define HASH_BLOOM_DEL(tbl,hashv)                                                \
+  uthash_bloom_count(HASH_TBL_BLOOM_BV(tbl), (unsigned)(tbl)->bloom_nbits, (hashv), -1)
+
+#define HASH_BLOOM_TEST(tbl,hashv)                                               \
+  uthash_bloom_test(HASH_TBL_BLOOM_BV(tbl), (unsigned)(tbl)->bloom_nbits, (hashv))
+
+#else
+#define HASH_BLOOM_BYTES(nbits) ((size_t)(((1ULL << (nbits)) + 7)/8))
+#define HASH_BLOOM_BITSET(bv,idx) (bv[(idx)/8] |= (1U << ((idx)%8)))
+#define HASH_BLOOM_BITTEST(bv,idx) (bv[(idx)/8] & (1U << ((idx)%8)))
+
+#define HASH_BLOOM_ADD(tbl,hashv)                                                \
+  HASH_BLOOM_BITSET(HASH_TBL_BLOOM_BV(tbl), (hashv & (uint32_t)((1ULL << (tbl)->bloom_nbits) - 1)))
+
+#define HASH_BLOOM_TEST(tbl,hashv)                                               \
+  HASH_BLOOM_BITTEST(HASH_TBL_BLOOM_BV(tbl), (hashv & (uint32_t)((1ULL << (tbl)->bloom_nbits) - 1)))
+
+#define HASH_BLOOM_DEL(tbl,hashv)
+#endif
+
+#ifdef HASH_BLOOM_GROW
+/* With -DHASH_BLOOM_GROW the filter is sized for its table, not fixed at
+ * 2^HASH_BLOOM bits: 2^HASH_BLOOM_BKT_BITS bits (or counters) per bucket,
+ * no fewer than 2^HASH_BLOOM, no more than 2^32. Whenever the bucket array
+ * is resized the filter is rebuilt from the items present, which also drops
+ * the bits of deleted items. */
+#ifndef HASH_BLOOM_BKT_BITS
+#define HASH_BLOOM_BKT_BITS 5
+#endif
+#define HASH_BLOOM_NBITS(tbl)                                                    \
+  (((tbl)->log2_num_buckets + HASH_BLOOM_BKT_BITS < HASH_BLOOM) ? HASH_BLOOM :  \
+   ((tbl)->log2_num_buckets + HASH_BLOOM_BKT_BITS > 32) ? 32 :                   \
+   (tbl)->log2_num_buckets + HASH_BLOOM_BKT_BITS)
+#define HASH_BLOOM_RESIZE(tbl)                                                   \
+do {                                                                             \
+    UT_hash_size _hbr_i;                                                         \
+    struct UT_hash_handle *_hbr_thh;                                             \
+    if ((unsigned)(tbl)->bloom_nbits != (unsigned)HASH_BLOOM_NBITS(tbl)) {       \
+      HASH_BLOOM_FREE(tbl);                                                      \
+      HASH_BLOOM_MAKE(tbl);                                                      \
+    } else {                                                                     \
+      HASH_BLOOM_CLEAR(tbl);                                                     \
+    }                                                                            \
+    for(_hbr_i = 0; _hbr_i < (tbl)->num_buckets; _hbr_i++) {                     \
+        for(_hbr_thh = HASH_BKT_HEAD(&HASH_TBL_BUCKETS(tbl)[_hbr_i]); _hbr_thh;  \
+            _hbr_thh = HASH_HH_CHAIN_NEXT(tbl, _hbr_thh)) {                      \
+            HASH_BLOOM_ADD(tbl, _hbr_thh->hashv);                                \
+        }                                                                        \
+    }                                                                            \
+} while (0)
+#else
+#define HASH_BLOOM_NBITS(tbl) HASH_BLOOM
+#define HASH_BLOOM_RESIZE(tbl)
+#endif
+
 #define HASH_BLOOM_MAKE(tbl)                                                     \
 do {                                                                             \
-  (tbl)->bloom_nbits = HASH_BLOOM;                                               \
-  (tbl)->bloom_bv = (uint8_t*)uthash_malloc(HASH_BLOOM_BYTELEN);                 \
-  if (!((tbl)->bloom_bv))  { uthash_fatal( "out of memory"); }                   \
-  memset((tbl)->bloom_bv, 0, HASH_BLOOM_BYTELEN);                                \
+  uint8_t *_hbm_bv;                                                              \
+  (tbl)->bloom_nbits = (char)HASH_BLOOM_NBITS(tbl);                              \
+  _hbm_bv = (uint8_t*)HASH_TBL_MALLOC((tbl),                                     \
+                       HASH_BLOOM_BYTES((tbl)->bloom_nbits));                    \
+  if (!_hbm_bv)  { uthash_fatal( "out of memory"); }                             \
+  memset(_hbm_bv, 0, HASH_BLOOM_BYTES((tbl)->bloom_nbits));                      \
+  HASH_TBL_SET_BLOOM_BV(tbl, _hbm_bv);                                           \
   (tbl)->bloom_sig = HASH_BLOOM_SIGNATURE;                                       \
 } while (0) 
 
 #define HASH_BLOOM_FREE(tbl)                                                     \
 do {                                                                             \
-  uthash_free((tbl)->bloom_bv, HASH_BLOOM_BYTELEN);                              \
+  HASH_TBL_FREE((tbl), HASH_TBL_BLOOM_BV(tbl),                                   \
+                HASH_BLOOM_BYTES((tbl)->bloom_nbits));                           \
 } while (0) 
 
-#define HASH_BLOOM_BITSET(bv,idx) (bv[(idx)/8] |= (1U << ((idx)%8)))
-#define HASH_BLOOM_BITTEST(bv,idx) (bv[(idx)/8] & (1U << ((idx)%8)))
-
-#define HASH_BLOOM_ADD(tbl,hashv)                                                \
-  HASH_BLOOM_BITSET((tbl)->bloom_bv, (hashv & (uint32_t)((1ULL << (tbl)->bloom_nbits) - 1)))
-
-#define HASH_BLOOM_TEST(tbl,hashv)                                               \
-  HASH_BLOOM_BITTEST((tbl)->bloom_bv, (hashv & (uint32_t)((1ULL << (tbl)->bloom_nbits) - 1)))
+#define HASH_BLOOM_CLEAR(tbl)                                                    \
+  memset(HASH_TBL_BLOOM_BV(tbl), 0, HASH_BLOOM_BYTES((tbl)->bloom_nbits))
 
 #else
 #define HASH_BLOOM_MAKE(tbl) 
 #define HASH_BLOOM_FREE(tbl) 
+#define HASH_BLOOM_CLEAR(tbl)
 #define HASH_BLOOM_ADD(tbl,hashv) 
+#define HASH_BLOOM_DEL(tbl,hashv)
 #define HASH_BLOOM_TEST(tbl,hashv) (1)
+#define HASH_BLOOM_RESIZE(tbl)
 #endif
 
 #define HASH_MAKE_TABLE(hh,head)                                                 \
 do {                                                                             \
-  (head)->hh.tbl = (UT_hash_table*)uthash_malloc(                                \
+  UT_hash_table *_hmt_tbl;                                                       \
+  UT_hash_bucket *_hmt_buckets;                                                  \
+  HASH_MAKE_ALLOC_DECL(_hmt_alloc, head);                                        \
+  _hmt_tbl = (UT_hash_table*)HASH_ALLOC_MALLOC(_hmt_alloc,                       \
                   sizeof(UT_hash_table));                                        \
-  if (!((head)->hh.tbl))  { uthash_fatal( "out of memory"); }                    \
-  memset((head)->hh.tbl, 0, sizeof(UT_hash_table));                              \
-  (head)->hh.tbl->tail = &((head)->hh);                                          \
-  (head)->hh.tbl->num_buckets = HASH_INITIAL_NUM_BUCKETS;                        \
-  (head)->hh.tbl->log2_num_buckets = HASH_INITIAL_NUM_BUCKETS_LOG2;              \
-  (head)->hh.tbl->hho = (char*)(&(head)->hh) - (char*)(head);                    \
-  (head)->hh.tbl->buckets = (UT_hash_bucket*)uthash_malloc(                      \
-          HASH_INITIAL_NUM_BUCKETS*sizeof(struct UT_hash_bucket));               \
-  if (! (head)->hh.tbl->buckets) { uthash_fatal( "out of memory"); }             \
-  memset((head)->hh.tbl->buckets, 0,                                             \
-          HASH_INITIAL_NUM_BUCKETS*sizeof(struct UT_hash_bucket));               \
-  HASH_BLOOM_MAKE((head)->hh.tbl);                                               \
-  (head)->hh.tbl->signature = HASH_SIGNATURE;                                    \
+  if (!_hmt_tbl)  { uthash_fatal( "out of memory"); }                            \
+  memset(_hmt_tbl, 0, sizeof(UT_hash_table));                                    \
+  HASH_HH_SET_TBL(&(head)->hh, _hmt_tbl);                                        \
+  HASH_ALLOC_INIT(_hmt_tbl, _hmt_alloc);                                         \
+  HASH_TBL_SET_TAIL(_hmt_tbl, &((head)->hh));                                    \
+  HASH_LOG2_FOR(uthash_capacity_hint(head), _hmt_tbl->log2_num_buckets);         \
+  _hmt_tbl->num_buckets = (UT_hash_size)1 << _hmt_tbl->log2_num_buckets;         \
+  _hmt_tbl->ideal_chain_maxlen = (uthash_capacity_hint(head) >>                  \
+          _hmt_tbl->log2_num_buckets) + ((uthash_capacity_hint(head) &           \
+          (_hmt_tbl->num_buckets-1)) ? 1 : 0);                                   \
+  _hmt_tbl->hho = (char*)(&(head)->hh) - (char*)(head);                          \
+  HASH_HH_BASE(_hmt_tbl);                                                        \
+  HASH_BKT_ALLOC(_hmt_tbl, _hmt_tbl->num_buckets, _hmt_buckets);                 \
+  HASH_TBL_SET_BUCKETS(_hmt_tbl, _hmt_buckets);                                  \
+  HASH_BLOOM_MAKE(_hmt_tbl);                                                     \
+  HASH_NEW_SEED(_hmt_tbl);                                                       \
+  HASH_RCU_INIT(_hmt_tbl, head);                                                 \
+  _hmt_tbl->signature = HASH_SIGNATURE;                                          \
 } while(0)
 
 #define HASH_ADD(hh,head,fieldname,keylen_in,add)                                \
@@ -161,34 +1078,198 @@ do {
  
 #define HASH_ADD_KEYPTR(hh,head,keyptr,keylen_in,add)                            \
 do {                                                                             \
- unsigned _ha_bkt;                                                               \
- (add)->hh.next = NULL;                                                          \
- (add)->hh.key = (char*)keyptr;                                                  \
- (add)->hh.keylen = (unsigned)keylen_in;                                                   \
+ UT_hash_size _ha_bkt;                                                           \
+ HASH_ADD_LINK(hh,head,keyptr,keylen_in,add);                                    \
+ HASH_FCN_TBL(HASH_TBL(hh,head), keyptr,keylen_in,                               \
+         HASH_TBL(hh,head)->num_buckets,                                         \
+         (add)->hh.hashv, _ha_bkt);                                              \
+ HASH_ADD_FINISH(hh,head,keyptr,keylen_in,add,_ha_bkt);                          \
+} while(0)
+
+/* as HASH_ADD_KEYPTR, with the hash value of the key already computed by
+ * HASH_VALUE; see HASH_FIND_BYHASHVALUE */
+#define HASH_ADD_KEYPTR_BYHASHVALUE(hh,head,keyptr,keylen_in,hashval,add)        \
+do {                                                                             \
+ UT_hash_size _ha_bkt;                                                           \
+ HASH_ADD_LINK(hh,head,keyptr,keylen_in,add);                                    \
+ (add)->hh.hashv = (hashval);                                                    \
+ HASH_ADD_HASHV_FIRST(hh,head,add);                                              \
+ HASH_TO_BKT((add)->hh.hashv, HASH_TBL(hh,head)->num_buckets, _ha_bkt);          \
+ HASH_ADD_FINISH(hh,head,keyptr,keylen_in,add,_ha_bkt);                          \
+} while(0)
+#define HASH_ADD_BYHASHVALUE(hh,head,fieldname,keylen_in,hashval,add)            \
+        HASH_ADD_KEYPTR_BYHASHVALUE(hh,head,&((add)->fieldname),keylen_in,       \
+                                    hashval,add)
+
+/* a table that hashes keys its own way did not exist when the hash value
+ * of its first item was computed (add is then the head), so that item's key
+ * is hashed again */
+#if defined(HASH_SEEDED) || defined(HASH_TABLE_FCN)
+#define HASH_ADD_HASHV_FIRST(hh,head,add)                                        \
+do {                                                                             \
+ if ((void*)(head) == (void*)(add)) {                                            \
+   HASH_REHASH_HH(HASH_TBL(hh,head), &((add)->hh));                              \
+ }                                                                               \
+} while(0)
+#else
+#define HASH_ADD_HASHV_FIRST(hh,head,add)
+#endif
+
+/* the first half of an add: append add in app order, making the table if
+ * need be */
+#define HASH_ADD_LINK(hh,head,keyptr,keylen_in,add)                              \
+do {                                                                             \
+ HASH_HH_SET_KEY(&((add)->hh), keyptr);                                          \
+ (add)->hh.keylen = (UT_hash_size)keylen_in;                                     \
  if (!(head)) {                                                                  \
-    head = (add);                                                                \
-    (head)->hh.prev = NULL;                                                      \
-    HASH_MAKE_TABLE(hh,head);                                                    \
+    HASH_MAKE_TABLE(hh,add);                                                     \
+    HASH_HH_SET_PREV(HASH_TBL(hh,add), &((add)->hh), NULL);                      \
+    HASH_RCU_ASSIGN(head,add);                                                   \
  } else {                                                                        \
-    (head)->hh.tbl->tail->next = (add);                                          \
-    (add)->hh.prev = ELMT_FROM_HH((head)->hh.tbl, (head)->hh.tbl->tail);         \
-    (head)->hh.tbl->tail = &((add)->hh);                                         \
+    HASH_HH_SET_TBL(&(add)->hh, HASH_TBL(hh,head));                              \
+    HASH_HH_SET_NEXT(HASH_TBL(hh,head), HASH_TBL_TAIL(HASH_TBL(hh,head)),        \
+                     &((add)->hh));                                              \
+    HASH_HH_SET_PREV(HASH_TBL(hh,head), &((add)->hh),                            \
+                     HASH_TBL_TAIL(HASH_TBL(hh,head)));                          \
+    HASH_TBL_SET_TAIL(HASH_TBL(hh,head), &((add)->hh));                          \
  }                                                                               \
- (head)->hh.tbl->num_items++;                                                    \
- (add)->hh.tbl = (head)->hh.tbl;                                                 \
- HASH_FCN(keyptr,keylen_in, (head)->hh.tbl->num_buckets,                         \
-         (add)->hh.hashv, _ha_bkt);                                              \
- HASH_ADD_TO_BKT((head)->hh.tbl->buckets[_ha_bkt],&(add)->hh);                   \
- HASH_BLOOM_ADD((head)->hh.tbl,(add)->hh.hashv);                                 \
+ HASH_HH_SET_NEXT(HASH_TBL(hh,head), &((add)->hh), NULL);                        \
+ HASH_TBL(hh,head)->num_items++;                                                 \
+ HASH_EXPAND_STEP(HASH_TBL(hh,head));                                            \
+} while(0)
+
+/* the second half: put add, whose hashv is set, in bucket bkt */
+#define HASH_ADD_FINISH(hh,head,keyptr,keylen_in,add,bkt)                        \
+do {                                                                             \
+ HASH_ADD_TO_BKT(HASH_BKT(HASH_TBL(hh,head),(add)->hh.hashv,bkt),&(add)->hh);    \
+ HASH_BLOOM_ADD(HASH_TBL(hh,head),(add)->hh.hashv);                              \
+ HASH_FCN_SAMPLED(HASH_TBL(hh,head));                                            \
  HASH_EMIT_KEY(hh,head,keyptr,keylen_in);                                        \
  HASH_FSCK(hh,head);                                                             \
 } while(0)
 
+/* Add n items at once. HASH_ADD_BULK takes an array of pointers to the items,
+ * HASH_ADD_BULK_ARRAY a contiguous array of the items themselves, and
+ * HASH_ADD_KEYPTR_BULK arrays of key pointers and lengths beside the item
+ * pointers (as HASH_FIND_BATCH does). The bucket array is sized for all the
+ * items once, every key is hashed in one pass, and the items are then put
+ * in their buckets, the bucket a few items ahead being prefetched, and
+ * linked in app order in array order. With -DHASH_SEEDED or per-table hash
+ * functions the hash can change while items are added, so there each key
+ * is hashed as its item goes in. */
+#ifndef HASH_BULK_AHEAD
+#define HASH_BULK_AHEAD 8       /* items ahead whose bucket is prefetched   */
+#endif
+#if defined(HASH_SEEDED) || defined(HASH_TABLE_FCN)
+#define HASH_BULK_PREHASH(tbl,keyptr,keylen_in,hashv)
+#define HASH_BULK_HASH(tbl,keyptr,keylen_in,hashv)                               \
+  HASH_FCN_TBL(tbl, keyptr, keylen_in, (tbl)->num_buckets, hashv, _hab_bkt)
+#define HASH_BULK_PREFETCH(tbl,item,n)
+#else
+#define HASH_BULK_PREHASH(tbl,keyptr,keylen_in,hashv)                            \
+  HASH_FCN_TBL(tbl, keyptr, keylen_in, (tbl)->num_buckets, hashv, _hab_bkt)
+#define HASH_BULK_HASH(tbl,keyptr,keylen_in,hashv)
+#define HASH_BULK_PREFETCH(tbl,item,n)                                           \
+do {                                                                             \
+  _hab_i += HASH_BULK_AHEAD;                                                     \
+  if (_hab_i < (n)) {                                                            \
+    HASH_PREFETCH(HASH_TBL_BUCKETS(tbl) +                                        \
+                  ((item)->hh.hashv & ((tbl)->num_buckets-1)));                  \
+  }                                                                              \
+  _hab_i -= HASH_BULK_AHEAD;                                                     \
+} while(0)
+#endif
+#define HASH_ADD_BULK(hh,head,fieldname,keylen_in,items,n)                       \
+  HASH_ADD_BULK_BY(hh,head,(items)[_hab_i],&((items)[_hab_i]->fieldname),        \
+                   keylen_in,n)
+#define HASH_ADD_BULK_ARRAY(hh,head,fieldname,keylen_in,elts,n)                  \
+  HASH_ADD_BULK_BY(hh,head,&((elts)[_hab_i]),&((elts)[_hab_i].fieldname),        \
+                   keylen_in,n)
+#define HASH_ADD_KEYPTR_BULK(hh,head,keyptrs,keylens,items,n)                    \
+  HASH_ADD_BULK_BY(hh,head,(items)[_hab_i],(keyptrs)[_hab_i],(keylens)[_hab_i],n)
+
+/* the bulk add: item, keyptr and keylen_in give the i'th item and its key in
+ * terms of the index _hab_i */
+#define HASH_ADD_BULK_BY(hh,head,item,keyptr,keylen_in,n)                        \
+do {                                                                             \
+  size_t _hab_i, _hab_n = (size_t)(n);                                           \
+  unsigned _hab_log2;                                                            \
+  UT_hash_size _hab_bkt;                                                         \
+  UT_hash_table *_hab_tbl;                                                       \
+  UT_hash_handle *_hab_hh, *_hab_tail;                                           \
+  if (_hab_n > 0) {                                                              \
+    _hab_i = 0;                                                                  \
+    if (head) {                                                                  \
+      _hab_tbl = HASH_TBL(hh,head);                                              \
+      _hab_tail = HASH_TBL_TAIL(_hab_tbl);                                       \
+    } else {                                                                     \
+      HASH_MAKE_TABLE(hh,item);                                                  \
+      _hab_tbl = HASH_TBL(hh,item);                                              \
+      _hab_tail = NULL;                                                          \
+    }                                                                            \
+    HASH_LOG2_FOR(_hab_tbl->num_items + _hab_n, _hab_log2);                      \
+    if (_hab_log2 > _hab_tbl->log2_num_buckets) {                                \
+      HASH_RESIZE_BUCKETS(_hab_tbl, _hab_log2, _hab_tbl->num_items + _hab_n);    \
+    }                                                                            \
+    HASH_EXPAND_COMPLETE(_hab_tbl);                                              \
+    for (_hab_i = 0; _hab_i < _hab_n; _hab_i++) {                                \
+      HASH_HH_SET_TBL(&(item)->hh, _hab_tbl);                                    \
+      HASH_HH_SET_KEY(&((item)->hh), keyptr);                                    \
+      (item)->hh.keylen = (UT_hash_size)(keylen_in);                             \
+      HASH_BULK_PREHASH(_hab_tbl, keyptr, keylen_in, (item)->hh.hashv);          \
+    }                                                                            \
+    for (_hab_i = 0; _hab_i < _hab_n; _hab_i++) {                                \
+      HASH_BULK_PREFETCH(_hab_tbl, item, _hab_n);                                \
+      _hab_hh = &((item)->hh);                                                   \
+      HASH_HH_SET_PREV(_hab_tbl, _hab_hh, _hab_tail);                            \
+      if (_hab_tail) {                                                           \
+        HASH_HH_SET_NEXT(_hab_tbl, _hab_tail, _hab_hh);                          \
+      }                                                                          \
+      _hab_tail = _hab_hh;                                                       \
+      HASH_TBL_SET_TAIL(_hab_tbl, _hab_tail);                                    \
+      _hab_tbl->num_items++;                                                     \
+      HASH_EXPAND_STEP(_hab_tbl);                                                \
+      HASH_BULK_HASH(_hab_tbl, keyptr, keylen_in, _hab_hh->hashv);               \
+      HASH_TO_BKT(_hab_hh->hashv, _hab_tbl->num_buckets, _hab_bkt);              \
+      HASH_ADD_TO_BKT(HASH_BKT(_hab_tbl,_hab_hh->hashv,_hab_bkt), _hab_hh);      \
+      HASH_BLOOM_ADD(_hab_tbl, _hab_hh->hashv);                                  \
+      HASH_FCN_SAMPLED(_hab_tbl);                                                \
+      HASH_EMIT_KEY(hh,head,keyptr,keylen_in);                                   \
+    }                                                                            \
+    HASH_HH_SET_NEXT(_hab_tbl, _hab_tail, NULL);                                 \
+    if (!(head)) {                                                               \
+      _hab_i = 0;                                                                \
+      HASH_RCU_ASSIGN(head, item);                                               \
+    }                                                                            \
+    HASH_FSCK(hh,head);                                                          \
+  }                                                                              \
+} while(0)
+
 #define HASH_TO_BKT( hashv, num_bkts, bkt )                                      \
 do {                                                                             \
   bkt = ((hashv) & ((num_bkts) - 1));                                            \
 } while(0)
 
+/* the bucket holding hashv, given its index bkt in the current bucket array.
+ * While an incremental expansion is in flight (see HASH_EXPAND_BUCKETS), an
+ * item whose old bucket has not been migrated yet still lives there. */
+#ifdef HASH_INCREMENTAL
+#define HASH_BKT(tbl,hashv,bkt)                                                  \
+  (*((((tbl)->old_buckets) &&                                                    \
+      (((hashv) & ((tbl)->old_num_buckets - 1)) >= (tbl)->migrate_bkt)) ?        \
+     &((tbl)->old_buckets[(hashv) & ((tbl)->old_num_buckets - 1)]) :             \
+     &(HASH_TBL_BUCKETS(tbl)[bkt])))
+#else
+#define HASH_BKT(tbl,hashv,bkt) (HASH_TBL_BUCKETS(tbl)[bkt])
+#endif
+
+/* release the bucket array(s) of a table that is being freed */
+#define HASH_FREE_BUCKETS(tbl)                                                   \
+do {                                                                             \
+  HASH_BKT_FREE((tbl), HASH_TBL_BUCKETS(tbl), (tbl)->num_buckets);               \
+  HASH_FREE_OLD_BUCKETS(tbl);                                                    \
+} while(0)
+
 /* delete "delptr" from the hash table.
  * "the usual" patch-up process for the app-order doubly-linked-list.
  * The use of _hd_hh_del below deserves special explanation.
@@ -203,35 +1284,38 @@ do {
  */
 #define HASH_DELETE(hh,head,delptr)                                              \
 do {                                                                             \
-    unsigned _hd_bkt;                                                            \
-    struct UT_hash_handle *_hd_hh_del;                                           \
-    if ( ((delptr)->hh.prev == NULL) && ((delptr)->hh.next == NULL) )  {         \
-        uthash_free((head)->hh.tbl->buckets,                                     \
-                    (head)->hh.tbl->num_buckets*sizeof(struct UT_hash_bucket) ); \
-        HASH_BLOOM_FREE((head)->hh.tbl);                                         \
-        uthash_free((head)->hh.tbl, sizeof(UT_hash_table));                      \
-        head = NULL;                                                             \
+    UT_hash_size _hd_bkt;                                                        \
+    struct UT_hash_handle *_hd_hh_del, *_hd_prev, *_hd_next;                     \
+    UT_hash_table *_hd_tbl;                                                      \
+    _hd_hh_del = &((delptr)->hh);                                                \
+    _hd_prev = HASH_HH_PREV(HASH_TBL(hh,head), _hd_hh_del);                      \
+    _hd_next = HASH_HH_NEXT(HASH_TBL(hh,head), _hd_hh_del);                      \
+    if ( (_hd_prev == NULL) && (_hd_next == NULL) )  {                           \
+        _hd_tbl = HASH_TBL(hh,head);                                             \
+        HASH_RCU_ASSIGN(head,NULL);                                              \
+        HASH_RCU_SYNC(_hd_tbl);                                                  \
+        HASH_FREE_BUCKETS(_hd_tbl);                                              \
+        HASH_BLOOM_FREE(_hd_tbl);                                                \
+        HASH_TBL_FREE(_hd_tbl, _hd_tbl, sizeof(UT_hash_table));                  \
     } else {                                                                     \
-        _hd_hh_del = &((delptr)->hh);                                            \
-        if ((delptr) == ELMT_FROM_HH((head)->hh.tbl,(head)->hh.tbl->tail)) {     \
-            (head)->hh.tbl->tail =                                               \
-                (UT_hash_handle*)((char*)((delptr)->hh.prev) +                   \
-                (head)->hh.tbl->hho);                                            \
+        if (_hd_hh_del == HASH_TBL_TAIL(HASH_TBL(hh,head))) {                    \
+            HASH_TBL_SET_TAIL(HASH_TBL(hh,head), _hd_prev);                      \
         }                                                                        \
-        if ((delptr)->hh.prev) {                                                 \
-            ((UT_hash_handle*)((char*)((delptr)->hh.prev) +                      \
-                    (head)->hh.tbl->hho))->next = (delptr)->hh.next;             \
+        if (_hd_prev) {                                                          \
+            HASH_HH_SET_NEXT(HASH_TBL(hh,head), _hd_prev, _hd_next);             \
         } else {                                                                 \
-            DECLTYPE_ASSIGN(head,(delptr)->hh.next);                             \
+            HASH_RCU_ASSIGN(head,ELMT_FROM_HH(HASH_TBL(hh,head), _hd_next));     \
         }                                                                        \
-        if (_hd_hh_del->next) {                                                  \
-            ((UT_hash_handle*)((char*)_hd_hh_del->next +                         \
-                    (head)->hh.tbl->hho))->prev =                                \
-                    _hd_hh_del->prev;                                            \
+        if (_hd_next) {                                                          \
+            HASH_HH_SET_PREV(HASH_TBL(hh,head), _hd_next, _hd_prev);             \
         }                                                                        \
-        HASH_TO_BKT( _hd_hh_del->hashv, (head)->hh.tbl->num_buckets, _hd_bkt);   \
-        HASH_DEL_IN_BKT(hh,(head)->hh.tbl->buckets[_hd_bkt], _hd_hh_del);        \
-        (head)->hh.tbl->num_items--;                                             \
+        HASH_EXPAND_STEP(HASH_TBL(hh,head));                                     \
+        HASH_TO_BKT(_hd_hh_del->hashv, HASH_TBL(hh,head)->num_buckets, _hd_bkt); \
+        HASH_DEL_IN_BKT(hh,HASH_BKT(HASH_TBL(hh,head),_hd_hh_del->hashv,_hd_bkt),\
+                        _hd_hh_del);                                             \
+        HASH_BLOOM_DEL(HASH_TBL(hh,head), _hd_hh_del->hashv);                    \
+        HASH_TBL(hh,head)->num_items--;                                          \
+        HASH_SHRINK_CHECK(HASH_TBL(hh,head));                                    \
     }                                                                            \
     HASH_FSCK(hh,head);                                                          \
 } while (0)
@@ -260,34 +1344,36 @@ do {
 #define HASH_OOPS(...) do { fprintf(stderr,__VA_ARGS__); exit(-1); } while (0)
 #define HASH_FSCK(hh,head)                                                       \
 do {                                                                             \
-    unsigned _bkt_i;                                                             \
-    unsigned _count, _bkt_count;                                                 \
+    UT_hash_size _bkt_i, _count;                                                 \
+    unsigned _bkt_count;                                                         \
     char *_prev;                                                                 \
     struct UT_hash_handle *_thh;                                                 \
+    UT_hash_bucket *_bkt;                                                        \
     if (head) {                                                                  \
         _count = 0;                                                              \
-        for( _bkt_i = 0; _bkt_i < (head)->hh.tbl->num_buckets; _bkt_i++) {       \
+        for( _bkt_i = 0; _bkt_i < HASH_FSCK_NUM_BKTS(HASH_TBL(hh,head));         \
+             _bkt_i++) {                                                         \
             _bkt_count = 0;                                                      \
-            _thh = (head)->hh.tbl->buckets[_bkt_i].hh_head;                      \
+            _bkt = HASH_FSCK_BKT(HASH_TBL(hh,head), _bkt_i);                     \
+            _thh = HASH_BKT_HEAD(_bkt);                                          \
             _prev = NULL;                                                        \
             while (_thh) {                                                       \
-               if (_prev != (char*)(_thh->hh_prev)) {                            \
-                   HASH_OOPS("invalid hh_prev %p, actual %p\n",                  \
-                    _thh->hh_prev, _prev );                                      \
-               }                                                                 \
+               HASH_FSCK_CHAIN_PREV(_thh, _prev);                                \
                _bkt_count++;                                                     \
                _prev = (char*)(_thh);                                            \
-               _thh = _thh->hh_next;                                             \
+               _thh = HASH_HH_CHAIN_NEXT(HASH_TBL(hh,head), _thh);               \
             }                                                                    \
             _count += _bkt_count;                                                \
-            if ((head)->hh.tbl->buckets[_bkt_i].count !=  _bkt_count) {          \
+            if (_bkt->count !=  _bkt_count) {                                    \
                HASH_OOPS("invalid bucket count %d, actual %d\n",                 \
-                (head)->hh.tbl->buckets[_bkt_i].count, _bkt_count);              \
+                _bkt->count, _bkt_count);                                        \
             }                                                                    \
+            HASH_FP_FSCK(*_bkt);                                                 \
         }                                                                        \
-        if (_count != (head)->hh.tbl->num_items) {                               \
-            HASH_OOPS("invalid hh item count %d, actual %d\n",                   \
-                (head)->hh.tbl->num_items, _count );                             \
+        if (_count != HASH_TBL(hh,head)->num_items) {                            \
+            HASH_OOPS("invalid hh item count %lu, actual %lu\n",                 \
+                (unsigned long)HASH_TBL(hh,head)->num_items,                     \
+                (unsigned long)_count );                                         \
         }                                                                        \
         /* traverse hh in app order; check next/prev integrity, count */         \
         _count = 0;                                                              \
@@ -295,20 +1381,60 @@ do {
         _thh =  &(head)->hh;                                                     \
         while (_thh) {                                                           \
            _count++;                                                             \
-           if (_prev !=(char*)(_thh->prev)) {                                    \
+           if (_prev != (char*)HASH_HH_PREV(HASH_TBL(hh,head), _thh)) {          \
               HASH_OOPS("invalid prev %p, actual %p\n",                          \
-                    _thh->prev, _prev );                                         \
+                    (void*)HASH_HH_PREV(HASH_TBL(hh,head), _thh), _prev );       \
            }                                                                     \
-           _prev = (char*)ELMT_FROM_HH((head)->hh.tbl, _thh);                    \
-           _thh = ( _thh->next ?  (UT_hash_handle*)((char*)(_thh->next) +        \
-                                  (head)->hh.tbl->hho) : NULL );                 \
+           _prev = (char*)_thh;                                                  \
+           _thh = HASH_HH_NEXT(HASH_TBL(hh,head), _thh);                         \
         }                                                                        \
-        if (_count != (head)->hh.tbl->num_items) {                               \
-            HASH_OOPS("invalid app item count %d, actual %d\n",                  \
-                (head)->hh.tbl->num_items, _count );                             \
+        if (_count != HASH_TBL(hh,head)->num_items) {                            \
+            HASH_OOPS("invalid app item count %lu, actual %lu\n",                \
+                (unsigned long)HASH_TBL(hh,head)->num_items,                     \
+                (unsigned long)_count );                                         \
         }                                                                        \
     }                                                                            \
 } while (0)
+#ifdef HASH_COMPACT
+#define HASH_FSCK_CHAIN_PREV(thh,prev)
+#else
+#define HASH_FSCK_CHAIN_PREV(thh,prev)                                           \
+do {                                                                             \
+    if ((prev) != (char*)((thh)->hh_prev)) {                                     \
+        HASH_OOPS("invalid hh_prev %p, actual %p\n", (thh)->hh_prev, (prev));    \
+    }                                                                            \
+} while (0)
+#endif
+#ifdef HASH_INCREMENTAL
+#define HASH_FSCK_NUM_BKTS(tbl)                                                  \
+    ((tbl)->num_buckets +                                                        \
+     ((tbl)->old_buckets ? ((tbl)->old_num_buckets - (tbl)->migrate_bkt) : 0))
+#define HASH_FSCK_BKT(tbl,i)                                                     \
+    (((i) < (tbl)->num_buckets) ? &(HASH_TBL_BUCKETS(tbl)[i]) :                  \
+     &((tbl)->old_buckets[(tbl)->migrate_bkt + (i) - (tbl)->num_buckets]))
+#else
+#define HASH_FSCK_NUM_BKTS(tbl) ((tbl)->num_buckets)
+#define HASH_FSCK_BKT(tbl,i) (&(HASH_TBL_BUCKETS(tbl)[i]))
+#endif
+#ifdef HASH_FINGERPRINT
+#define HASH_FP_FSCK(bkt)                                                        \
+do {                                                                             \
+    unsigned _fpk_i;                                                             \
+    struct UT_hash_handle *_fpk_thh;                                             \
+    for(_fpk_i = 0; (bkt).count <= HASH_FP_SLOTS && _fpk_i < (bkt).count;        \
+        _fpk_i++) {                                                              \
+        for(_fpk_thh = HASH_BKT_HEAD(&(bkt)); _fpk_thh;                          \
+            _fpk_thh = HASH_HH_CHAIN_NEXT(HASH_HH_TBL(_fpk_thh), _fpk_thh)) {    \
+            if (_fpk_thh == (bkt).fp_hh[_fpk_i]) break;                          \
+        }                                                                        \
+        if (!_fpk_thh || (HASH_FP_OF(_fpk_thh->hashv) != (bkt).fp[_fpk_i])) {    \
+            HASH_OOPS("invalid fingerprint slot %d\n", _fpk_i);                  \
+        }                                                                        \
+    }                                                                            \
+} while (0)
+#else
+#define HASH_FP_FSCK(bkt)
+#endif
 #else
 #define HASH_FSCK(hh,head) 
 #endif
@@ -334,12 +1460,18 @@ do {
 #define HASH_FCN HASH_JEN
 #endif
 
+/* Each function X comes in two forms. HASH_X_SEED takes a trailing 64-bit
+ * seed which perturbs its initial state; HASH_X is the same function with
+ * a seed of 0, and gives the same hash values as before seeds existed. */
+
 /* The Bernstein hash function, used in Perl prior to v5.6 */
 #define HASH_BER(key,keylen,num_bkts,hashv,bkt)                                  \
+  HASH_BER_SEED(key,keylen,num_bkts,hashv,bkt,0)
+#define HASH_BER_SEED(key,keylen,num_bkts,hashv,bkt,seed)                        \
 do {                                                                             \
-  unsigned _hb_keylen=keylen;                                                    \
+  UT_hash_size _hb_keylen=keylen;                                                \
   char *_hb_key=(char*)(key);                                                    \
-  (hashv) = 0;                                                                   \
+  (hashv) = (UT_hash_value)(seed);                                               \
   while (_hb_keylen--)  { (hashv) = ((hashv) * 33) + *_hb_key++; }               \
   bkt = (hashv) & (num_bkts-1);                                                  \
 } while (0)
@@ -348,30 +1480,44 @@ do {
 /* SAX/FNV/OAT/JEN hash functions are macro variants of those listed at 
  * http://eternallyconfuzzled.com/tuts/algorithms/jsw_tut_hashing.aspx */
 #define HASH_SAX(key,keylen,num_bkts,hashv,bkt)                                  \
+  HASH_SAX_SEED(key,keylen,num_bkts,hashv,bkt,0)
+#define HASH_SAX_SEED(key,keylen,num_bkts,hashv,bkt,seed)                        \
 do {                                                                             \
-  unsigned _sx_i;                                                                \
+  UT_hash_size _sx_i;                                                            \
   char *_hs_key=(char*)(key);                                                    \
-  hashv = 0;                                                                     \
+  hashv = (UT_hash_value)(seed);                                                 \
   for(_sx_i=0; _sx_i < keylen; _sx_i++)                                          \
       hashv ^= (hashv << 5) + (hashv >> 2) + _hs_key[_sx_i];                     \
   bkt = hashv & (num_bkts-1);                                                    \
 } while (0)
 
+/* FNV's offset basis and prime are specific to the width of the hash */
+#ifdef HASH_64BIT
+#define HASH_FNV_OFFSET 14695981039346656037ULL
+#define HASH_FNV_PRIME 1099511628211ULL
+#else
+#define HASH_FNV_OFFSET 2166136261UL
+#define HASH_FNV_PRIME 16777619
+#endif
 #define HASH_FNV(key,keylen,num_bkts,hashv,bkt)                                  \
+  HASH_FNV_SEED(key,keylen,num_bkts,hashv,bkt,0)
+#define HASH_FNV_SEED(key,keylen,num_bkts,hashv,bkt,seed)                        \
 do {                                                                             \
-  unsigned _fn_i;                                                                \
+  UT_hash_size _fn_i;                                                            \
   char *_hf_key=(char*)(key);                                                    \
-  hashv = 2166136261UL;                                                          \
+  hashv = HASH_FNV_OFFSET ^ (UT_hash_value)(seed);                               \
   for(_fn_i=0; _fn_i < keylen; _fn_i++)                                          \
-      hashv = (hashv * 16777619) ^ _hf_key[_fn_i];                               \
+      hashv = (hashv * HASH_FNV_PRIME) ^ _hf_key[_fn_i];                         \
   bkt = hashv & (num_bkts-1);                                                    \
 } while(0) 
  
 #define HASH_OAT(key,keylen,num_bkts,hashv,bkt)                                  \
+  HASH_OAT_SEED(key,keylen,num_bkts,hashv,bkt,0)
+#define HASH_OAT_SEED(key,keylen,num_bkts,hashv,bkt,seed)                        \
 do {                                                                             \
-  unsigned _ho_i;                                                                \
+  UT_hash_size _ho_i;                                                            \
   char *_ho_key=(char*)(key);                                                    \
-  hashv = 0;                                                                     \
+  hashv = (UT_hash_value)(seed);                                                 \
   for(_ho_i=0; _ho_i < keylen; _ho_i++) {                                        \
       hashv += _ho_key[_ho_i];                                                   \
       hashv += (hashv << 10);                                                    \
@@ -396,13 +1542,17 @@ do {
   c -= a; c -= b; c ^= ( b >> 15 );                                              \
 } while (0)
 
+/* with HASH_64BIT, the final b word supplies the high half of the hashv */
 #define HASH_JEN(key,keylen,num_bkts,hashv,bkt)                                  \
+  HASH_JEN_SEED(key,keylen,num_bkts,hashv,bkt,0)
+#define HASH_JEN_SEED(key,keylen,num_bkts,hashv,bkt,seed)                        \
 do {                                                                             \
-  unsigned _hj_i,_hj_j,_hj_k;                                                    \
+  unsigned _hj_i,_hj_j,_hj_c;                                                    \
+  UT_hash_size _hj_k;                                                            \
   char *_hj_key=(char*)(key);                                                    \
-  hashv = 0xfeedbeef;                                                            \
-  _hj_i = _hj_j = 0x9e3779b9;                                                    \
-  _hj_k = (unsigned)keylen;                                                                \
+  _hj_c = 0xfeedbeef ^ (unsigned)(seed);                                         \
+  _hj_i = _hj_j = 0x9e3779b9 ^ (unsigned)((uint64_t)(seed) >> 32);               \
+  _hj_k = (UT_hash_size)keylen;                                                  \
   while (_hj_k >= 12) {                                                          \
     _hj_i +=    (_hj_key[0] + ( (unsigned)_hj_key[1] << 8 )                      \
         + ( (unsigned)_hj_key[2] << 16 )                                         \
@@ -410,20 +1560,20 @@ do {
     _hj_j +=    (_hj_key[4] + ( (unsigned)_hj_key[5] << 8 )                      \
         + ( (unsigned)_hj_key[6] << 16 )                                         \
         + ( (unsigned)_hj_key[7] << 24 ) );                                      \
-    hashv += (_hj_key[8] + ( (unsigned)_hj_key[9] << 8 )                         \
+    _hj_c += (_hj_key[8] + ( (unsigned)_hj_key[9] << 8 )                         \
         + ( (unsigned)_hj_key[10] << 16 )                                        \
         + ( (unsigned)_hj_key[11] << 24 ) );                                     \
                                                                                  \
-     HASH_JEN_MIX(_hj_i, _hj_j, hashv);                                          \
+     HASH_JEN_MIX(_hj_i, _hj_j, _hj_c);                                          \
                                                                                  \
      _hj_key += 12;                                                              \
      _hj_k -= 12;                                                                \
   }                                                                              \
-  hashv += keylen;                                                               \
+  _hj_c += (unsigned)keylen;                                                     \
   switch ( _hj_k ) {                                                             \
-     case 11: hashv += ( (unsigned)_hj_key[10] << 24 );                          \
-     case 10: hashv += ( (unsigned)_hj_key[9] << 16 );                           \
-     case 9:  hashv += ( (unsigned)_hj_key[8] << 8 );                            \
+     case 11: _hj_c += ( (unsigned)_hj_key[10] << 24 );                          \
+     case 10: _hj_c += ( (unsigned)_hj_key[9] << 16 );                           \
+     case 9:  _hj_c += ( (unsigned)_hj_key[8] << 8 );                            \
      case 8:  _hj_j += ( (unsigned)_hj_key[7] << 24 );                           \
      case 7:  _hj_j += ( (unsigned)_hj_key[6] << 16 );                           \
      case 6:  _hj_j += ( (unsigned)_hj_key[5] << 8 );                            \
@@ -433,10 +1583,31 @@ do {
      case 2:  _hj_i += ( (unsigned)_hj_key[1] << 8 );                            \
      case 1:  _hj_i += _hj_key[0];                                               \
   }                                                                              \
-  HASH_JEN_MIX(_hj_i, _hj_j, hashv);                                             \
+  HASH_JEN_MIX(_hj_i, _hj_j, _hj_c);                                             \
+  hashv = HASH_JOIN32(_hj_j, _hj_c);                                             \
   bkt = hashv & (num_bkts-1);                                                    \
 } while(0)
 
+/* SFH and MUR produce 32 bits. With HASH_64BIT, hashv is made of two runs
+ * of the 32-bit function under different initial values, the first giving
+ * the low half; otherwise only the first run is done. */
+#ifdef HASH_64BIT
+#define HASH_WIDEN32(fcn32,key,keylen,init_lo,init_hi,hashv)                     \
+do {                                                                             \
+  uint32_t _hw_lo, _hw_hi;                                                       \
+  fcn32(key,keylen,init_lo,_hw_lo);                                              \
+  fcn32(key,keylen,init_hi,_hw_hi);                                              \
+  hashv = HASH_JOIN32(_hw_hi, _hw_lo);                                           \
+} while(0)
+#else
+#define HASH_WIDEN32(fcn32,key,keylen,init_lo,init_hi,hashv)                     \
+do {                                                                             \
+  uint32_t _hw_lo;                                                               \
+  fcn32(key,keylen,init_lo,_hw_lo);                                              \
+  hashv = _hw_lo;                                                                \
+} while(0)
+#endif
+
 /* The Paul Hsieh hash function */
 #undef get16bits
 #if (defined(__GNUC__) && defined(__i386__)) || defined(__WATCOMC__)             \
@@ -448,14 +1619,14 @@ do {
 #define get16bits(d) ((((uint32_t)(((const uint8_t *)(d))[1])) << 8)             \
                        +(uint32_t)(((const uint8_t *)(d))[0]) )
 #endif
-#define HASH_SFH(key,keylen,num_bkts,hashv,bkt)                                  \
+#define HASH_SFH32(key,keylen,init,hashv)                                        \
 do {                                                                             \
   char *_sfh_key=(char*)(key);                                                   \
   uint32_t _sfh_tmp, _sfh_len = keylen;                                          \
                                                                                  \
   int _sfh_rem = _sfh_len & 3;                                                   \
   _sfh_len >>= 2;                                                                \
-  hashv = 0xcafebabe;                                                            \
+  hashv = (init);                                                                \
                                                                                  \
   /* Main loop */                                                                \
   for (;_sfh_len > 0; _sfh_len--) {                                              \
@@ -489,9 +1660,17 @@ do {
     hashv += hashv >> 17;                                                        \
     hashv ^= hashv << 25;                                                        \
     hashv += hashv >> 6;                                                         \
-    bkt = hashv & (num_bkts-1);                                                  \
 } while(0) 
 
+#define HASH_SFH(key,keylen,num_bkts,hashv,bkt)                                  \
+  HASH_SFH_SEED(key,keylen,num_bkts,hashv,bkt,0)
+#define HASH_SFH_SEED(key,keylen,num_bkts,hashv,bkt,seed)                        \
+do {                                                                             \
+  HASH_WIDEN32(HASH_SFH32,key,keylen,0xcafebabe ^ (uint32_t)(seed),              \
+               0x8badf00d ^ (uint32_t)((uint64_t)(seed) >> 32),hashv);           \
+  bkt = hashv & (num_bkts-1);                                                    \
+} while(0)
+
 #ifdef HASH_USING_NO_STRICT_ALIASING
 /* The MurmurHash exploits some CPU's (x86,x86_64) tolerance for unaligned reads.
  * For other types of CPU's (e.g. Sparc) an unaligned read causes a bus error.
@@ -534,11 +1713,11 @@ do {                 \
   _h ^= _h >> 16;    \
 } while(0)
 
-#define HASH_MUR(key,keylen,num_bkts,hashv,bkt)                        \
+#define HASH_MUR32(key,keylen,seed,hashv)                              \
 do {                                                                   \
   const uint8_t *_mur_data = (const uint8_t*)(key);                    \
   const int _mur_nblocks = (keylen) / 4;                               \
-  uint32_t _mur_h1 = 0xf88D5353;                                       \
+  uint32_t _mur_h1 = (seed);                                           \
   uint32_t _mur_c1 = 0xcc9e2d51;                                       \
   uint32_t _mur_c2 = 0x1b873593;                                       \
   const uint32_t *_mur_blocks = (const uint32_t*)(_mur_data+_mur_nblocks*4); \
@@ -567,53 +1746,1205 @@ do {                                                                   \
   _mur_h1 ^= (keylen);                                                 \
   MUR_FMIX(_mur_h1);                                                   \
   hashv = _mur_h1;                                                     \
+} while(0)
+
+#define HASH_MUR(key,keylen,num_bkts,hashv,bkt)                        \
+  HASH_MUR_SEED(key,keylen,num_bkts,hashv,bkt,0)
+#define HASH_MUR_SEED(key,keylen,num_bkts,hashv,bkt,seed)              \
+do {                                                                   \
+  HASH_WIDEN32(HASH_MUR32,key,keylen,0xf88D5353 ^ (uint32_t)(seed),    \
+               0x2545f491 ^ (uint32_t)((uint64_t)(seed) >> 32),hashv); \
   bkt = hashv & (num_bkts-1);                                          \
 } while(0)
 #endif  /* HASH_USING_NO_STRICT_ALIASING */
 
+/* The 64-bit functions below load the key a word at a time. memcpy makes
+ * those loads safe at any alignment; compilers turn it into a plain load
+ * where the CPU allows unaligned access. Words are read in host byte order,
+ * so hash values differ between little and big endian hosts. */
+#define HASH_READ64(p,v) memcpy(&(v),(p),8)
+#define HASH_READ32(p,v) memcpy(&(v),(p),4)
+#define HASH_ROTL64(x,r) (((x) << (r)) | ((x) >> (64 - (r))))
+
+/* full 64x64 bit multiply: a gets the low half of the product, b the high */
+#if defined(__SIZEOF_INT128__)
+#define HASH_MUM64(a,b)                                                          \
+do {                                                                             \
+  __uint128_t _mm_r = (__uint128_t)(a) * (b);                                    \
+  (a) = (uint64_t)_mm_r;                                                         \
+  (b) = (uint64_t)(_mm_r >> 64);                                                 \
+} while(0)
+#else
+#define HASH_MUM64(a,b)                                                          \
+do {                                                                             \
+  uint64_t _mm_ha = (a) >> 32, _mm_hb = (b) >> 32;                               \
+  uint64_t _mm_la = (uint32_t)(a), _mm_lb = (uint32_t)(b);                       \
+  uint64_t _mm_rh = _mm_ha * _mm_hb, _mm_rm0 = _mm_ha * _mm_lb;                  \
+  uint64_t _mm_rm1 = _mm_hb * _mm_la, _mm_rl = _mm_la * _mm_lb;                  \
+  uint64_t _mm_t = _mm_rl + (_mm_rm0 << 32), _mm_c = (_mm_t < _mm_rl);           \
+  uint64_t _mm_lo = _mm_t + (_mm_rm1 << 32);                                     \
+  _mm_c += (_mm_lo < _mm_t);                                                     \
+  (b) = _mm_rh + (_mm_rm0 >> 32) + (_mm_rm1 >> 32) + _mm_c;                      \
+  (a) = _mm_lo;                                                                  \
+} while(0)
+#endif
+
+/* xor of the halves of the 128-bit product of a and b */
+#define HASH_WY_MIX(a,b,out)                                                     \
+do {                                                                             \
+  uint64_t _wx_a = (a), _wx_b = (b);                                             \
+  HASH_MUM64(_wx_a,_wx_b);                                                       \
+  (out) = _wx_a ^ _wx_b;                                                         \
+} while(0)
+
+#define HASH_WY_S0 0x2d358dccaa6c78a5ULL
+#define HASH_WY_S1 0x8bb84b93962eacc9ULL
+#define HASH_WY_S2 0x4b33a62ed433d4a3ULL
+#define HASH_WY_S3 0x4d5a2da51de1aa47ULL
+
+/* wyhash (Wang Yi, final version 4) with its default secret. Each step
+ * folds 16 key bytes with a single 64x64->128 bit multiply. */
+#define HASH_WYH64(key,keylen,seed,out)                                          \
+do {                                                                             \
+  const uint8_t *_wy_p = (const uint8_t*)(key);                                  \
+  uint64_t _wy_len = (uint64_t)(keylen), _wy_i = _wy_len;                        \
+  uint64_t _wy_seed = (seed), _wy_a, _wy_b, _wy_see1, _wy_see2;                  \
+  uint32_t _wy_w;                                                                \
+  HASH_WY_MIX(_wy_seed ^ HASH_WY_S0, HASH_WY_S1, _wy_a);                         \
+  _wy_seed ^= _wy_a;                                                             \
+  if (_wy_len <= 16) {                                                           \
+    if (_wy_len >= 4) {                                                          \
+      HASH_READ32(_wy_p, _wy_w);                                                 \
+      _wy_a = (uint64_t)_wy_w << 32;                                             \
+      HASH_READ32(_wy_p + ((_wy_len >> 3) << 2), _wy_w);                         \
+      _wy_a |= _wy_w;                                                            \
+      HASH_READ32(_wy_p + _wy_len - 4, _wy_w);                                   \
+      _wy_b = (uint64_t)_wy_w << 32;                                             \
+      HASH_READ32(_wy_p + _wy_len - 4 - ((_wy_len >> 3) << 2), _wy_w);           \
+      _wy_b |= _wy_w;                                                            \
+    } else if (_wy_len > 0) {                                                    \
+      _wy_a = ((uint64_t)_wy_p[0] << 16) |                                       \
+              ((uint64_t)_wy_p[_wy_len >> 1] << 8) | _wy_p[_wy_len - 1];         \
+      _wy_b = 0;                                                                 \
+    } else {                                                                     \
+      _wy_a = _wy_b = 0;                                                         \
+    }                                                                            \
+  } else {                                                                       \
+    if (_wy_i > 48) {                                                            \
+      _wy_see1 = _wy_see2 = _wy_seed;                                            \
+      do {                                                                       \
+        HASH_READ64(_wy_p, _wy_a);                                               \
+        HASH_READ64(_wy_p + 8, _wy_b);                                           \
+        HASH_WY_MIX(_wy_a ^ HASH_WY_S1, _wy_b ^ _wy_seed, _wy_seed);             \
+        HASH_READ64(_wy_p + 16, _wy_a);                                          \
+        HASH_READ64(_wy_p + 24, _wy_b);                                          \
+        HASH_WY_MIX(_wy_a ^ HASH_WY_S2, _wy_b ^ _wy_see1, _wy_see1);             \
+        HASH_READ64(_wy_p + 32, _wy_a);                                          \
+        HASH_READ64(_wy_p + 40, _wy_b);                                          \
+        HASH_WY_MIX(_wy_a ^ HASH_WY_S3, _wy_b ^ _wy_see2, _wy_see2);             \
+        _wy_p += 48;                                                             \
+        _wy_i -= 48;                                                             \
+      } while (_wy_i > 48);                                                      \
+      _wy_seed ^= _wy_see1 ^ _wy_see2;                                           \
+    }                                                                            \
+    while (_wy_i > 16) {                                                         \
+      HASH_READ64(_wy_p, _wy_a);                                                 \
+      HASH_READ64(_wy_p + 8, _wy_b);                                             \
+      HASH_WY_MIX(_wy_a ^ HASH_WY_S1, _wy_b ^ _wy_seed, _wy_seed);               \
+      _wy_p += 16;                                                               \
+      _wy_i -= 16;                                                               \
+    }                                                                            \
+    HASH_READ64(_wy_p + _wy_i - 16, _wy_a);                                      \
+    HASH_READ64(_wy_p + _wy_i - 8, _wy_b);                                       \
+  }                                                                              \
+  _wy_a ^= HASH_WY_S1;                                                           \
+  _wy_b ^= _wy_seed;                                                             \
+  HASH_MUM64(_wy_a, _wy_b);                                                      \
+  HASH_WY_MIX(_wy_a ^ HASH_WY_S0 ^ _wy_len, _wy_b ^ HASH_WY_S1, out);            \
+} while(0)
+
+#define HASH_WYH(key,keylen,num_bkts,hashv,bkt)                                  \
+  HASH_WYH_SEED(key,keylen,num_bkts,hashv,bkt,0)
+#define HASH_WYH_SEED(key,keylen,num_bkts,hashv,bkt,seed)                        \
+do {                                                                             \
+  uint64_t _wyh_h;                                                               \
+  HASH_WYH64(key,keylen,(uint64_t)(seed),_wyh_h);                                \
+  hashv = (UT_hash_value)_wyh_h;                                                 \
+  bkt = hashv & (num_bkts-1);                                                    \
+} while(0)
+
+#define HASH_XXH_P1 11400714785074694791ULL
+#define HASH_XXH_P2 14029467366897019727ULL
+#define HASH_XXH_P3 1609587929392839161ULL
+#define HASH_XXH_P4 9650029242287828579ULL
+#define HASH_XXH_P5 2870177450012600261ULL
+#define HASH_XXH_ROUND(acc,input)                                                \
+do {                                                                             \
+  (acc) += (input) * HASH_XXH_P2;                                                \
+  (acc) = HASH_ROTL64((acc),31);                                                 \
+  (acc) *= HASH_XXH_P1;                                                          \
+} while(0)
+#define HASH_XXH_MERGE(h,v)                                                      \
+do {                                                                             \
+  uint64_t _xm_v = 0;                                                            \
+  HASH_XXH_ROUND(_xm_v,(v));                                                     \
+  (h) ^= _xm_v;                                                                  \
+  (h) = (h) * HASH_XXH_P1 + HASH_XXH_P4;                                         \
+} while(0)
+
+/* xxHash64 (Yann Collet), in portable scalar C. Keys of 32 bytes or more are
+ * consumed in 32-byte stripes by four independent accumulators, so the CPU
+ * can overlap their multiplies. Its rounds are 64x64 bit multiplies, which
+ * vector units lack, so it stays scalar; HASH_XX3 below is the successor
+ * designed for SSE2 and NEON. */
+#define HASH_XXH64(key,keylen,seed,out)                                          \
+do {                                                                             \
+  const uint8_t *_xx_p = (const uint8_t*)(key);                                  \
+  const uint8_t *_xx_end = _xx_p + (keylen);                                     \
+  uint64_t _xx_h, _xx_k, _xx_v1, _xx_v2, _xx_v3, _xx_v4;                         \
+  uint32_t _xx_w;                                                                \
+  if ((uint64_t)(keylen) >= 32) {                                                \
+    _xx_v1 = (seed) + HASH_XXH_P1 + HASH_XXH_P2;                                 \
+    _xx_v2 = (seed) + HASH_XXH_P2;                                               \
+    _xx_v3 = (seed);                                                             \
+    _xx_v4 = (seed) - HASH_XXH_P1;                                               \
+    do {                                                                         \
+      HASH_READ64(_xx_p, _xx_k);      HASH_XXH_ROUND(_xx_v1,_xx_k);              \
+      HASH_READ64(_xx_p + 8, _xx_k);  HASH_XXH_ROUND(_xx_v2,_xx_k);              \
+      HASH_READ64(_xx_p + 16, _xx_k); HASH_XXH_ROUND(_xx_v3,_xx_k);              \
+      HASH_READ64(_xx_p + 24, _xx_k); HASH_XXH_ROUND(_xx_v4,_xx_k);              \
+      _xx_p += 32;                                                               \
+    } while (_xx_p <= _xx_end - 32);                                             \
+    _xx_h = HASH_ROTL64(_xx_v1,1) + HASH_ROTL64(_xx_v2,7) +                      \
+            HASH_ROTL64(_xx_v3,12) + HASH_ROTL64(_xx_v4,18);                     \
+    HASH_XXH_MERGE(_xx_h,_xx_v1);                                                \
+    HASH_XXH_MERGE(_xx_h,_xx_v2);                                                \
+    HASH_XXH_MERGE(_xx_h,_xx_v3);                                                \
+    HASH_XXH_MERGE(_xx_h,_xx_v4);                                                \
+  } else {                                                                       \
+    _xx_h = (seed) + HASH_XXH_P5;                                                \
+  }                                                                              \
+  _xx_h += (uint64_t)(keylen);                                                   \
+  while (_xx_p + 8 <= _xx_end) {                                                 \
+    HASH_READ64(_xx_p, _xx_k);                                                   \
+    _xx_v1 = 0;                                                                  \
+    HASH_XXH_ROUND(_xx_v1,_xx_k);                                                \
+    _xx_h ^= _xx_v1;                                                             \
+    _xx_h = HASH_ROTL64(_xx_h,27) * HASH_XXH_P1 + HASH_XXH_P4;                   \
+    _xx_p += 8;                                                                  \
+  }                                                                              \
+  if (_xx_p + 4 <= _xx_end) {                                                    \
+    HASH_READ32(_xx_p, _xx_w);                                                   \
+    _xx_h ^= (uint64_t)_xx_w * HASH_XXH_P1;                                      \
+    _xx_h = HASH_ROTL64(_xx_h,23) * HASH_XXH_P2 + HASH_XXH_P3;                   \
+    _xx_p += 4;                                                                  \
+  }                                                                              \
+  while (_xx_p < _xx_end) {                                                      \
+    _xx_h ^= (*_xx_p) * HASH_XXH_P5;                                             \
+    _xx_h = HASH_ROTL64(_xx_h,11) * HASH_XXH_P1;                                 \
+    _xx_p++;                                                                     \
+  }                                                                              \
+  _xx_h ^= _xx_h >> 33;                                                          \
+  _xx_h *= HASH_XXH_P2;                                                          \
+  _xx_h ^= _xx_h >> 29;                                                          \
+  _xx_h *= HASH_XXH_P3;                                                          \
+  _xx_h ^= _xx_h >> 32;                                                          \
+  (out) = _xx_h;                                                                 \
+} while(0)
+
+#define HASH_XXH(key,keylen,num_bkts,hashv,bkt)                                  \
+  HASH_XXH_SEED(key,keylen,num_bkts,hashv,bkt,0)
+#define HASH_XXH_SEED(key,keylen,num_bkts,hashv,bkt,seed)                        \
+do {                                                                             \
+  uint64_t _xxh_h;                                                               \
+  HASH_XXH64(key,keylen,(uint64_t)(seed),_xxh_h);                                \
+  hashv = (UT_hash_value)_xxh_h;                                                 \
+  bkt = hashv & (num_bkts-1);                                                    \
+} while(0)
+
+/* XXH3, 64-bit (Yann Collet), the successor of xxHash64. Keys of up to 240
+ * bytes are mixed with the 192-byte default secret by folded 64x64 to 128
+ * bit multiplies, as HASH_WYH does. Longer keys are consumed in 64-byte
+ * stripes by eight 64-bit accumulators, whose round is a 32x32 to 64 bit
+ * multiply; SSE2 (_mm_mul_epu32) and NEON (vmull_u32) do two lanes of that
+ * at once, and are used when the compiler targets them (__SSE2__, or a
+ * little-endian __ARM_NEON). Otherwise, or with -DHASH_XX3_SCALAR, the same
+ * rounds run in scalar C, with the same result. A seed other than 0 is added
+ * into the secret, as XXH3_64bits_withSeed does. */
+#if !defined(HASH_XX3_SCALAR) && (defined(__SSE2__) || defined(_M_X64) ||        \
+    (defined(_M_IX86_FP) && (_M_IX86_FP >= 2)))
+#include <emmintrin.h>  /* SSE2 */
+#define HASH_XX3_SSE2
+#elif !defined(HASH_XX3_SCALAR) && defined(__ARM_NEON) &&                        \
+    (!defined(__BYTE_ORDER__) || (__BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__))
+#include <arm_neon.h>   /* NEON */
+#define HASH_XX3_NEON
+#endif
+#define HASH_XX3_P32_1 0x9E3779B1U
+#define HASH_XX3_P32_2 0x85EBCA77U
+#define HASH_XX3_P32_3 0xC2B2AE3DU
+#define HASH_XX3_MX1 0x165667919E3779F9ULL
+#define HASH_XX3_MX2 0x9FB21C651E98DF25ULL
+#define HASH_XX3_SECRET 192      /* bytes of the default secret            */
+#define HASH_XX3_BLOCK 1024      /* bytes between scrambles: 16 stripes    */
+#define HASH_XX3_SWAP32(x)                                                       \
+  ((((x) & 0xffU) << 24) | (((x) & 0xff00U) << 8) |                              \
+   (((x) >> 8) & 0xff00U) | ((x) >> 24))
+#define HASH_XX3_SWAP64(x)                                                       \
+  (((uint64_t)HASH_XX3_SWAP32((uint32_t)(x)) << 32) |                            \
+   HASH_XX3_SWAP32((uint32_t)((x) >> 32)))
+
+static const uint8_t uthash_xx3_secret[HASH_XX3_SECRET] = {
+  0xb8, 0xfe, 0x6c, 0x39, 0x23, 0xa4, 0x4b, 0xbe, 0x7c, 0x01, 0x81, 0x2c,
+  0xf7, 0x21, 0xad, 0x1c, 0xde, 0xd4, 0x6d, 0xe9, 0x83, 0x90, 0x97, 0xdb,
+  0x72, 0x40, 0xa4, 0xa4, 0xb7, 0xb3, 0x67, 0x1f, 0xcb, 0x79, 0xe6, 0x4e,
+  0xcc, 0xc0, 0xe5, 0x78, 0x82, 0x5a, 0xd0, 0x7d, 0xcc, 0xff, 0x72, 0x21,
+  0xb8, 0x08, 0x46, 0x74, 0xf7, 0x43, 0x24, 0x8e, 0xe0, 0x35, 0x90, 0xe6,
+  0x81, 0x3a, 0x26, 0x4c, 0x3c, 0x28, 0x52, 0xbb, 0x91, 0xc3, 0x00, 0xcb,
+  0x88, 0xd0, 0x65, 0x8b, 0x1b, 0x53, 0x2e, 0xa3, 0x71, 0x64, 0x48, 0x97,
+  0xa2, 0x0d, 0xf9, 0x4e, 0x38, 0x19, 0xef, 0x46, 0xa9, 0xde, 0xac, 0xd8,
+  0xa8, 0xfa, 0x76, 0x3f, 0xe3, 0x9c, 0x34, 0x3f, 0xf9, 0xdc, 0xbb, 0xc7,
+  0xc7, 0x0b, 0x4f, 0x1d, 0x8a, 0x51, 0xe0, 0x4b, 0xcd, 0xb4, 0x59, 0x31,
+  0xc8, 0x9f, 0x7e, 0xc9, 0xd9, 0x78, 0x73, 0x64, 0xea, 0xc5, 0xac, 0x83,
+  0x34, 0xd3, 0xeb, 0xc3, 0xc5, 0x81, 0xa0, 0xff, 0xfa, 0x13, 0x63, 0xeb,
+  0x17, 0x0d, 0xdd, 0x51, 0xb7, 0xf0, 0xda, 0x49, 0xd3, 0x16, 0x55, 0x26,
+  0x29, 0xd4, 0x68, 0x9e, 0x2b, 0x16, 0xbe, 0x58, 0x7d, 0x47, 0xa1, 0xfc,
+  0x8f, 0xf8, 0xb8, 0xd1, 0x7a, 0xd0, 0x31, 0xce, 0x45, 0xcb, 0x3a, 0x8f,
+  0x95, 0x16, 0x04, 0x28, 0xaf, 0xd7, 0xfb, 0xca, 0xbb, 0x4b, 0x40, 0x7e
+};
+
+static HASH_INLINE uint64_t uthash_xx3_read64(const uint8_t *p) {
+  uint64_t v;
+  HASH_READ64(p, v);
+  return v;
+}
+static HASH_INLINE uint32_t uthash_xx3_read32(const uint8_t *p) {
+  uint32_t v;
+  HASH_READ32(p, v);
+  return v;
+}
+/* xor of the halves of the 128-bit product of a and b */
+static HASH_INLINE uint64_t uthash_xx3_fold(uint64_t a, uint64_t b) {
+  HASH_MUM64(a, b);
+  return a ^ b;
+}
+static HASH_INLINE uint64_t uthash_xx3_avalanche(uint64_t h) {
+  h ^= h >> 37;
+  h *= HASH_XX3_MX1;
+  return h ^ (h >> 32);
+}
+/* the final mix of xxHash64 */
+static HASH_INLINE uint64_t uthash_xx3_avalanche64(uint64_t h) {
+  h ^= h >> 33;
+  h *= HASH_XXH_P2;
+  h ^= h >> 29;
+  h *= HASH_XXH_P3;
+  return h ^ (h >> 32);
+}
+static HASH_INLINE uint64_t uthash_xx3_mix16(const uint8_t *p, const uint8_t *s,
+                                             uint64_t seed) {
+  return uthash_xx3_fold(uthash_xx3_read64(p) ^ (uthash_xx3_read64(s) + seed),
+                         uthash_xx3_read64(p + 8) ^
+                         (uthash_xx3_read64(s + 8) - seed));
+}
+
+/* n stripes of 64 bytes into the accumulators, the secret advancing by 8
+ * bytes a stripe; then the scramble at the end of a block */
+static HASH_INLINE void uthash_xx3_stripes_scalar(uint64_t *acc,
+                          const uint8_t *p, const uint8_t *s, size_t n) {
+  size_t i;
+  unsigned l;
+  uint64_t v, k;
+  for (i = 0; i < n; i++, p += 64, s += 8) {
+    for (l = 0; l < 8; l++) {
+      v = uthash_xx3_read64(p + 8 * l);
+      k = v ^ uthash_xx3_read64(s + 8 * l);
+      acc[l ^ 1] += v;
+      acc[l] += (uint64_t)(uint32_t)k * (k >> 32);
+    }
+  }
+}
+static HASH_INLINE void uthash_xx3_scramble_scalar(uint64_t *acc,
+                                                   const uint8_t *s) {
+  unsigned l;
+  uint64_t a;
+  for (l = 0; l < 8; l++) {
+    a = acc[l];
+    a ^= a >> 47;
+    a ^= uthash_xx3_read64(s + 8 * l);
+    acc[l] = a * HASH_XX3_P32_1;
+  }
+}
+/* every stripe of a key longer than 240 bytes: the whole blocks, the
+ * stripes of the last one, and the last 64 bytes as a final stripe */
+static HASH_INLINE void uthash_xx3_long_scalar(uint64_t *acc, const uint8_t *p,
+                                               size_t len, const uint8_t *s) {
+  size_t b, nb = (len - 1) / HASH_XX3_BLOCK;
+  for (b = 0; b < nb; b++) {
+    uthash_xx3_stripes_scalar(acc, p + b * HASH_XX3_BLOCK, s, 16);
+    uthash_xx3_scramble_scalar(acc, s + HASH_XX3_SECRET - 64);
+  }
+  uthash_xx3_stripes_scalar(acc, p + nb * HASH_XX3_BLOCK, s,
+                            ((len - 1) - nb * HASH_XX3_BLOCK) / 64);
+  uthash_xx3_stripes_scalar(acc, p + len - 64, s + HASH_XX3_SECRET - 64 - 7, 1);
+}
+
+#ifdef HASH_XX3_SSE2
+/* two accumulators a register: _mm_mul_epu32 multiplies the low 32 bits of
+ * each 64-bit lane, so the high halves are shuffled down to meet them */
+static HASH_INLINE void uthash_xx3_stripes_sse2(__m128i *acc,
+                          const uint8_t *p, const uint8_t *s, size_t n) {
+  size_t i;
+  unsigned l;
+  __m128i d, k;
+  for (i = 0; i < n; i++, p += 64, s += 8) {
+    for (l = 0; l < 4; l++) {
+      d = _mm_loadu_si128((const __m128i*)(const void*)(p + 16 * l));
+      k = _mm_xor_si128(d,
+            _mm_loadu_si128((const __m128i*)(const void*)(s + 16 * l)));
+      acc[l] = _mm_add_epi64(acc[l],
+                 _mm_shuffle_epi32(d, _MM_SHUFFLE(1,0,3,2)));
+      acc[l] = _mm_add_epi64(acc[l],
+                 _mm_mul_epu32(k, _mm_shuffle_epi32(k, _MM_SHUFFLE(0,3,0,1))));
+    }
+  }
+}
+static HASH_INLINE void uthash_xx3_scramble_sse2(__m128i *acc,
+                                                 const uint8_t *s) {
+  unsigned l;
+  __m128i a, prime = _mm_set1_epi32((int)HASH_XX3_P32_1);
+  for (l = 0; l < 4; l++) {
+    a = _mm_xor_si128(acc[l], _mm_srli_epi64(acc[l], 47));
+    a = _mm_xor_si128(a,
+          _mm_loadu_si128((const __m128i*)(const void*)(s + 16 * l)));
+    acc[l] = _mm_add_epi64(_mm_mul_epu32(a, prime),
+               _mm_slli_epi64(_mm_mul_epu32(
+                 _mm_shuffle_epi32(a, _MM_SHUFFLE(0,3,0,1)), prime), 32));
+  }
+}
+static HASH_INLINE void uthash_xx3_long_simd(uint64_t *acc, const uint8_t *p,
+                                             size_t len, const uint8_t *s) {
+  size_t b, nb = (len - 1) / HASH_XX3_BLOCK;
+  unsigned l;
+  __m128i v[4];
+  for (l = 0; l < 4; l++) {
+    v[l] = _mm_loadu_si128((const __m128i*)(void*)(acc + 2 * l));
+  }
+  for (b = 0; b < nb; b++) {
+    uthash_xx3_stripes_sse2(v, p + b * HASH_XX3_BLOCK, s, 16);
+    uthash_xx3_scramble_sse2(v, s + HASH_XX3_SECRET - 64);
+  }
+  uthash_xx3_stripes_sse2(v, p + nb * HASH_XX3_BLOCK, s,
+                          ((len - 1) - nb * HASH_XX3_BLOCK) / 64);
+  uthash_xx3_stripes_sse2(v, p + len - 64, s + HASH_XX3_SECRET - 64 - 7, 1);
+  for (l = 0; l < 4; l++) {
+    _mm_storeu_si128((__m128i*)(void*)(acc + 2 * l), v[l]);
+  }
+}
+#define HASH_XX3_SIMD 1
+#elif defined(HASH_XX3_NEON)
+/* two accumulators a register: vmlal_u32 multiplies the narrowed low and
+ * high halves of each 64-bit lane, and adds the product */
+static HASH_INLINE void uthash_xx3_stripes_neon(uint64x2_t *acc,
+                          const uint8_t *p, const uint8_t *s, size_t n) {
+  size_t i;
+  unsigned l;
+  uint64x2_t d, k;
+  for (i = 0; i < n; i++, p += 64, s += 8) {
+    for (l = 0; l < 4; l++) {
+      d = vreinterpretq_u64_u8(vld1q_u8(p + 16 * l));
+      k = veorq_u64(d, vreinterpretq_u64_u8(vld1q_u8(s + 16 * l)));
+      acc[l] = vaddq_u64(acc[l], vextq_u64(d, d, 1));
+      acc[l] = vmlal_u32(acc[l], vmovn_u64(k), vshrn_n_u64(k, 32));
+    }
+  }
+}
+static HASH_INLINE void uthash_xx3_scramble_neon(uint64x2_t *acc,
+                                                 const uint8_t *s) {
+  unsigned l;
+  uint64x2_t a;
+  uint32x2_t prime = vdup_n_u32(HASH_XX3_P32_1);
+  for (l = 0; l < 4; l++) {
+    a = veorq_u64(acc[l], vshrq_n_u64(acc[l], 47));
+    a = veorq_u64(a, vreinterpretq_u64_u8(vld1q_u8(s + 16 * l)));
+    acc[l] = vmlal_u32(vshlq_n_u64(vmull_u32(vshrn_n_u64(a, 32), prime), 32),
+                       vmovn_u64(a), prime);
+  }
+}
+static HASH_INLINE void uthash_xx3_long_simd(uint64_t *acc, const uint8_t *p,
+                                             size_t len, const uint8_t *s) {
+  size_t b, nb = (len - 1) / HASH_XX3_BLOCK;
+  unsigned l;
+  uint64x2_t v[4];
+  for (l = 0; l < 4; l++) v[l] = vld1q_u64(acc + 2 * l);
+  for (b = 0; b < nb; b++) {
+    uthash_xx3_stripes_neon(v, p + b * HASH_XX3_BLOCK, s, 16);
+    uthash_xx3_scramble_neon(v, s + HASH_XX3_SECRET - 64);
+  }
+  uthash_xx3_stripes_neon(v, p + nb * HASH_XX3_BLOCK, s,
+                          ((len - 1) - nb * HASH_XX3_BLOCK) / 64);
+  uthash_xx3_stripes_neon(v, p + len - 64, s + HASH_XX3_SECRET - 64 - 7, 1);
+  for (l = 0; l < 4; l++) vst1q_u64(acc + 2 * l, v[l]);
+}
+#define HASH_XX3_SIMD 1
+#else
+#define uthash_xx3_long_simd uthash_xx3_long_scalar
+#define HASH_XX3_SIMD 0
+#endif
+
+/* XXH3_64bits_withSeed; simd selects the vector rounds, where there are
+ * any, for keys over 240 bytes */
+static HASH_INLINE uint64_t uthash_xx3_hash(const void *key, size_t len,
+                                            uint64_t seed, int simd) {
+  const uint8_t *p = (const uint8_t*)key, *s = uthash_xx3_secret;
+  uint8_t custom[HASH_XX3_SECRET];
+  uint64_t acc[8], h, lo, hi;
+  size_t i;
+  if (len <= 16) {
+    if (len > 8) {
+      lo = uthash_xx3_read64(p) ^
+           ((uthash_xx3_read64(s + 24) ^ uthash_xx3_read64(s + 32)) + seed);
+      hi = uthash_xx3_read64(p + len - 8) ^
+           ((uthash_xx3_read64(s + 40) ^ uthash_xx3_read64(s + 48)) - seed);
+      return uthash_xx3_avalanche(len + HASH_XX3_SWAP64(lo) + hi +
+                                  uthash_xx3_fold(lo, hi));
+    }
+    if (len >= 4) {
+      seed ^= (uint64_t)HASH_XX3_SWAP32((uint32_t)seed) << 32;
+      h = (uthash_xx3_read32(p + len - 4) +
+           ((uint64_t)uthash_xx3_read32(p) << 32)) ^
+          ((uthash_xx3_read64(s + 8) ^ uthash_xx3_read64(s + 16)) - seed);
+      h ^= HASH_ROTL64(h, 49) ^ HASH_ROTL64(h, 24);
+      h *= HASH_XX3_MX2;
+      h ^= (h >> 35) + len;
+      h *= HASH_XX3_MX2;
+      return h ^ (h >> 28);
+    }
+    if (len > 0) {
+      h = ((uint32_t)p[0] << 16) | ((uint32_t)p[len >> 1] << 24) |
+          (uint32_t)p[len - 1] | ((uint32_t)len << 8);
+      return uthash_xx3_avalanche64(h ^ ((uint64_t)(uthash_xx3_read32(s) ^
+                                    uthash_xx3_read32(s + 4)) + seed));
+    }
+    return uthash_xx3_avalanche64(seed ^ uthash_xx3_read64(s + 56) ^
+                                  uthash_xx3_read64(s + 64));
+  }
+  if (len <= 128) {
+    h = len * HASH_XXH_P1;
+    if (len > 32) {
+      if (len > 64) {
+        if (len > 96) {
+          h += uthash_xx3_mix16(p + 48, s + 96, seed);
+          h += uthash_xx3_mix16(p + len - 64, s + 112, seed);
+        }
+        h += uthash_xx3_mix16(p + 32, s + 64, seed);
+        h += uthash_xx3_mix16(p + len - 48, s + 80, seed);
+      }
+      h += uthash_xx3_mix16(p + 16, s + 32, seed);
+      h += uthash_xx3_mix16(p + len - 32, s + 48, seed);
+    }
+    h += uthash_xx3_mix16(p, s, seed);
+    h += uthash_xx3_mix16(p + len - 16, s + 16, seed);
+    return uthash_xx3_avalanche(h);
+  }
+  if (len <= 240) {
+    h = len * HASH_XXH_P1;
+    for (i = 0; i < 8; i++) h += uthash_xx3_mix16(p + 16 * i, s + 16 * i, seed);
+    h = uthash_xx3_avalanche(h);
+    for (i = 8; i < len / 16; i++) {
+      h += uthash_xx3_mix16(p + 16 * i, s + 16 * (i - 8) + 3, seed);
+    }
+    h += uthash_xx3_mix16(p + len - 16, s + 136 - 17, seed);
+    return uthash_xx3_avalanche(h);
+  }
+  if (seed) {
+    for (i = 0; i < HASH_XX3_SECRET; i += 16) {
+      lo = uthash_xx3_read64(s + i) + seed;
+      hi = uthash_xx3_read64(s + i + 8) - seed;
+      memcpy(custom + i, &lo, 8);
+      memcpy(custom + i + 8, &hi, 8);
+    }
+    s = custom;
+  }
+  acc[0] = HASH_XX3_P32_3; acc[1] = HASH_XXH_P1; acc[2] = HASH_XXH_P2;
+  acc[3] = HASH_XXH_P3;    acc[4] = HASH_XXH_P4; acc[5] = HASH_XX3_P32_2;
+  acc[6] = HASH_XXH_P5;    acc[7] = HASH_XX3_P32_1;
+  if (simd) {
+    uthash_xx3_long_simd(acc, p, len, s);
+  } else {
+    uthash_xx3_long_scalar(acc, p, len, s);
+  }
+  h = len * HASH_XXH_P1;
+  for (i = 0; i < 4; i++) {
+    h += uthash_xx3_fold(acc[2 * i] ^ uthash_xx3_read64(s + 11 + 16 * i),
+                         acc[2 * i + 1] ^ uthash_xx3_read64(s + 19 + 16 * i));
+  }
+  return uthash_xx3_avalanche(h);
+}
+
+#define HASH_XXH3_64(key,keylen,seed,out)                                        \
+  ((out) = uthash_xx3_hash((key), (size_t)(keylen), (uint64_t)(seed),            \
+                           HASH_XX3_SIMD))
+#define HASH_XX3(key,keylen,num_bkts,hashv,bkt)                                  \
+  HASH_XX3_SEED(key,keylen,num_bkts,hashv,bkt,0)
+#define HASH_XX3_SEED(key,keylen,num_bkts,hashv,bkt,seed)                        \
+do {                                                                             \
+  uint64_t _xx3_h;                                                               \
+  HASH_XXH3_64(key,keylen,seed,_xx3_h);                                          \
+  hashv = (UT_hash_value)_xx3_h;                                                 \
+  bkt = hashv & (num_bkts-1);                                                    \
+} while(0)
+
+#define HASH_SIP_ROUND(v0,v1,v2,v3)                                              \
+do {                                                                             \
+  (v0) += (v1); (v1) = HASH_ROTL64((v1),13); (v1) ^= (v0);                       \
+  (v0) = HASH_ROTL64((v0),32);                                                   \
+  (v2) += (v3); (v3) = HASH_ROTL64((v3),16); (v3) ^= (v2);                       \
+  (v0) += (v3); (v3) = HASH_ROTL64((v3),21); (v3) ^= (v0);                       \
+  (v2) += (v1); (v1) = HASH_ROTL64((v1),17); (v1) ^= (v2);                       \
+  (v2) = HASH_ROTL64((v2),32);                                                   \
+} while(0)
+
+/* SipHash-2-4 (Aumasson and Bernstein) under the 128-bit key k0,k1. It is a
+ * keyed pseudorandom function: without the key, colliding keys cannot be
+ * found any faster than by trial. The seeded form keys it with (seed,~seed),
+ * as a table has a 64-bit seed: the key then holds 64 bits of entropy, not
+ * 128, which still leaves 2^64 keys to try. */
+#define HASH_SIP64(key,keylen,k0,k1,out)                                         \
+do {                                                                             \
+  const uint8_t *_sp_p = (const uint8_t*)(key);                                  \
+  uint64_t _sp_len = (uint64_t)(keylen), _sp_i, _sp_m, _sp_b;                    \
+  uint64_t _sp_v0 = (k0) ^ 0x736f6d6570736575ULL;                                \
+  uint64_t _sp_v1 = (k1) ^ 0x646f72616e646f6dULL;                                \
+  uint64_t _sp_v2 = (k0) ^ 0x6c7967656e657261ULL;                                \
+  uint64_t _sp_v3 = (k1) ^ 0x7465646279746573ULL;                                \
+  for (_sp_i = 0; _sp_i + 8 <= _sp_len; _sp_i += 8) {                            \
+    HASH_READ64(_sp_p + _sp_i, _sp_m);                                           \
+    _sp_v3 ^= _sp_m;                                                             \
+    HASH_SIP_ROUND(_sp_v0,_sp_v1,_sp_v2,_sp_v3);                                 \
+    HASH_SIP_ROUND(_sp_v0,_sp_v1,_sp_v2,_sp_v3);                                 \
+    _sp_v0 ^= _sp_m;                                                             \
+  }                                                                              \
+  _sp_b = _sp_len << 56;                                                         \
+  switch (_sp_len & 7) {                                                         \
+    case 7: _sp_b |= (uint64_t)_sp_p[_sp_i+6] << 48;                             \
+    case 6: _sp_b |= (uint64_t)_sp_p[_sp_i+5] << 40;                             \
+    case 5: _sp_b |= (uint64_t)_sp_p[_sp_i+4] << 32;                             \
+    case 4: _sp_b |= (uint64_t)_sp_p[_sp_i+3] << 24;                             \
+    case 3: _sp_b |= (uint64_t)_sp_p[_sp_i+2] << 16;                             \
+    case 2: _sp_b |= (uint64_t)_sp_p[_sp_i+1] << 8;                              \
+    case 1: _sp_b |= (uint64_t)_sp_p[_sp_i];                                     \
+  }                                                                              \
+  _sp_v3 ^= _sp_b;                                                               \
+  HASH_SIP_ROUND(_sp_v0,_sp_v1,_sp_v2,_sp_v3);                                   \
+  HASH_SIP_ROUND(_sp_v0,_sp_v1,_sp_v2,_sp_v3);                                   \
+  _sp_v0 ^= _sp_b;                                                               \
+  _sp_v2 ^= 0xff;                                                                \
+  HASH_SIP_ROUND(_sp_v0,_sp_v1,_sp_v2,_sp_v3);                                   \
+  HASH_SIP_ROUND(_sp_v0,_sp_v1,_sp_v2,_sp_v3);                                   \
+  HASH_SIP_ROUND(_sp_v0,_sp_v1,_sp_v2,_sp_v3);                                   \
+  HASH_SIP_ROUND(_sp_v0,_sp_v1,_sp_v2,_sp_v3);                                   \
+  (out) = _sp_v0 ^ _sp_v1 ^ _sp_v2 ^ _sp_v3;                                     \
+} while(0)
+
+#define HASH_SIP(key,keylen,num_bkts,hashv,bkt)                                  \
+  HASH_SIP_SEED(key,keylen,num_bkts,hashv,bkt,0)
+#define HASH_SIP_SEED(key,keylen,num_bkts,hashv,bkt,seed)                        \
+do {                                                                             \
+  uint64_t _sip_h;                                                               \
+  HASH_SIP64(key,keylen,(uint64_t)(seed),~(uint64_t)(seed),_sip_h);              \
+  hashv = (UT_hash_value)_sip_h;                                                 \
+  bkt = hashv & (num_bkts-1);                                                    \
+} while(0)
+
+/* With -DHASH_SEEDED every table has its own 64-bit seed, which is taken
+ * from uthash_seed when the table is made, and the hash function is applied
+ * in its _SEED form. A key then hashes differently in each table and in
+ * each run, so a key set that collides cannot be prepared in advance. A
+ * custom HASH_FUNCTION X must come with an X_SEED form to be used here. */
+#define HASH_PASTE(a,b) a##b
+#define HASH_XPASTE(a,b) HASH_PASTE(a,b)
+#ifdef HASH_SEEDED
+#define HASH_FCN_DEFAULT(tbl,key,keylen,num_bkts,hashv,bkt)                      \
+  HASH_XPASTE(HASH_FCN,_SEED)(key,keylen,num_bkts,hashv,bkt,(tbl)->seed)
+#define HASH_TBL_SEED(tbl) ((tbl)->seed)
+
+/* The default seed comes from the operating system's random source:
+ * getrandom() on Linux, arc4random_buf() on the BSDs and macOS, or else
+ * /dev/urandom. Only where none of these can be used does it fall back to
+ * mixing the table address (randomized where the OS uses ASLR), the
+ * previous seed, the time and the CPU clock, which an attacker can largely
+ * guess; such a program should define uthash_seed itself. */
+static HASH_INLINE uint64_t uthash_seed_default(const void *tbl,
+                                                 uint64_t prev) {
+  uint64_t seed;
+#if defined(HASH_ENTROPY_GETRANDOM)
+  if (getrandom(&seed, sizeof(seed), 0) == (ssize_t)sizeof(seed)) return seed;
+#elif defined(HASH_ENTROPY_ARC4RANDOM)
+  arc4random_buf(&seed, sizeof(seed));
+  return seed;
+#elif defined(HASH_ENTROPY_URANDOM)
+  int fd = open("/dev/urandom", O_RDONLY);
+  if (fd >= 0) {
+    ssize_t n = read(fd, &seed, sizeof(seed));
+    close(fd);
+    if (n == (ssize_t)sizeof(seed)) return seed;
+  }
+#endif
+  seed = (((uint64_t)(size_t)tbl ^ prev) * 0x9e3779b97f4a7c15ULL) ^
+         ((uint64_t)time(NULL) * 0xbf58476d1ce4e5b9ULL) ^
+         ((uint64_t)clock() * 0x94d049bb133111ebULL);
+  return seed;
+}
+#define HASH_SEED_DEFAULT(tbl) uthash_seed_default((tbl), (tbl)->seed)
+
+/* draw a new seed for tbl, passed through the splitmix64 finalizer */
+#define HASH_NEW_SEED(tbl)                                                       \
+do {                                                                             \
+  (tbl)->seed = uthash_seed(tbl);                                                \
+  (tbl)->seed = ((tbl)->seed ^ ((tbl)->seed >> 30)) * 0xbf58476d1ce4e5b9ULL;     \
+  (tbl)->seed = ((tbl)->seed ^ ((tbl)->seed >> 27)) * 0x94d049bb133111ebULL;     \
+  (tbl)->seed ^= (tbl)->seed >> 31;                                              \
+} while(0)
+#else
+#define HASH_FCN_DEFAULT(tbl,key,keylen,num_bkts,hashv,bkt)                      \
+  HASH_FCN(key,keylen,num_bkts,hashv,bkt)
+#define HASH_TBL_SEED(tbl) 0
+#define HASH_NEW_SEED(tbl)
+#endif
+
+/* With -DHASH_TABLE_FCN each table may have its own hash function, a
+ * UT_hash_fcn pointer set by HASH_SET_FCN. A NULL pointer, the initial
+ * value, selects HASH_FCN, which is still expanded inline; so a table that
+ * keeps the default pays only for the test of its pointer. */
+#ifdef HASH_TABLE_FCN
+#define HASH_FCN_TBL(tbl,key,keylen,num_bkts,hashv,bkt)                          \
+do {                                                                             \
+  if ((tbl)->fcn) {                                                              \
+    (tbl)->fcn(key, (UT_hash_size)(keylen), HASH_TBL_SEED(tbl), &(hashv));       \
+    bkt = (hashv) & ((num_bkts)-1);                                              \
+  } else {                                                                       \
+    HASH_FCN_DEFAULT(tbl,key,keylen,num_bkts,hashv,bkt);                         \
+  }                                                                              \
+} while(0)
+
+/* HASH_FCN_DEFINE(name,fcn_seed) defines a UT_hash_fcn named name which
+ * applies the hash macro fcn_seed, a function in its _SEED form. */
+#define HASH_FCN_DEFINE(name,fcn_seed)                                           \
+static HASH_INLINE void name(const void *key, UT_hash_size keylen,               \
+                             uint64_t seed, UT_hash_value *hashv) {              \
+  UT_hash_value _hd_hashv;                                                       \
+  UT_hash_size _hd_bkt;                                                          \
+  fcn_seed(key,keylen,1,_hd_hashv,_hd_bkt,seed);                                 \
+  (void)_hd_bkt;                                                                 \
+  *hashv = _hd_hashv;                                                            \
+}
+#ifdef HASH_SEEDED
+HASH_FCN_DEFINE(uthash_fcn_default, HASH_XPASTE(HASH_FCN,_SEED))
+#else
+#define HASH_FCN_UNSEEDED(key,keylen,num_bkts,hashv,bkt,seed)                    \
+  HASH_FCN(key,keylen,num_bkts,hashv,bkt)
+HASH_FCN_DEFINE(uthash_fcn_default, HASH_FCN_UNSEEDED)
+#endif
+HASH_FCN_DEFINE(uthash_fcn_jen, HASH_JEN_SEED)
+HASH_FCN_DEFINE(uthash_fcn_ber, HASH_BER_SEED)
+HASH_FCN_DEFINE(uthash_fcn_sax, HASH_SAX_SEED)
+HASH_FCN_DEFINE(uthash_fcn_oat, HASH_OAT_SEED)
+HASH_FCN_DEFINE(uthash_fcn_fnv, HASH_FNV_SEED)
+HASH_FCN_DEFINE(uthash_fcn_sfh, HASH_SFH_SEED)
+HASH_FCN_DEFINE(uthash_fcn_wyh, HASH_WYH_SEED)
+HASH_FCN_DEFINE(uthash_fcn_xxh, HASH_XXH_SEED)
+HASH_FCN_DEFINE(uthash_fcn_xx3, HASH_XX3_SEED)
+HASH_FCN_DEFINE(uthash_fcn_sip, HASH_SIP_SEED)
+#ifdef HASH_USING_NO_STRICT_ALIASING
+HASH_FCN_DEFINE(uthash_fcn_mur, HASH_MUR_SEED)
+#endif
+#else
+#define HASH_FCN_TBL(tbl,key,keylen,num_bkts,hashv,bkt)                          \
+  HASH_FCN_DEFAULT(tbl,key,keylen,num_bkts,hashv,bkt)
+#endif
+
+/* give hhp the hashv of its key under the hash function and seed of tbl */
+#define HASH_REHASH_HH(tbl,hhp)                                                  \
+do {                                                                             \
+  UT_hash_size _hrh_bkt;                                                         \
+  HASH_FCN_TBL(tbl,HASH_HH_KEY(hhp),(hhp)->keylen,(tbl)->num_buckets,            \
+               (hhp)->hashv,_hrh_bkt);                                           \
+  (void)_hrh_bkt;                                                                \
+} while(0)
+
+/* HASH_SELECT reuses the hashv from the source table, unless the tables
+ * can differ in seed or hash function */
+#if defined(HASH_SEEDED) || defined(HASH_TABLE_FCN)
+#define HASH_SELECT_HASHV(tbl,hhp) HASH_REHASH_HH(tbl,hhp)
+#else
+#define HASH_SELECT_HASHV(tbl,hhp)
+#endif
+
 /* key comparison function; return 0 if keys equal */
 #define HASH_KEYCMP(a,b,len) memcmp(a,b,len) 
 
-/* iterate over items in a known bucket to find desired item */
-#define HASH_FIND_IN_BKT(tbl,hh,head,keyptr,keylen_in,out)                       \
+/* iterate over items in a known bucket to find desired item. The stored hashv
+ * is compared first; it sits beside keylen in the handle and rejects almost
+ * every non-matching item without touching its key. */
+#define HASH_FIND_IN_CHAIN(tbl,hh,head,keyptr,keylen_in,hashval,out)             \
+do {                                                                             \
+ struct UT_hash_handle *_hfc_thh = HASH_BKT_HEAD(&(head));                       \
+ out=NULL;                                                                       \
+ while (_hfc_thh) {                                                              \
+    if ((_hfc_thh->hashv == (hashval)) && (_hfc_thh->keylen == keylen_in) &&     \
+        (HASH_KEYCMP(HASH_HH_KEY(_hfc_thh),keyptr,keylen_in) == 0)) {            \
+        DECLTYPE_ASSIGN(out,ELMT_FROM_HH(tbl,_hfc_thh));                         \
+        break;                                                                   \
+    }                                                                            \
+    _hfc_thh = HASH_HH_CHAIN_NEXT(tbl,_hfc_thh);                                 \
+ }                                                                               \
+} while(0)
+
+/* When compiled with -DHASH_FINGERPRINT, each bucket also carries a small
+ * inline array of (hashv, handle) pairs. As long as the chain holds no more
+ * than HASH_FP_SLOTS items, the slots mirror it exactly, so a lookup can
+ * reject every non-matching item by scanning the bucket alone, without
+ * dereferencing a single handle. Longer chains fall back to the chain walk. */
+#ifdef HASH_FINGERPRINT
+#ifndef HASH_FP_SLOTS
+#define HASH_FP_SLOTS 4      /* 4 slots fill a 64-byte bucket on 64-bit hosts */
+#endif
+/* the slots keep 32 bits of each hashv; with 64-bit hash values, the high
+ * half, since the low half is mostly the bucket index that they share */
+#ifdef HASH_64BIT
+#define HASH_FP_OF(hashv) ((uint32_t)((hashv) >> 32))
+#else
+#define HASH_FP_OF(hashv) (hashv)
+#endif
+#define HASH_FIND_IN_BKT(tbl,hh,head,keyptr,keylen_in,hashval,out)               \
+do {                                                                             \
+ unsigned _hf_i;                                                                 \
+ UT_hash_bucket *_hf_b = &(head);                                                \
+ out=NULL;                                                                       \
+ if (_hf_b->count <= HASH_FP_SLOTS) {                                            \
+    for(_hf_i=0; _hf_i < _hf_b->count; _hf_i++) {                                \
+       if ((_hf_b->fp[_hf_i] == HASH_FP_OF(hashval)) &&                          \
+           (_hf_b->fp_hh[_hf_i]->keylen == keylen_in) &&                         \
+           (HASH_KEYCMP(HASH_HH_KEY(_hf_b->fp_hh[_hf_i]),keyptr,keylen_in)==0)) {\
+          DECLTYPE_ASSIGN(out,ELMT_FROM_HH(tbl,_hf_b->fp_hh[_hf_i]));            \
+          break;                                                                 \
+       }                                                                         \
+    }                                                                            \
+ } else {                                                                        \
+    HASH_FIND_IN_CHAIN(tbl,hh,(*_hf_b),keyptr,keylen_in,hashval,out);            \
+ }                                                                               \
+} while(0)
+
+/* record addhh in the slots; the bucket count has already been incremented */
+#define HASH_FP_ADD(head,addhh)                                                  \
+do {                                                                             \
+  if ((head).count <= HASH_FP_SLOTS) {                                           \
+    (head).fp[(head).count-1] = HASH_FP_OF((addhh)->hashv);                      \
+    (head).fp_hh[(head).count-1] = (addhh);                                      \
+  }                                                                              \
+} while(0)
+
+/* refill the slots from the chain, used once a long chain fits again */
+#define HASH_FP_FILL(head)                                                       \
+do {                                                                             \
+  unsigned _fpf_i = 0;                                                           \
+  struct UT_hash_handle *_fpf_thh;                                               \
+  for(_fpf_thh = HASH_BKT_HEAD(&(head)); _fpf_thh;                               \
+      _fpf_thh = HASH_HH_CHAIN_NEXT(HASH_HH_TBL(_fpf_thh), _fpf_thh)) {          \
+    (head).fp[_fpf_i] = HASH_FP_OF(_fpf_thh->hashv);                             \
+    (head).fp_hh[_fpf_i++] = _fpf_thh;                                           \
+  }                                                                              \
+} while(0)
+
+/* forget hh_del, which is already unlinked and no longer counted. If the
+ * chain was short its slot is overwritten by the last one; if the chain
+ * has just shrunk back to HASH_FP_SLOTS items the slots are rebuilt. */
+#define HASH_FP_DEL(head,hh_del)                                                 \
+do {                                                                             \
+  unsigned _fpd_i;                                                               \
+  if ((head).count < HASH_FP_SLOTS) {                                            \
+    for(_fpd_i=0; _fpd_i < (head).count; _fpd_i++) {                             \
+      if ((head).fp_hh[_fpd_i] == (hh_del)) break;                               \
+    }                                                                            \
+    (head).fp[_fpd_i] = (head).fp[(head).count];                                 \
+    (head).fp_hh[_fpd_i] = (head).fp_hh[(head).count];                           \
+  } else if ((head).count == HASH_FP_SLOTS) {                                    \
+    HASH_FP_FILL(head);                                                          \
+  }                                                                              \
+} while(0)
+#else
+#define HASH_FIND_IN_BKT(tbl,hh,head,keyptr,keylen_in,hashval,out)               \
+    HASH_FIND_IN_CHAIN(tbl,hh,head,keyptr,keylen_in,hashval,out)
+#define HASH_FP_ADD(head,addhh)
+#define HASH_FP_DEL(head,hh_del)
+#endif
+
+/* add an item to a bucket  */
+#define HASH_ADD_TO_BKT(head,addhh)                                              \
+do {                                                                             \
+ head.count++;                                                                   \
+ HASH_HH_SET_CHAIN_NEXT(HASH_HH_TBL(addhh), addhh, HASH_BKT_HEAD(&(head)));      \
+ HASH_HH_LINK_CHAIN_PREV(addhh);                                                 \
+ HASH_BKT_SET_HEAD(&(head), addhh);                                              \
+ HASH_FP_ADD(head,addhh);                                                        \
+ if (head.count >= ((head.expand_mult+1) * HASH_BKT_CAPACITY_THRESH)             \
+     && HASH_HH_TBL(addhh)->noexpand != 1) {                                     \
+       HASH_EXPAND_BUCKETS(HASH_HH_TBL(addhh));                                  \
+ }                                                                               \
+} while(0)
+
+/* remove an item from a given bucket */
+#ifdef HASH_COMPACT
+/* without back links, find the predecessor by walking the chain */
+#define HASH_DEL_IN_BKT(hh,head,hh_del)                                          \
+do {                                                                             \
+    struct UT_hash_handle *_hdb_thh;                                             \
+    (head).count--;                                                              \
+    if (HASH_BKT_HEAD(&(head)) == hh_del) {                                      \
+      HASH_BKT_SET_HEAD(&(head),                                                 \
+                        HASH_HH_CHAIN_NEXT(HASH_HH_TBL(hh_del), hh_del));        \
+    } else {                                                                     \
+      _hdb_thh = HASH_BKT_HEAD(&(head));                                         \
+      while (HASH_HH_CHAIN_NEXT(HASH_HH_TBL(hh_del), _hdb_thh) != hh_del) {      \
+        _hdb_thh = HASH_HH_CHAIN_NEXT(HASH_HH_TBL(hh_del), _hdb_thh);            \
+      }                                                                          \
+      HASH_HH_SET_CHAIN_NEXT(HASH_HH_TBL(hh_del), _hdb_thh,                      \
+                             HASH_HH_CHAIN_NEXT(HASH_HH_TBL(hh_del), hh_del));   \
+    }                                                                            \
+    HASH_FP_DEL(head,hh_del);                                                    \
+} while(0)
+#else
+#define HASH_DEL_IN_BKT(hh,head,hh_del)                                          \
+    (head).count--;                                                              \
+    if (HASH_BKT_HEAD(&(head)) == hh_del) {                                      \
+      HASH_BKT_SET_HEAD(&(head), hh_del->hh_next);                               \
+    }                                                                            \
+    if (hh_del->hh_prev) {                                                       \
+        HASH_RCU_STORE(hh_del->hh_prev->hh_next, hh_del->hh_next);               \
+    }                                                                            \
+    if (hh_del->hh_next) {                                                       \
+        hh_del->hh_next->hh_prev = hh_del->hh_prev;                              \
+    }                                                                            \
+    HASH_FP_DEL(head,hh_del);
+#endif
+
+/* move each item of the chain starting at chain into the bucket array
+ * new_bkts of new_num buckets, noting the items whose chain position
+ * exceeds tbl->ideal_chain_maxlen as it goes */
+#define HASH_REHASH_CHAIN(tbl,chain,new_bkts,new_num)                            \
+do {                                                                             \
+    UT_hash_size _hr_bkt;                                                        \
+    struct UT_hash_handle *_hr_thh, *_hr_hh_nxt;                                 \
+    UT_hash_bucket *_hr_newbkt;                                                  \
+    _hr_thh = (chain);                                                           \
+    while (_hr_thh) {                                                            \
+       _hr_hh_nxt = HASH_HH_CHAIN_NEXT(tbl, _hr_thh);                            \
+       HASH_TO_BKT( _hr_thh->hashv, new_num, _hr_bkt);                           \
+       _hr_newbkt = &((new_bkts)[ _hr_bkt ]);                                    \
+       if (++(_hr_newbkt->count) > (tbl)->ideal_chain_maxlen) {                  \
+         (tbl)->nonideal_items++;                                                \
+         _hr_newbkt->expand_mult = _hr_newbkt->count /                           \
+                                    (tbl)->ideal_chain_maxlen;                   \
+       }                                                                         \
+       HASH_HH_SET_CHAIN_NEXT(tbl, _hr_thh, HASH_BKT_HEAD(_hr_newbkt));          \
+       HASH_HH_LINK_CHAIN_PREV(_hr_thh);                                         \
+       HASH_BKT_SET_HEAD(_hr_newbkt, _hr_thh);                                   \
+       HASH_FP_ADD(*_hr_newbkt,_hr_thh);                                         \
+       _hr_thh = _hr_hh_nxt;                                                     \
+    }                                                                            \
+} while(0)
+
+/* recompute the hashv of every item, under the current seed and hash
+ * function of tbl, and redistribute the items into a new bucket array of the
+ * same size. No expansion may be in flight. The caller opens the sequence
+ * with HASH_RCU_SEQ_BEGIN before it changes the seed or function; this
+ * closes it. */
+#define HASH_REHASH_ALL(tbl)                                                     \
+do {                                                                             \
+    UT_hash_size _hra_i;                                                         \
+    UT_hash_bucket *_hra_new_buckets, *_hra_old_buckets;                         \
+    struct UT_hash_handle *_hra_thh;                                             \
+    HASH_BKT_ALLOC(tbl, (tbl)->num_buckets, _hra_new_buckets);                   \
+    (tbl)->ideal_chain_maxlen =                                                  \
+       ((tbl)->num_items >> (tbl)->log2_num_buckets) +                           \
+       (((tbl)->num_items & ((tbl)->num_buckets-1)) ? 1 : 0);                    \
+    (tbl)->nonideal_items = 0;                                                   \
+    HASH_BLOOM_CLEAR(tbl);                                                       \
+    for(_hra_i = 0; _hra_i < (tbl)->num_buckets; _hra_i++) {                     \
+        for(_hra_thh = HASH_BKT_HEAD(&HASH_TBL_BUCKETS(tbl)[_hra_i]); _hra_thh;  \
+            _hra_thh = HASH_HH_CHAIN_NEXT(tbl, _hra_thh)) {                      \
+            HASH_REHASH_HH(tbl, _hra_thh);                                       \
+            HASH_BLOOM_ADD(tbl, _hra_thh->hashv);                                \
+        }                                                                        \
+        HASH_REHASH_CHAIN(tbl, HASH_BKT_HEAD(&HASH_TBL_BUCKETS(tbl)[_hra_i]),    \
+                          _hra_new_buckets, (tbl)->num_buckets);                 \
+    }                                                                            \
+    _hra_old_buckets = HASH_TBL_BUCKETS(tbl);                                    \
+    HASH_TBL_SET_BUCKETS(tbl, _hra_new_buckets);                                 \
+    HASH_RCU_SEQ_END(tbl);                                                       \
+    HASH_RETIRE_BUCKETS(tbl, _hra_old_buckets, (tbl)->num_buckets);              \
+} while(0)
+
+#ifdef HASH_AUTO_FCN
+/* With -DHASH_AUTO_FCN a table chooses its own hash function once, when it
+ * reaches HASH_FCN_SAMPLE items, or earlier if the default doubles the table
+ * ineffectively twice in a row. The HASH_FCN_SAMPLE most recently added keys
+ * are hashed by each candidate (HASH_FCN, then the built-in functions other
+ * than the weak BER and SAX) into HASH_FCN_SCORE_MULT times as many buckets,
+ * as many as the table will have when it has grown a little, and scored as
+ * keystat scores them by the items beyond the ideal chain length. A spread
+ * better than a random function's is no merit: it is the structure that
+ * fails on the rest of the keys, as BER's does on sequential integers. So
+ * scores up to a random function's expectation count as equal, and a
+ * candidate is eligible unless it is HASH_FCN_IDEAL_SLACK percent of the
+ * sample worse. Each eligible candidate is then timed by uthash_fcn_clock,
+ * repeating passes over the keys until HASH_FCN_TIME_TICKS have elapsed, in
+ * each of HASH_FCN_TIME_ROUNDS rounds, keeping its best time per pass. The
+ * fastest is chosen, but an eligible default is only replaced by a function
+ * HASH_FCN_TIME_GAIN percent faster. A seeded table whose HASH_FCN is keyed
+ * (SipHash, or a function of the user's) only ever trades it for another
+ * keyed function, since a faster unkeyed one could be flooded. */
+#ifndef HASH_FCN_SAMPLE
+#define HASH_FCN_SAMPLE 1024     /* items present when the choice is made  */
+#endif
+#ifndef HASH_FCN_SCORE_MULT
+#define HASH_FCN_SCORE_MULT 4    /* scoring buckets per sampled key        */
+#endif
+#ifndef HASH_FCN_IDEAL_SLACK
+#define HASH_FCN_IDEAL_SLACK 4   /* ideal% within which time decides       */
+#endif
+#ifndef HASH_FCN_TIME_ROUNDS
+#define HASH_FCN_TIME_ROUNDS 3   /* timings of each candidate              */
+#endif
+#ifndef HASH_FCN_MAX_REPS
+#define HASH_FCN_MAX_REPS 256    /* passes over the keys per timing, most  */
+#endif
+#ifndef HASH_FCN_TIME_GAIN
+#define HASH_FCN_TIME_GAIN 10    /* percent faster to replace the default  */
+#endif
+#ifdef HASH_USING_NO_STRICT_ALIASING
+#define HASH_FCN_NUM_CANDIDATES 10
+#else
+#define HASH_FCN_NUM_CANDIDATES 9
+#endif
+#define HASH_FCN_CANDIDATE(i)                                                    \
+  ((i) == 0 ? uthash_fcn_default : (i) == 1 ? uthash_fcn_jen :                   \
+   (i) == 2 ? uthash_fcn_oat : (i) == 3 ? uthash_fcn_fnv :                       \
+   (i) == 4 ? uthash_fcn_sfh : (i) == 5 ? uthash_fcn_wyh :                       \
+   (i) == 6 ? uthash_fcn_xxh : (i) == 7 ? uthash_fcn_xx3 :                       \
+   HASH_FCN_CANDIDATE_LAST(i))
+#ifdef HASH_USING_NO_STRICT_ALIASING
+#define HASH_FCN_CANDIDATE_LAST(i) ((i) == 8 ? uthash_fcn_sip : uthash_fcn_mur)
+#else
+#define HASH_FCN_CANDIDATE_LAST(i) uthash_fcn_sip
+#endif
+
+/* the built-in functions that take no key; any other HASH_FCN is taken to
+ * be keyed */
+#define HASH_FCN_UNKEYED_HASH_JEN 1
+#define HASH_FCN_UNKEYED_HASH_BER 1
+#define HASH_FCN_UNKEYED_HASH_SAX 1
+#define HASH_FCN_UNKEYED_HASH_OAT 1
+#define HASH_FCN_UNKEYED_HASH_FNV 1
+#define HASH_FCN_UNKEYED_HASH_SFH 1
+#define HASH_FCN_UNKEYED_HASH_MUR 1
+#define HASH_FCN_UNKEYED_HASH_WYH 1
+#define HASH_FCN_UNKEYED_HASH_XXH 1
+#define HASH_FCN_UNKEYED_HASH_XX3 1
+#if defined(HASH_SEEDED) && !HASH_XPASTE(HASH_FCN_UNKEYED_,HASH_FCN)
+#define HASH_FCN_ALLOWED(c)                                                      \
+  (((c) == 0) || (HASH_FCN_CANDIDATE(c) == uthash_fcn_sip))
+#else
+#define HASH_FCN_ALLOWED(c) 1
+#endif
+
+/* the first candidate of tbl's eligible ones (from) that hashes a pass over
+ * the keys fastest; none if there is no eligible one */
+#define HASH_FCN_FASTEST(from,elig,ticks,reps,fastest)                           \
+do {                                                                             \
+    unsigned _hff_c;                                                             \
+    (fastest) = HASH_FCN_NUM_CANDIDATES;                                         \
+    for(_hff_c = (from); _hff_c < HASH_FCN_NUM_CANDIDATES; _hff_c++) {           \
+      if ((elig)[_hff_c] && ((fastest) == HASH_FCN_NUM_CANDIDATES ||             \
+          (ticks)[_hff_c] * (reps)[fastest] <                                    \
+          (ticks)[fastest] * (reps)[_hff_c])) {                                  \
+        (fastest) = _hff_c;                                                      \
+      }                                                                          \
+    }                                                                            \
+} while(0)
+
+#define HASH_FCN_CHOOSE(tbl)                                                     \
+do {                                                                             \
+    unsigned _hfc_c, _hfc_round, _hfc_best;                                      \
+    unsigned char _hfc_elig[HASH_FCN_NUM_CANDIDATES];                            \
+    uint64_t _hfc_ticks[HASH_FCN_NUM_CANDIDATES];                                \
+    uint64_t _hfc_reps[HASH_FCN_NUM_CANDIDATES];                                 \
+    uint64_t _hfc_occ, _hfc_dt, _hfc_r, _hfc_t0;                                 \
+    UT_hash_size _hfc_s, _hfc_nb, _hfc_i, _hfc_floor, *_hfc_counts;              \
+    UT_hash_size _hfc_nonideal[HASH_FCN_NUM_CANDIDATES];                         \
+    UT_hash_value _hfc_hashv, _hfc_acc = 0;                                      \
+    volatile UT_hash_value _hfc_sink;                                            \
+    UT_hash_fcn *_hfc_fcn;                                                       \
+    struct UT_hash_handle *_hfc_thh, **_hfc_keys;                                \
+    (tbl)->fcn_chosen = 1;                                                       \
+    _hfc_s = ((tbl)->num_items < HASH_FCN_SAMPLE) ? (tbl)->num_items :           \
+             (UT_hash_size)HASH_FCN_SAMPLE;                                      \
+    for(_hfc_nb = 4; _hfc_nb < HASH_FCN_SCORE_MULT * _hfc_s; _hfc_nb <<= 1) { }  \
+    _hfc_counts = (UT_hash_size*)uthash_malloc(_hfc_nb * sizeof(UT_hash_size) +  \
+                  _hfc_s * sizeof(struct UT_hash_handle*));                      \
+    if (!_hfc_counts) { uthash_fatal( "out of memory"); }                        \
+    _hfc_keys = (struct UT_hash_handle**)(void*)(_hfc_counts + _hfc_nb);         \
+    _hfc_thh = HASH_TBL_TAIL(tbl);                                               \
+    for(_hfc_i = 0; _hfc_i < _hfc_s; _hfc_i++) {                                 \
+      _hfc_keys[_hfc_i] = _hfc_thh;                                              \
+      _hfc_thh = HASH_HH_PREV(tbl, _hfc_thh);                                    \
+    }                                                                            \
+    _hfc_floor = _hfc_s;                                                         \
+    for(_hfc_c = 0; _hfc_c < HASH_FCN_NUM_CANDIDATES; _hfc_c++) {                \
+      _hfc_nonideal[_hfc_c] = _hfc_s;                                            \
+      if (!HASH_FCN_ALLOWED(_hfc_c)) continue;                                   \
+      _hfc_fcn = HASH_FCN_CANDIDATE(_hfc_c);                                     \
+      memset(_hfc_counts, 0, _hfc_nb * sizeof(UT_hash_size));                    \
+      for(_hfc_i = 0, _hfc_nonideal[_hfc_c] = 0; _hfc_i < _hfc_s; _hfc_i++) {    \
+        _hfc_fcn(HASH_HH_KEY(_hfc_keys[_hfc_i]), _hfc_keys[_hfc_i]->keylen,      \
+                 HASH_TBL_SEED(tbl), &_hfc_hashv);                               \
+        if (_hfc_counts[_hfc_hashv & (_hfc_nb-1)]++) _hfc_nonideal[_hfc_c]++;    \
+      }                                                                          \
+      if (_hfc_nonideal[_hfc_c] < _hfc_floor) {                                  \
+        _hfc_floor = _hfc_nonideal[_hfc_c];                                      \
+      }                                                                          \
+    }                                                                            \
+    /* the keys a random function leaves colliding: occupied buckets grow by     \
+       the chance that the next key finds an empty one (16 bits of fraction) */  \
+    for(_hfc_i = 0, _hfc_occ = 0; _hfc_i < _hfc_s; _hfc_i++) {                   \
+      _hfc_occ += ((uint64_t)1 << 16) - _hfc_occ / _hfc_nb;                      \
+    }                                                                            \
+    if (_hfc_floor < _hfc_s - (UT_hash_size)(_hfc_occ >> 16)) {                  \
+      _hfc_floor = _hfc_s - (UT_hash_size)(_hfc_occ >> 16);                      \
+    }                                                                            \
+    _hfc_floor += (_hfc_s * HASH_FCN_IDEAL_SLACK) / 100 + 1;                     \
+    for(_hfc_c = 0; _hfc_c < HASH_FCN_NUM_CANDIDATES; _hfc_c++) {                \
+      _hfc_elig[_hfc_c] = (unsigned char)(HASH_FCN_ALLOWED(_hfc_c) &&            \
+                          (_hfc_nonideal[_hfc_c] <= _hfc_floor));                \
+    }                                                                            \
+    for(_hfc_round = 0; _hfc_round < HASH_FCN_TIME_ROUNDS; _hfc_round++) {       \
+      for(_hfc_c = 0; _hfc_c < HASH_FCN_NUM_CANDIDATES; _hfc_c++) {              \
+        if (!_hfc_elig[_hfc_c]) continue;                                        \
+        _hfc_fcn = HASH_FCN_CANDIDATE(_hfc_c);                                   \
+        _hfc_r = 0;                                                              \
+        _hfc_t0 = (uint64_t)uthash_fcn_clock();                                  \
+        do {                                                                     \
+          for(_hfc_i = 0; _hfc_i < _hfc_s; _hfc_i++) {                           \
+            _hfc_fcn(HASH_HH_KEY(_hfc_keys[_hfc_i]), _hfc_keys[_hfc_i]->keylen,  \
+                     HASH_TBL_SEED(tbl), &_hfc_hashv);                           \
+            _hfc_acc ^= _hfc_hashv;                                              \
+          }                                                                      \
+          _hfc_sink = _hfc_acc;                                                  \
+          _hfc_r++;                                                              \
+          _hfc_dt = (uint64_t)uthash_fcn_clock() - _hfc_t0;                      \
+        } while ((_hfc_dt < HASH_FCN_TIME_TICKS) &&                              \
+                 (_hfc_r < HASH_FCN_MAX_REPS));                                  \
+        if ((_hfc_round == 0) ||                                                 \
+            (_hfc_dt * _hfc_reps[_hfc_c] < _hfc_ticks[_hfc_c] * _hfc_r)) {       \
+          _hfc_ticks[_hfc_c] = _hfc_dt;                                          \
+          _hfc_reps[_hfc_c] = _hfc_r;                                            \
+        }                                                                        \
+      }                                                                          \
+    }                                                                            \
+    (void)_hfc_sink;                                                             \
+    uthash_free(_hfc_counts, _hfc_nb * sizeof(UT_hash_size) +                    \
+                _hfc_s * sizeof(struct UT_hash_handle*));                        \
+    HASH_FCN_FASTEST(1, _hfc_elig, _hfc_ticks, _hfc_reps, _hfc_best);            \
+    if (_hfc_elig[0] && ((_hfc_best == HASH_FCN_NUM_CANDIDATES) ||               \
+        (_hfc_ticks[_hfc_best] * _hfc_reps[0] * 100 >=                           \
+         _hfc_ticks[0] * _hfc_reps[_hfc_best] * (100 - HASH_FCN_TIME_GAIN)))) {  \
+      _hfc_best = 0;                                                             \
+    }                                                                            \
+    if ((_hfc_best != 0) && (_hfc_best != HASH_FCN_NUM_CANDIDATES)) {            \
+      HASH_RCU_SEQ_BEGIN(tbl);                                                   \
+      (tbl)->fcn = HASH_FCN_CANDIDATE(_hfc_best);                                \
+      HASH_REHASH_ALL(tbl);                                                      \
+    }                                                                            \
+    uthash_fcn_fyi(tbl);                                                         \
+} while(0)
+
+/* choose on the add that brings the table to HASH_FCN_SAMPLE items, once no
+ * expansion is in flight */
+#define HASH_FCN_SAMPLED(tbl)                                                    \
 do {                                                                             \
- if (head.hh_head) DECLTYPE_ASSIGN(out,ELMT_FROM_HH(tbl,head.hh_head));          \
- else out=NULL;                                                                  \
- while (out) {                                                                   \
-    if ((out)->hh.keylen == keylen_in) {                                           \
-        if ((HASH_KEYCMP((out)->hh.key,keyptr,keylen_in)) == 0) break;             \
+    if (!(tbl)->fcn_chosen && ((tbl)->num_items >= HASH_FCN_SAMPLE) &&           \
+        !HASH_EXPAND_IN_FLIGHT(tbl)) {                                           \
+      HASH_FCN_CHOOSE(tbl);                                                      \
     }                                                                            \
-    if ((out)->hh.hh_next) DECLTYPE_ASSIGN(out,ELMT_FROM_HH(tbl,(out)->hh.hh_next)); \
-    else out = NULL;                                                             \
- }                                                                               \
 } while(0)
-
-/* add an item to a bucket  */
-#define HASH_ADD_TO_BKT(head,addhh)                                              \
+/* a default that doubles the table ineffectively is replaced before
+ * expansion is given up; a seeded table first spends its reseeds */
+#ifdef HASH_SEEDED
+#define HASH_FCN_RESEEDS_SPENT(tbl) ((tbl)->reseeds >= HASH_MAX_RESEEDS)
+#else
+#define HASH_FCN_RESEEDS_SPENT(tbl) 1
+#endif
+#define HASH_FCN_INEFF_EXPANDS(tbl)                                              \
 do {                                                                             \
- head.count++;                                                                   \
- (addhh)->hh_next = head.hh_head;                                                \
- (addhh)->hh_prev = NULL;                                                        \
- if (head.hh_head) { (head).hh_head->hh_prev = (addhh); }                        \
- (head).hh_head=addhh;                                                           \
- if (head.count >= ((head.expand_mult+1) * HASH_BKT_CAPACITY_THRESH)             \
-     && (addhh)->tbl->noexpand != 1) {                                           \
-       HASH_EXPAND_BUCKETS((addhh)->tbl);                                        \
- }                                                                               \
+    if (!(tbl)->fcn_chosen && HASH_FCN_RESEEDS_SPENT(tbl)) {                     \
+      HASH_FCN_CHOOSE(tbl);                                                      \
+      (tbl)->ineff_expands = 0;                                                  \
+    } else {                                                                     \
+      HASH_INEFF_EXPANDS(tbl);                                                   \
+    }                                                                            \
 } while(0)
+#define HASH_FCN_SET_CHOSEN(tbl) ((tbl)->fcn_chosen = 1)
+#else
+#define HASH_FCN_SAMPLED(tbl)
+#define HASH_FCN_INEFF_EXPANDS(tbl) HASH_INEFF_EXPANDS(tbl)
+#define HASH_FCN_SET_CHOSEN(tbl)
+#endif
 
-/* remove an item from a given bucket */
-#define HASH_DEL_IN_BKT(hh,head,hh_del)                                          \
-    (head).count--;                                                              \
-    if ((head).hh_head == hh_del) {                                              \
-      (head).hh_head = hh_del->hh_next;                                          \
+#ifdef HASH_SEEDED
+/* Seeded tables answer two ineffective doublings in a row by drawing a new
+ * seed and rehashing every item under it, at the current bucket count. Only
+ * when that has happened HASH_MAX_RESEEDS times is expansion inhibited. */
+#ifndef HASH_MAX_RESEEDS
+#define HASH_MAX_RESEEDS 3       /* reseeds before expansion is inhibited  */
+#endif
+#define HASH_RESEED(tbl)                                                         \
+do {                                                                             \
+    HASH_RCU_SEQ_BEGIN(tbl);                                                     \
+    HASH_NEW_SEED(tbl);                                                          \
+    tbl->reseeds++;                                                              \
+    HASH_REHASH_ALL(tbl);                                                        \
+    tbl->ineff_expands = 0;                                                      \
+    uthash_reseed_fyi(tbl);                                                      \
+} while(0)
+#define HASH_INEFF_EXPANDS(tbl)                                                  \
+do {                                                                             \
+    if (tbl->reseeds < HASH_MAX_RESEEDS) {                                       \
+        HASH_RESEED(tbl);                                                        \
+    } else {                                                                     \
+        tbl->noexpand=1;                                                         \
+        uthash_noexpand_fyi(tbl);                                                \
     }                                                                            \
-    if (hh_del->hh_prev) {                                                       \
-        hh_del->hh_prev->hh_next = hh_del->hh_next;                              \
+} while(0)
+#else
+#define HASH_INEFF_EXPANDS(tbl)                                                  \
+do {                                                                             \
+    tbl->noexpand=1;                                                             \
+    uthash_noexpand_fyi(tbl);                                                    \
+} while(0)
+#endif
+
+/* after a doubling, inhibit further expansion if it didn't help */
+#define HASH_EXPAND_DONE(tbl)                                                    \
+do {                                                                             \
+    HASH_BLOOM_RESIZE(tbl);                                                      \
+    tbl->ineff_expands = (tbl->nonideal_items > (tbl->num_items >> 1)) ?         \
+        (tbl->ineff_expands+1) : 0;                                              \
+    if (tbl->ineff_expands > 1) {                                                \
+        HASH_FCN_INEFF_EXPANDS(tbl);                                             \
     }                                                                            \
-    if (hh_del->hh_next) {                                                       \
-        hh_del->hh_next->hh_prev = hh_del->hh_prev;                              \
-    }                                                                
+    uthash_expand_fyi(tbl);                                                      \
+} while(0)
 
 /* Bucket expansion has the effect of doubling the number of buckets
  * and redistributing the items into the new buckets. Ideally the
@@ -644,63 +2975,261 @@ do {
  *      ceil(n/b) = (n>>lb) + ( (n & (b-1)) ? 1:0)
  * 
  */
+#ifndef HASH_INCREMENTAL
+#ifdef HASH_EXPAND_INPLACE
+/* In-place doubling (-DHASH_EXPAND_INPLACE) grows the bucket array with
+ * realloc (mremap for a mapped array) instead of allocating a second one.
+ * When the allocator extends the block where it lies, expanding N buckets
+ * peaks at 2N rather than 3N. When realloc has to move the block, or
+ * HASH_REALLOC_COPY copies it between blocks of a user allocator, the old
+ * and new arrays coexist as before and the peak is still 3N. Since an item
+ * in bucket i moves to bucket i or i+N, each old chain is detached and split
+ * between the two in one pass, in the same order as the copying expansion. */
+#ifdef HASH_RCU
+#error "HASH_EXPAND_INPLACE cannot be combined with HASH_RCU"
+#endif
+#define HASH_EXPAND_BUCKETS(tbl)                                                 \
+do {                                                                             \
+    UT_hash_size _he_bkt_i, _he_num = tbl->num_buckets;                          \
+    struct UT_hash_handle *_he_chain;                                            \
+    UT_hash_bucket *_he_buckets;                                                 \
+    HASH_BKT_REALLOC(tbl, HASH_TBL_BUCKETS(tbl), _he_num, 2 * _he_num,           \
+                     _he_buckets);                                               \
+    tbl->ideal_chain_maxlen =                                                    \
+       (tbl->num_items >> (tbl->log2_num_buckets+1)) +                           \
+       ((tbl->num_items & ((_he_num*2)-1)) ? 1 : 0);                             \
+    tbl->nonideal_items = 0;                                                     \
+    for(_he_bkt_i = 0; _he_bkt_i < _he_num; _he_bkt_i++)                         \
+    {                                                                            \
+        _he_chain = HASH_BKT_HEAD(&_he_buckets[ _he_bkt_i ]);                    \
+        memset(&_he_buckets[ _he_bkt_i ], 0, sizeof(UT_hash_bucket));            \
+        HASH_REHASH_CHAIN(tbl, _he_chain, _he_buckets, _he_num*2);               \
+    }                                                                            \
+    HASH_TBL_SET_BUCKETS(tbl, _he_buckets);                                      \
+    tbl->num_buckets = _he_num*2;                                                \
+    tbl->log2_num_buckets++;                                                     \
+    HASH_EXPAND_DONE(tbl);                                                       \
+} while(0)
+#else
 #define HASH_EXPAND_BUCKETS(tbl)                                                 \
 do {                                                                             \
-    unsigned _he_bkt;                                                            \
-    unsigned _he_bkt_i;                                                          \
-    struct UT_hash_handle *_he_thh, *_he_hh_nxt;                                 \
-    UT_hash_bucket *_he_new_buckets, *_he_newbkt;                                \
-    _he_new_buckets = (UT_hash_bucket*)uthash_malloc(                            \
-             2 * tbl->num_buckets * sizeof(struct UT_hash_bucket));              \
-    if (!_he_new_buckets) { uthash_fatal( "out of memory"); }                    \
-    memset(_he_new_buckets, 0,                                                   \
-            2 * tbl->num_buckets * sizeof(struct UT_hash_bucket));               \
+    UT_hash_size _he_bkt_i;                                                      \
+    UT_hash_bucket *_he_new_buckets, *_he_old_buckets;                           \
+    HASH_BKT_ALLOC(tbl, 2 * tbl->num_buckets, _he_new_buckets);                  \
     tbl->ideal_chain_maxlen =                                                    \
        (tbl->num_items >> (tbl->log2_num_buckets+1)) +                           \
        ((tbl->num_items & ((tbl->num_buckets*2)-1)) ? 1 : 0);                    \
     tbl->nonideal_items = 0;                                                     \
+    HASH_RCU_SEQ_BEGIN(tbl);                                                     \
     for(_he_bkt_i = 0; _he_bkt_i < tbl->num_buckets; _he_bkt_i++)                \
     {                                                                            \
-        _he_thh = tbl->buckets[ _he_bkt_i ].hh_head;                             \
-        while (_he_thh) {                                                        \
-           _he_hh_nxt = _he_thh->hh_next;                                        \
-           HASH_TO_BKT( _he_thh->hashv, tbl->num_buckets*2, _he_bkt);            \
-           _he_newbkt = &(_he_new_buckets[ _he_bkt ]);                           \
-           if (++(_he_newbkt->count) > tbl->ideal_chain_maxlen) {                \
-             tbl->nonideal_items++;                                              \
-             _he_newbkt->expand_mult = _he_newbkt->count /                       \
-                                        tbl->ideal_chain_maxlen;                 \
-           }                                                                     \
-           _he_thh->hh_prev = NULL;                                              \
-           _he_thh->hh_next = _he_newbkt->hh_head;                               \
-           if (_he_newbkt->hh_head) _he_newbkt->hh_head->hh_prev =               \
-                _he_thh;                                                         \
-           _he_newbkt->hh_head = _he_thh;                                        \
-           _he_thh = _he_hh_nxt;                                                 \
-        }                                                                        \
+        HASH_REHASH_CHAIN(tbl, HASH_BKT_HEAD(HASH_TBL_BUCKETS(tbl) + _he_bkt_i), \
+                          _he_new_buckets, tbl->num_buckets*2);                  \
     }                                                                            \
-    uthash_free( tbl->buckets, tbl->num_buckets*sizeof(struct UT_hash_bucket) ); \
+    _he_old_buckets = HASH_TBL_BUCKETS(tbl);                                     \
+    HASH_TBL_SET_BUCKETS(tbl, _he_new_buckets);                                  \
     tbl->num_buckets *= 2;                                                       \
     tbl->log2_num_buckets++;                                                     \
-    tbl->buckets = _he_new_buckets;                                              \
-    tbl->ineff_expands = (tbl->nonideal_items > (tbl->num_items >> 1)) ?         \
-        (tbl->ineff_expands+1) : 0;                                              \
-    if (tbl->ineff_expands > 1) {                                                \
-        tbl->noexpand=1;                                                         \
-        uthash_noexpand_fyi(tbl);                                                \
+    HASH_RCU_SEQ_END(tbl);                                                       \
+    HASH_RETIRE_BUCKETS(tbl, _he_old_buckets, tbl->num_buckets/2);               \
+    HASH_EXPAND_DONE(tbl);                                                       \
+} while(0)
+#endif /* HASH_EXPAND_INPLACE */
+
+#define HASH_EXPAND_STEP(tbl)
+#define HASH_EXPAND_COMPLETE(tbl)
+#define HASH_EXPAND_IN_FLIGHT(tbl) 0
+#define HASH_FREE_OLD_BUCKETS(tbl)
+
+#else
+/* Incremental expansion (-DHASH_INCREMENTAL) avoids the pause of doubling
+ * a large table in one go. HASH_EXPAND_BUCKETS only allocates the doubled
+ * array and makes it current, keeping the old array aside. Thereafter each
+ * add or delete calls HASH_EXPAND_STEP, which migrates the chains of the
+ * next HASH_MIGRATE_BKTS old buckets (in order) into the new array. An old
+ * bucket that has not been migrated yet still holds its items; HASH_BKT
+ * knows which array to look in. Lookups never migrate, so HASH_FIND stays
+ * read-only. A trigger to expand again while migrating is ignored; the next
+ * overfull bucket after the migration completes re-triggers it. */
+#ifdef HASH_EXPAND_INPLACE
+#error "HASH_EXPAND_INPLACE cannot be combined with HASH_INCREMENTAL"
+#endif
+#ifndef HASH_MIGRATE_BKTS
+#define HASH_MIGRATE_BKTS 8      /* old buckets migrated per add or delete */
+#endif
+#define HASH_EXPAND_BUCKETS(tbl)                                                 \
+do {                                                                             \
+    UT_hash_bucket *_he_new_buckets;                                             \
+    if (!tbl->old_buckets) {                                                     \
+      HASH_BKT_ALLOC(tbl, 2 * tbl->num_buckets, _he_new_buckets);                \
+      tbl->ideal_chain_maxlen =                                                  \
+         (tbl->num_items >> (tbl->log2_num_buckets+1)) +                         \
+         ((tbl->num_items & ((tbl->num_buckets*2)-1)) ? 1 : 0);                  \
+      tbl->nonideal_items = 0;                                                   \
+      tbl->old_buckets = HASH_TBL_BUCKETS(tbl);                                  \
+      tbl->old_num_buckets = tbl->num_buckets;                                   \
+      tbl->migrate_bkt = 0;                                                      \
+      tbl->num_buckets *= 2;                                                     \
+      tbl->log2_num_buckets++;                                                   \
+      HASH_TBL_SET_BUCKETS(tbl, _he_new_buckets);                                \
     }                                                                            \
-    uthash_expand_fyi(tbl);                                                      \
 } while(0)
 
+/* migrate up to HASH_MIGRATE_BKTS old buckets; free the old array when done */
+#define HASH_EXPAND_STEP(tbl)                                                    \
+do {                                                                             \
+    unsigned _hx_n;                                                              \
+    if ((tbl)->old_buckets) {                                                    \
+      for(_hx_n = 0; (_hx_n < HASH_MIGRATE_BKTS) &&                              \
+          ((tbl)->migrate_bkt < (tbl)->old_num_buckets); _hx_n++) {              \
+        HASH_REHASH_CHAIN(tbl,                                                   \
+                          HASH_BKT_HEAD(&(tbl)->old_buckets[(tbl)->migrate_bkt]),\
+                          HASH_TBL_BUCKETS(tbl), (tbl)->num_buckets);            \
+        (tbl)->migrate_bkt++;                                                    \
+      }                                                                          \
+      if ((tbl)->migrate_bkt == (tbl)->old_num_buckets) {                        \
+        HASH_FREE_OLD_BUCKETS(tbl);                                              \
+        HASH_EXPAND_DONE(tbl);                                                   \
+      }                                                                          \
+    }                                                                            \
+} while(0)
+
+#define HASH_EXPAND_IN_FLIGHT(tbl) ((tbl)->old_buckets != NULL)
+
+/* finish any migration in flight, for operations that walk every bucket */
+#define HASH_EXPAND_COMPLETE(tbl)                                                \
+do {                                                                             \
+    while ((tbl)->old_buckets) { HASH_EXPAND_STEP(tbl); }                        \
+} while(0)
+
+#define HASH_FREE_OLD_BUCKETS(tbl)                                               \
+do {                                                                             \
+    if ((tbl)->old_buckets) {                                                    \
+      HASH_BKT_FREE((tbl), (tbl)->old_buckets, (tbl)->old_num_buckets);          \
+      (tbl)->old_buckets = NULL;                                                 \
+    }                                                                            \
+} while(0)
+#endif /* HASH_INCREMENTAL */
+
+
+/* Redistribute all items into a new array of 2^log2_new buckets in one pass,
+ * with the ideal chain length computed for nitems items. This is expansion
+ * generalized to any target size; HASH_SHRINK uses it to contract the table.
+ * Any incremental expansion in flight is completed first. */
+#define HASH_RESIZE_BUCKETS(tbl,log2_new,nitems)                                 \
+do {                                                                             \
+    UT_hash_size _hz_bkt_i, _hz_num;                                             \
+    UT_hash_bucket *_hz_new_buckets, *_hz_old_buckets;                           \
+    HASH_EXPAND_COMPLETE(tbl);                                                   \
+    _hz_num = (UT_hash_size)1 << (log2_new);                                     \
+    HASH_BKT_ALLOC(tbl, _hz_num, _hz_new_buckets);                               \
+    (tbl)->ideal_chain_maxlen = ((nitems) >> (log2_new)) +                       \
+       (((nitems) & (_hz_num-1)) ? 1 : 0);                                       \
+    (tbl)->nonideal_items = 0;                                                   \
+    HASH_RCU_SEQ_BEGIN(tbl);                                                     \
+    for(_hz_bkt_i = 0; _hz_bkt_i < (tbl)->num_buckets; _hz_bkt_i++) {            \
+        HASH_REHASH_CHAIN(tbl, HASH_BKT_HEAD(HASH_TBL_BUCKETS(tbl) + _hz_bkt_i), \
+                          _hz_new_buckets, _hz_num);                             \
+    }                                                                            \
+    _hz_old_buckets = HASH_TBL_BUCKETS(tbl);                                     \
+    HASH_TBL_SET_BUCKETS(tbl, _hz_new_buckets);                                  \
+    HASH_RCU_SEQ_END(tbl);                                                       \
+    HASH_RETIRE_BUCKETS(tbl, _hz_old_buckets, (tbl)->num_buckets);               \
+    (tbl)->num_buckets = _hz_num;                                                \
+    (tbl)->log2_num_buckets = (log2_new);                                        \
+    HASH_BLOOM_RESIZE(tbl);                                                      \
+} while(0)
+
+/* Contract the bucket array to the smallest size, no smaller than the
+ * initial size, that holds no more than one item per bucket on average.
+ * The bucket array otherwise only grows; after a mass deletion this
+ * returns the memory of the empty buckets, and speeds up operations
+ * that walk every bucket such as HASH_SELECT. */
+#define HASH_SHRINK(hh,head)                                                     \
+do {                                                                             \
+  unsigned _hk_log2;                                                             \
+  if (head) {                                                                    \
+    HASH_LOG2_FOR(HASH_TBL(hh,head)->num_items, _hk_log2);                       \
+    if (_hk_log2 < HASH_TBL(hh,head)->log2_num_buckets) {                        \
+      HASH_RESIZE_BUCKETS(HASH_TBL(hh,head), _hk_log2,                           \
+                          HASH_TBL(hh,head)->num_items);                         \
+      HASH_FSCK(hh,head);                                                        \
+    }                                                                            \
+  }                                                                              \
+} while(0)
+
+/* Presize the bucket array for n items in total, so that adding them
+ * triggers no further expansion; this replaces the successive doublings of
+ * a bulk load by a single redistribution of the items already present.
+ * The table must exist; for the first add, see uthash_capacity_hint. */
+#define HASH_RESERVE(hh,head,n)                                                  \
+do {                                                                             \
+  unsigned _hv_log2;                                                             \
+  UT_hash_size _hv_n;                                                            \
+  if (head) {                                                                    \
+    _hv_n = (UT_hash_size)(n);                                                   \
+    if (_hv_n < HASH_TBL(hh,head)->num_items) {                                  \
+      _hv_n = HASH_TBL(hh,head)->num_items;                                      \
+    }                                                                            \
+    HASH_LOG2_FOR(_hv_n, _hv_log2);                                              \
+    if (_hv_log2 > HASH_TBL(hh,head)->log2_num_buckets) {                        \
+      HASH_RESIZE_BUCKETS(HASH_TBL(hh,head), _hv_log2, _hv_n);                   \
+      HASH_FSCK(hh,head);                                                        \
+    }                                                                            \
+  }                                                                              \
+} while(0)
+
+#ifdef HASH_TABLE_FCN
+/* Make hash_fcn (a UT_hash_fcn, or NULL for HASH_FCN) the hash function of
+ * the table, and rehash the items already present. The table must exist, so
+ * this is normally done right after the first add. */
+#define HASH_SET_FCN(hh,head,hash_fcn)                                           \
+do {                                                                             \
+  if (head) {                                                                    \
+    HASH_EXPAND_COMPLETE(HASH_TBL(hh,head));                                     \
+    HASH_RCU_SEQ_BEGIN(HASH_TBL(hh,head));                                       \
+    HASH_TBL(hh,head)->fcn = (hash_fcn);                                         \
+    HASH_FCN_SET_CHOSEN(HASH_TBL(hh,head));                                      \
+    HASH_REHASH_ALL(HASH_TBL(hh,head));                                          \
+    HASH_FSCK(hh,head);                                                          \
+  }                                                                              \
+} while(0)
+#endif
+
+/* With -DHASH_AUTO_SHRINK, a delete that leaves the table below
+ * HASH_SHRINK_PCT percent load halves the bucket array. Expansion is not
+ * driven by load: it happens when one chain reaches HASH_BKT_CAPACITY_THRESH
+ * items (times expand_mult+1, see HASH_ADD_TO_BKT). With a hash function
+ * that spreads the keys well, that takes several items per bucket on
+ * average (between 2.5 and 6 for sequential int keys and the default
+ * function). A table just shrunk is below 2*HASH_SHRINK_PCT percent load, far
+ * from that trigger, so the gap provides hysteresis against alternately
+ * expanding and contracting. */
+#ifdef HASH_AUTO_SHRINK
+#ifndef HASH_SHRINK_PCT
+#define HASH_SHRINK_PCT 25
+#endif
+#define HASH_SHRINK_CHECK(tbl)                                                   \
+do {                                                                             \
+  if (((tbl)->log2_num_buckets > HASH_INITIAL_NUM_BUCKETS_LOG2) &&               \
+      !HASH_EXPAND_IN_FLIGHT(tbl) &&                                             \
+      ((tbl)->num_items * 100 < (tbl)->num_buckets * HASH_SHRINK_PCT)) {         \
+    HASH_RESIZE_BUCKETS(tbl, (tbl)->log2_num_buckets-1, (tbl)->num_items);       \
+  }                                                                              \
+} while(0)
+#else
+#define HASH_SHRINK_CHECK(tbl)
+#endif
 
 /* This is an adaptation of Simon Tatham's O(n log(n)) mergesort */
 /* Note that HASH_SORT assumes the hash handle name to be hh. 
  * HASH_SRT was added to allow the hash handle name to be passed in. */
 #define HASH_SORT(head,cmpfcn) HASH_SRT(hh,head,cmpfcn)
-#define HASH_SRT(hh,head,cmpfcn)                                                 \
+#define HASH_SRT_LIST(hh,head,cmpfcn)                                            \
 do {                                                                             \
-  unsigned _hs_i;                                                                \
-  unsigned _hs_looping,_hs_nmerges,_hs_insize,_hs_psize,_hs_qsize;               \
+  UT_hash_size _hs_i;                                                            \
+  unsigned _hs_looping;                                                          \
+  UT_hash_size _hs_nmerges,_hs_insize,_hs_psize,_hs_qsize;                       \
   struct UT_hash_handle *_hs_p, *_hs_q, *_hs_e, *_hs_list, *_hs_tail;            \
   if (head) {                                                                    \
       _hs_insize = 1;                                                            \
@@ -717,58 +3246,47 @@ do {
               _hs_psize = 0;                                                     \
               for ( _hs_i = 0; _hs_i  < _hs_insize; _hs_i++ ) {                  \
                   _hs_psize++;                                                   \
-                  _hs_q = (UT_hash_handle*)((_hs_q->next) ?                      \
-                          ((void*)((char*)(_hs_q->next) +                        \
-                          (head)->hh.tbl->hho)) : NULL);                         \
+                  _hs_q = HASH_HH_NEXT(HASH_TBL(hh,head), _hs_q);                \
                   if (! (_hs_q) ) break;                                         \
               }                                                                  \
               _hs_qsize = _hs_insize;                                            \
               while ((_hs_psize > 0) || ((_hs_qsize > 0) && _hs_q )) {           \
                   if (_hs_psize == 0) {                                          \
                       _hs_e = _hs_q;                                             \
-                      _hs_q = (UT_hash_handle*)((_hs_q->next) ?                  \
-                              ((void*)((char*)(_hs_q->next) +                    \
-                              (head)->hh.tbl->hho)) : NULL);                     \
+                      _hs_q = HASH_HH_NEXT(HASH_TBL(hh,head), _hs_q);            \
                       _hs_qsize--;                                               \
                   } else if ( (_hs_qsize == 0) || !(_hs_q) ) {                   \
                       _hs_e = _hs_p;                                             \
-                      _hs_p = (UT_hash_handle*)((_hs_p->next) ?                  \
-                              ((void*)((char*)(_hs_p->next) +                    \
-                              (head)->hh.tbl->hho)) : NULL);                     \
+                      _hs_p = HASH_HH_NEXT(HASH_TBL(hh,head), _hs_p);            \
                       _hs_psize--;                                               \
                   } else if ((                                                   \
-                      cmpfcn(DECLTYPE(head)(ELMT_FROM_HH((head)->hh.tbl,_hs_p)), \
-                             DECLTYPE(head)(ELMT_FROM_HH((head)->hh.tbl,_hs_q))) \
+                      cmpfcn(                                                    \
+                        DECLTYPE(head)ELMT_FROM_HH(HASH_TBL(hh,head),_hs_p),     \
+                        DECLTYPE(head)ELMT_FROM_HH(HASH_TBL(hh,head),_hs_q))     \
                              ) <= 0) {                                           \
                       _hs_e = _hs_p;                                             \
-                      _hs_p = (UT_hash_handle*)((_hs_p->next) ?                  \
-                              ((void*)((char*)(_hs_p->next) +                    \
-                              (head)->hh.tbl->hho)) : NULL);                     \
+                      _hs_p = HASH_HH_NEXT(HASH_TBL(hh,head), _hs_p);            \
                       _hs_psize--;                                               \
                   } else {                                                       \
                       _hs_e = _hs_q;                                             \
-                      _hs_q = (UT_hash_handle*)((_hs_q->next) ?                  \
-                              ((void*)((char*)(_hs_q->next) +                    \
-                              (head)->hh.tbl->hho)) : NULL);                     \
+                      _hs_q = HASH_HH_NEXT(HASH_TBL(hh,head), _hs_q);            \
                       _hs_qsize--;                                               \
                   }                                                              \
                   if ( _hs_tail ) {                                              \
-                      _hs_tail->next = ((_hs_e) ?                                \
-                            ELMT_FROM_HH((head)->hh.tbl,_hs_e) : NULL);          \
+                      HASH_HH_SET_NEXT(HASH_TBL(hh,head), _hs_tail, _hs_e);      \
                   } else {                                                       \
                       _hs_list = _hs_e;                                          \
                   }                                                              \
-                  _hs_e->prev = ((_hs_tail) ?                                    \
-                     ELMT_FROM_HH((head)->hh.tbl,_hs_tail) : NULL);              \
+                  HASH_HH_SET_PREV(HASH_TBL(hh,head), _hs_e, _hs_tail);          \
                   _hs_tail = _hs_e;                                              \
               }                                                                  \
               _hs_p = _hs_q;                                                     \
           }                                                                      \
-          _hs_tail->next = NULL;                                                 \
+          HASH_HH_SET_NEXT(HASH_TBL(hh,head), _hs_tail, NULL);                   \
           if ( _hs_nmerges <= 1 ) {                                              \
               _hs_looping=0;                                                     \
-              (head)->hh.tbl->tail = _hs_tail;                                   \
-              DECLTYPE_ASSIGN(head,ELMT_FROM_HH((head)->hh.tbl, _hs_list));      \
+              HASH_TBL_SET_TAIL(HASH_TBL(hh,head), _hs_tail);                    \
+              HASH_RCU_ASSIGN(head,ELMT_FROM_HH(HASH_TBL(hh,head), _hs_list));   \
           }                                                                      \
           _hs_insize *= 2;                                                       \
       }                                                                          \
@@ -776,6 +3294,378 @@ do {
  }                                                                               \
 } while (0)
 
+/* HASH_SRT sorts a table of HASH_SORT_ARRAY_MIN or more items in an array:
+ * it gathers the items in one walk of the list, sorts the array, and relinks
+ * prev/next/tail in a second walk, instead of following next pointers on
+ * every pass of the list mergesort. The array sort is a stable mergesort of
+ * the runs already in the table: ascending runs, and strictly descending
+ * ones reversed, are taken as they stand, and short ones are extended to
+ * HASH_SORT_RUN items by insertion. So a sorted or nearly sorted table costs
+ * one pass. Smaller tables, and tables whose array cannot be allocated, are
+ * sorted by the list mergesort. */
+#ifndef HASH_SORT_ARRAY_MIN
+#define HASH_SORT_ARRAY_MIN 256
+#endif
+#define HASH_SORT_RUN 16        /* shortest run of the array sort */
+#define HASH_SORT_BYTES(n)                                                       \
+  (2 * (size_t)(n) * sizeof(void*) +                                             \
+   ((size_t)(n) / HASH_SORT_RUN + 2) * sizeof(size_t))
+#define HASH_SRT_CMP(head,cmpfcn,a,b) cmpfcn(DECLTYPE(head)(a), DECLTYPE(head)(b))
+
+/* stably sort the n items at elts, using the rest of the HASH_SORT_BYTES(n)
+ * there as scratch; out is set to the array that holds the result */
+#define HASH_SRT_ARRAY(head,cmpfcn,elts,n,out)                                   \
+do {                                                                             \
+  size_t _hsa_i, _hsa_j, _hsa_k, _hsa_lo, _hsa_mid, _hsa_hi, _hsa_m, _hsa_r;     \
+  void *_hsa_e, **_hsa_src = (elts), **_hsa_dst = (elts) + (n), **_hsa_sw;       \
+  size_t *_hsa_runs = (size_t*)((elts) + 2*(size_t)(n));                         \
+  for (_hsa_m = 0, _hsa_i = 0; _hsa_i < (size_t)(n); _hsa_m++) {                 \
+    _hsa_lo = _hsa_i++;                                                          \
+    if ((_hsa_i < (size_t)(n)) && (HASH_SRT_CMP(head, cmpfcn,                    \
+                               _hsa_src[_hsa_i-1], _hsa_src[_hsa_i]) > 0)) {     \
+      for (_hsa_i++; (_hsa_i < (size_t)(n)) && (HASH_SRT_CMP(head, cmpfcn,       \
+                        _hsa_src[_hsa_i-1], _hsa_src[_hsa_i]) > 0); _hsa_i++) ;  \
+      for (_hsa_j = _hsa_lo, _hsa_k = _hsa_i-1; _hsa_j < _hsa_k;                 \
+           _hsa_j++, _hsa_k--) {                                                 \
+        _hsa_e = _hsa_src[_hsa_j];                                               \
+        _hsa_src[_hsa_j] = _hsa_src[_hsa_k];                                     \
+        _hsa_src[_hsa_k] = _hsa_e;                                               \
+      }                                                                          \
+    } else if (_hsa_i < (size_t)(n)) {                                           \
+      for (_hsa_i++; (_hsa_i < (size_t)(n)) && (HASH_SRT_CMP(head, cmpfcn,       \
+                        _hsa_src[_hsa_i-1], _hsa_src[_hsa_i]) <= 0); _hsa_i++) ; \
+    }                                                                            \
+    _hsa_hi = ((size_t)(n) - _hsa_lo < HASH_SORT_RUN) ? (size_t)(n) :            \
+              _hsa_lo + HASH_SORT_RUN;                                           \
+    for (; _hsa_i < _hsa_hi; _hsa_i++) {                                         \
+      _hsa_e = _hsa_src[_hsa_i];                                                 \
+      for (_hsa_k = _hsa_i; (_hsa_k > _hsa_lo) && (HASH_SRT_CMP(head, cmpfcn,    \
+                                        _hsa_src[_hsa_k-1], _hsa_e) > 0);        \
+           _hsa_k--) {                                                           \
+        _hsa_src[_hsa_k] = _hsa_src[_hsa_k-1];                                   \
+      }                                                                          \
+      _hsa_src[_hsa_k] = _hsa_e;                                                 \
+    }                                                                            \
+    _hsa_runs[_hsa_m] = _hsa_lo;                                                 \
+  }                                                                              \
+  _hsa_runs[_hsa_m] = (size_t)(n);                                               \
+  while (_hsa_m > 1) {                                                           \
+    for (_hsa_r = 0; _hsa_r + 1 < _hsa_m; _hsa_r += 2) {                         \
+      _hsa_lo = _hsa_runs[_hsa_r];                                               \
+      _hsa_mid = _hsa_runs[_hsa_r+1];                                            \
+      _hsa_hi = _hsa_runs[_hsa_r+2];                                             \
+      _hsa_i = _hsa_lo; _hsa_j = _hsa_mid; _hsa_k = _hsa_lo;                     \
+      if (HASH_SRT_CMP(head, cmpfcn, _hsa_src[_hsa_mid-1], _hsa_src[_hsa_mid])   \
+          > 0) {                                                                 \
+        while ((_hsa_i < _hsa_mid) && (_hsa_j < _hsa_hi)) {                      \
+          if (HASH_SRT_CMP(head, cmpfcn, _hsa_src[_hsa_i], _hsa_src[_hsa_j])     \
+              <= 0) {                                                            \
+            _hsa_dst[_hsa_k++] = _hsa_src[_hsa_i++];                             \
+          } else {                                                               \
+            _hsa_dst[_hsa_k++] = _hsa_src[_hsa_j++];                             \
+          }                                                                      \
+        }                                                                        \
+      }                                                                          \
+      while (_hsa_i < _hsa_mid) _hsa_dst[_hsa_k++] = _hsa_src[_hsa_i++];         \
+      while (_hsa_j < _hsa_hi) _hsa_dst[_hsa_k++] = _hsa_src[_hsa_j++];          \
+      _hsa_runs[_hsa_r/2] = _hsa_lo;                                             \
+    }                                                                            \
+    if (_hsa_r < _hsa_m) {                                                       \
+      for (_hsa_i = _hsa_runs[_hsa_r]; _hsa_i < (size_t)(n); _hsa_i++) {         \
+        _hsa_dst[_hsa_i] = _hsa_src[_hsa_i];                                     \
+      }                                                                          \
+      _hsa_runs[_hsa_r/2] = _hsa_runs[_hsa_r];                                   \
+    }                                                                            \
+    _hsa_m = (_hsa_m + 1) / 2;                                                   \
+    _hsa_runs[_hsa_m] = (size_t)(n);                                             \
+    _hsa_sw = _hsa_src; _hsa_src = _hsa_dst; _hsa_dst = _hsa_sw;                 \
+  }                                                                              \
+  (out) = _hsa_src;                                                              \
+} while (0)
+
+/* With -DHASH_SORT_THREADS, HASH_SRT_PARALLEL(hh,head,cmpfcn,nthreads) sorts
+ * a table of HASH_SORT_PAR_MIN or more items on nthreads threads. It sorts
+ * nthreads slices of the array at once, and merges the slices pairwise,
+ * again in parallel. Ties keep their order, as in the other sorts. The
+ * threads call the comparison function through a pointer, so it must be a
+ * function of type UT_hash_cmp, int(const void*,const void*); anything else
+ * is a compile-time error rather than a cast. HASH_SRT is not affected. */
+#ifdef HASH_SORT_THREADS
+#include <pthread.h>  /* pthread_create */
+#ifndef HASH_SORT_PAR_MIN
+#define HASH_SORT_PAR_MIN 16384
+#endif
+#define HASH_SORT_PAR_MAX 64    /* most threads one sort uses */
+typedef int (UT_hash_cmp)(const void *a, const void *b);
+typedef struct UT_hash_sort_job {
+  void **elts, **tmp;           /* the array, and as much scratch space */
+  size_t lo, mid, hi;           /* sort [lo,hi), or merge [lo,mid),[mid,hi) */
+  int merge;
+  UT_hash_cmp *cmp;
+  pthread_t thread;
+  int running;
+} UT_hash_sort_job;
+
+/* merge the sorted runs src[lo,mid) and src[mid,hi) into dst[lo,hi),
+ * taking from the first run on ties */
+static HASH_INLINE void uthash_sort_merge(void **src, void **dst, size_t lo,
+                                          size_t mid, size_t hi,
+                                          UT_hash_cmp *cmp) {
+  size_t i = lo, j = mid, k = lo;
+  if ((mid > lo) && (hi > mid) && (cmp(src[mid-1], src[mid]) <= 0)) {
+    memcpy(dst + lo, src + lo, (hi - lo) * sizeof(void*));  /* in order */
+    return;
+  }
+  while ((i < mid) && (j < hi)) {
+    dst[k++] = (cmp(src[i], src[j]) <= 0) ? src[i++] : src[j++];
+  }
+  while (i < mid) dst[k++] = src[i++];
+  while (j < hi) dst[k++] = src[j++];
+}
+
+/* stably sort elts[lo,hi), using tmp[lo,hi) as scratch */
+static HASH_INLINE void uthash_sort_slice(void **elts, void **tmp, size_t lo,
+                                          size_t hi, UT_hash_cmp *cmp) {
+  size_t i, j, k, w, mid, end;
+  void *e, **src = elts, **dst = tmp, **swap;
+  for (i = lo; i < hi; i += HASH_SORT_RUN) {
+    end = (hi - i < HASH_SORT_RUN) ? hi : i + HASH_SORT_RUN;
+    for (j = i + 1; j < end; j++) {
+      e = elts[j];
+      for (k = j; (k > i) && (cmp(elts[k-1], e) > 0); k--) elts[k] = elts[k-1];
+      elts[k] = e;
+    }
+  }
+  for (w = HASH_SORT_RUN; w < hi - lo; w *= 2) {
+    for (i = lo; i < hi; i += 2*w) {
+      mid = (hi - i < w) ? hi : i + w;
+      end = (hi - i < 2*w) ? hi : i + 2*w;
+      uthash_sort_merge(src, dst, i, mid, end, cmp);
+    }
+    swap = src; src = dst; dst = swap;
+  }
+  if (src != elts) memcpy(elts + lo, src + lo, (hi - lo) * sizeof(void*));
+}
+
+static HASH_INLINE void *uthash_sort_job(void *arg) {
+  UT_hash_sort_job *job = (UT_hash_sort_job*)arg;
+  if (job->merge) {
+    uthash_sort_merge(job->elts, job->tmp, job->lo, job->mid, job->hi, job->cmp);
+    memcpy(job->elts + job->lo, job->tmp + job->lo,
+           (job->hi - job->lo) * sizeof(void*));
+  } else {
+    uthash_sort_slice(job->elts, job->tmp, job->lo, job->hi, job->cmp);
+  }
+  return NULL;
+}
+
+/* run jobs[0,n) at once: each but the last on a thread of its own, and any
+ * whose thread cannot be created in the calling thread */
+static HASH_INLINE void uthash_sort_run(UT_hash_sort_job *jobs, unsigned n) {
+  unsigned i;
+  for (i = 0; i < n; i++) {
+    jobs[i].running = (i + 1 < n) &&
+      !pthread_create(&jobs[i].thread, NULL, uthash_sort_job, &jobs[i]);
+    if (!jobs[i].running) uthash_sort_job(&jobs[i]);
+  }
+  for (i = 0; i < n; i++) {
+    if (jobs[i].running) pthread_join(jobs[i].thread, NULL);
+  }
+}
+
+/* stably sort the n pointers at elts on nthreads threads; tmp has room for
+ * n more */
+static HASH_INLINE void uthash_sort_par(void **elts, void **tmp, size_t n,
+                                        UT_hash_cmp *cmp, unsigned nthreads) {
+  UT_hash_sort_job jobs[HASH_SORT_PAR_MAX];
+  size_t bound[HASH_SORT_PAR_MAX+1];
+  unsigned i, m, p, step;
+  p = (nthreads < 1) ? 1 : (nthreads > HASH_SORT_PAR_MAX) ? HASH_SORT_PAR_MAX :
+      nthreads;
+  if (p > n) p = (n > 0) ? (unsigned)n : 1;
+  for (i = 0; i <= p; i++) bound[i] = n / p * i + n % p * i / p;
+  for (i = 0; i < p; i++) {
+    jobs[i].elts = elts; jobs[i].tmp = tmp; jobs[i].cmp = cmp;
+    jobs[i].lo = bound[i]; jobs[i].hi = bound[i+1]; jobs[i].merge = 0;
+  }
+  uthash_sort_run(jobs, p);
+  for (step = 1; step < p; step *= 2) {
+    for (m = 0, i = 0; i + step < p; i += 2*step, m++) {
+      jobs[m].lo = bound[i];
+      jobs[m].mid = bound[i+step];
+      jobs[m].hi = bound[(i + 2*step < p) ? i + 2*step : p];
+      jobs[m].merge = 1;
+    }
+    uthash_sort_run(jobs, m);
+  }
+}
+
+#define HASH_SORT_PAR_BYTES(n) (2 * (size_t)(n) * sizeof(void*))
+#define HASH_SRT_PARALLEL(hh,head,cmpfcn,nthreads)                               \
+do {                                                                             \
+  UT_hash_cmp *_hsp_cmp = (cmpfcn);                                              \
+  void **_hsp_elts = NULL;                                                       \
+  UT_hash_size _hsp_n = 0, _hsp_j;                                               \
+  UT_hash_handle *_hsp_hh;                                                       \
+  if (head) {                                                                    \
+    _hsp_n = HASH_TBL(hh,head)->num_items;                                       \
+    _hsp_elts = (void**)uthash_malloc(HASH_SORT_PAR_BYTES(_hsp_n));              \
+    if (_hsp_elts) {                                                             \
+      _hsp_hh = &((head)->hh);                                                   \
+      for (_hsp_j = 0; _hsp_j < _hsp_n; _hsp_j++) {                              \
+        _hsp_elts[_hsp_j] = ELMT_FROM_HH(HASH_TBL(hh,head), _hsp_hh);            \
+        _hsp_hh = HASH_HH_NEXT(HASH_TBL(hh,head), _hsp_hh);                      \
+      }                                                                          \
+      uthash_sort_par(_hsp_elts, _hsp_elts + _hsp_n, (size_t)_hsp_n, _hsp_cmp,   \
+                      (_hsp_n >= HASH_SORT_PAR_MIN) ? (unsigned)(nthreads) : 1); \
+      HASH_SRT_RELINK(hh,head,_hsp_elts,_hsp_n);                                 \
+      uthash_free(_hsp_elts, HASH_SORT_PAR_BYTES(_hsp_n));                       \
+      HASH_FSCK(hh,head);                                                        \
+    } else {                                                                     \
+      HASH_SRT_LIST(hh,head,_hsp_cmp);                                           \
+    }                                                                            \
+  }                                                                              \
+} while (0)
+#define HASH_SORT_PARALLEL(head,cmpfcn,nthreads)                                 \
+    HASH_SRT_PARALLEL(hh,head,cmpfcn,nthreads)
+#endif
+
+#define HASH_SRT(hh,head,cmpfcn)                                                 \
+do {                                                                             \
+  void **_hs_elts = NULL, **_hs_out = NULL;                                      \
+  UT_hash_size _hs_n = 0, _hs_j;                                                 \
+  UT_hash_handle *_hs_hh;                                                        \
+  if (head) {                                                                    \
+    _hs_n = HASH_TBL(hh,head)->num_items;                                        \
+    if (_hs_n >= HASH_SORT_ARRAY_MIN) {                                          \
+      _hs_elts = (void**)uthash_malloc(HASH_SORT_BYTES(_hs_n));                  \
+    }                                                                            \
+  }                                                                              \
+  if (_hs_elts) {                                                                \
+    _hs_hh = &((head)->hh);                                                      \
+    for (_hs_j = 0; _hs_j < _hs_n; _hs_j++) {                                    \
+      _hs_elts[_hs_j] = ELMT_FROM_HH(HASH_TBL(hh,head), _hs_hh);                 \
+      _hs_hh = HASH_HH_NEXT(HASH_TBL(hh,head), _hs_hh);                          \
+    }                                                                            \
+    HASH_SRT_ARRAY(head,cmpfcn,_hs_elts,_hs_n,_hs_out);                          \
+    HASH_SRT_RELINK(hh,head,_hs_out,_hs_n);                                      \
+    uthash_free(_hs_elts, HASH_SORT_BYTES(_hs_n));                               \
+    HASH_FSCK(hh,head);                                                          \
+  } else {                                                                       \
+    HASH_SRT_LIST(hh,head,cmpfcn);                                               \
+  }                                                                              \
+} while (0)
+
+/* relink the application order of the n items of a table in the order of
+ * the array elts */
+#define HASH_SRT_RELINK(hh,head,elts,n)                                          \
+do {                                                                             \
+  UT_hash_size _hsr_i;                                                           \
+  UT_hash_handle *_hsr_hh, *_hsr_tail = NULL;                                    \
+  for (_hsr_i = 0; _hsr_i < (n); _hsr_i++) {                                     \
+    _hsr_hh = (UT_hash_handle*)((char*)((elts)[_hsr_i]) +                        \
+                                HASH_TBL(hh,head)->hho);                         \
+    HASH_HH_SET_PREV(HASH_TBL(hh,head), _hsr_hh, _hsr_tail);                     \
+    if (_hsr_tail) {                                                             \
+      HASH_HH_SET_NEXT(HASH_TBL(hh,head), _hsr_tail, _hsr_hh);                   \
+    }                                                                            \
+    _hsr_tail = _hsr_hh;                                                         \
+  }                                                                              \
+  HASH_HH_SET_NEXT(HASH_TBL(hh,head), _hsr_tail, NULL);                          \
+  HASH_TBL_SET_TAIL(HASH_TBL(hh,head), _hsr_tail);                               \
+  HASH_RCU_ASSIGN(head,(elts)[0]);                                               \
+} while (0)
+
+/* HASH_SORT_BY_UINT(hh,head,field) sorts a table by an unsigned integer field
+ * of its items, of 1, 2, 4 or 8 bytes, HASH_SORT_BY_INT by a signed one, and
+ * HASH_SORT_BY_HASHV by the items' hash values. No comparison function is
+ * called: the keys are copied into an array beside pointers to their items,
+ * and sorted by an LSD radix sort on bytes, which skips the bytes in which
+ * all the keys agree. The sort is stable. */
+typedef struct UT_hash_radix {
+  uint64_t key;
+  void *elt;
+} UT_hash_radix;
+
+/* the key of a radix sort: the size bytes at p, an unsigned integer, or with
+ * sign set, a signed one with its sign bit flipped to order it as unsigned */
+static HASH_INLINE uint64_t uthash_radix_key(const void *p, size_t size,
+                                             int sign) {
+  unsigned char u8;
+  unsigned short u16;
+  uint32_t u32;
+  uint64_t u64;
+  switch (size) {
+    case 1: memcpy(&u8, p, 1); u64 = u8; break;
+    case 2: memcpy(&u16, p, 2); u64 = u16; break;
+    case 4: memcpy(&u32, p, 4); u64 = u32; break;
+    case 8: memcpy(&u64, p, 8); break;
+    default: uthash_fatal("sort key is not of 1, 2, 4 or 8 bytes"); u64 = 0;
+  }
+  return sign ? (u64 ^ ((uint64_t)1 << (8*size - 1))) : u64;
+}
+
+/* sort the n (at least one) entries at a by key, stably, using tmp (n more)
+ * as scratch; returns whichever of the two holds the result */
+static HASH_INLINE UT_hash_radix *uthash_radix_sort(UT_hash_radix *a,
+                                                   UT_hash_radix *tmp,
+                                                   size_t n) {
+  size_t count[8][256], i, sum, c;
+  unsigned d;
+  UT_hash_radix *src = a, *dst = tmp, *swap;
+  memset(count, 0, sizeof(count));
+  for (i = 0; i < n; i++) {
+    for (d = 0; d < 8; d++) count[d][(a[i].key >> (8*d)) & 0xff]++;
+  }
+  for (d = 0; d < 8; d++) {
+    if (count[d][(a[0].key >> (8*d)) & 0xff] == n) continue;
+    for (sum = 0, i = 0; i < 256; i++) {
+      c = count[d][i];
+      count[d][i] = sum;
+      sum += c;
+    }
+    for (i = 0; i < n; i++) {
+      dst[count[d][(src[i].key >> (8*d)) & 0xff]++] = src[i];
+    }
+    swap = src; src = dst; dst = swap;
+  }
+  return src;
+}
+
+#define HASH_SORT_BY_UINT(hh,head,field) HASH_SRT_RADIX(hh,head,field,0)
+#define HASH_SORT_BY_INT(hh,head,field) HASH_SRT_RADIX(hh,head,field,1)
+#define HASH_SORT_BY_HASHV(hh,head) HASH_SRT_RADIX(hh,head,hh.hashv,0)
+#define HASH_SRT_RADIX(hh,head,field,sign)                                       \
+do {                                                                             \
+  UT_hash_radix *_hsx_a, *_hsx_out;                                              \
+  void **_hsx_elts;                                                              \
+  UT_hash_size _hsx_n, _hsx_i;                                                   \
+  UT_hash_handle *_hsx_hh;                                                       \
+  ptrdiff_t _hsx_off;                                                            \
+  if (head) {                                                                    \
+    _hsx_n = HASH_TBL(hh,head)->num_items;                                       \
+    _hsx_off = (char*)(&((head)->field)) - (char*)(head);                        \
+    _hsx_a = (UT_hash_radix*)uthash_malloc(                                      \
+             2 * (size_t)_hsx_n * sizeof(UT_hash_radix));                        \
+    if (!_hsx_a) { uthash_fatal( "out of memory"); }                             \
+    _hsx_hh = &((head)->hh);                                                     \
+    for (_hsx_i = 0; _hsx_i < _hsx_n; _hsx_i++) {                                \
+      _hsx_a[_hsx_i].elt = ELMT_FROM_HH(HASH_TBL(hh,head), _hsx_hh);             \
+      _hsx_a[_hsx_i].key = uthash_radix_key(                                     \
+        (char*)_hsx_a[_hsx_i].elt + _hsx_off, sizeof((head)->field), sign);      \
+      _hsx_hh = HASH_HH_NEXT(HASH_TBL(hh,head), _hsx_hh);                        \
+    }                                                                            \
+    _hsx_out = uthash_radix_sort(_hsx_a, _hsx_a + _hsx_n, (size_t)_hsx_n);       \
+    _hsx_elts = (void**)((_hsx_out == _hsx_a) ? _hsx_a + _hsx_n : _hsx_a);       \
+    for (_hsx_i = 0; _hsx_i < _hsx_n; _hsx_i++) {                                \
+      _hsx_elts[_hsx_i] = _hsx_out[_hsx_i].elt;                                  \
+    }                                                                            \
+    HASH_SRT_RELINK(hh,head,_hsx_elts,_hsx_n);                                   \
+    uthash_free(_hsx_a, 2 * (size_t)_hsx_n * sizeof(UT_hash_radix));             \
+    HASH_FSCK(hh,head);                                                          \
+  }                                                                              \
+} while (0)
+
 /* This function selects items from one hash into another hash. 
  * The end result is that the selected items have dual presence 
  * in both hashes. There is no copy of the items made; rather 
@@ -783,34 +3673,44 @@ do {
  * hash handle that must be present in the structure. */
 #define HASH_SELECT(hh_dst, dst, hh_src, src, cond)                              \
 do {                                                                             \
-  unsigned _src_bkt, _dst_bkt;                                                   \
-  void *_last_elt=NULL, *_elt;                                                   \
+  UT_hash_size _src_bkt, _dst_bkt;                                               \
+  void *_elt;                                                                    \
   UT_hash_handle *_src_hh, *_dst_hh, *_last_elt_hh=NULL;                         \
   ptrdiff_t _dst_hho = ((char*)(&(dst)->hh_dst) - (char*)(dst));                 \
   if (src) {                                                                     \
-    for(_src_bkt=0; _src_bkt < (src)->hh_src.tbl->num_buckets; _src_bkt++) {     \
-      for(_src_hh = (src)->hh_src.tbl->buckets[_src_bkt].hh_head;                \
+    HASH_EXPAND_COMPLETE(HASH_TBL(hh_src,src));                                  \
+    for(_src_bkt=0; _src_bkt < HASH_TBL(hh_src,src)->num_buckets; _src_bkt++) {  \
+      for(_src_hh = HASH_BKT_HEAD(HASH_TBL_BUCKETS(HASH_TBL(hh_src,src)) +       \
+                                  _src_bkt);                                     \
           _src_hh;                                                               \
-          _src_hh = _src_hh->hh_next) {                                          \
-          _elt = ELMT_FROM_HH((src)->hh_src.tbl, _src_hh);                       \
+          _src_hh = HASH_HH_CHAIN_NEXT(HASH_TBL(hh_src,src), _src_hh)) {         \
+          _elt = ELMT_FROM_HH(HASH_TBL(hh_src,src), _src_hh);                    \
           if (cond(_elt)) {                                                      \
             _dst_hh = (UT_hash_handle*)(((char*)_elt) + _dst_hho);               \
-            _dst_hh->key = _src_hh->key;                                         \
+            HASH_HH_SET_KEY(_dst_hh, HASH_HH_KEY(_src_hh));                      \
             _dst_hh->keylen = _src_hh->keylen;                                   \
             _dst_hh->hashv = _src_hh->hashv;                                     \
-            _dst_hh->prev = _last_elt;                                           \
-            _dst_hh->next = NULL;                                                \
-            if (_last_elt_hh) { _last_elt_hh->next = _elt; }                     \
             if (!dst) {                                                          \
               DECLTYPE_ASSIGN(dst,_elt);                                         \
               HASH_MAKE_TABLE(hh_dst,dst);                                       \
             } else {                                                             \
-              _dst_hh->tbl = (dst)->hh_dst.tbl;                                  \
+              HASH_HH_SET_TBL(_dst_hh, HASH_TBL(hh_dst,dst));                    \
             }                                                                    \
-            HASH_TO_BKT(_dst_hh->hashv, _dst_hh->tbl->num_buckets, _dst_bkt);    \
-            HASH_ADD_TO_BKT(_dst_hh->tbl->buckets[_dst_bkt],_dst_hh);            \
-            (dst)->hh_dst.tbl->num_items++;                                      \
-            _last_elt = _elt;                                                    \
+            HASH_HH_SET_PREV(HASH_HH_TBL(_dst_hh), _dst_hh, _last_elt_hh);       \
+            HASH_HH_SET_NEXT(HASH_HH_TBL(_dst_hh), _dst_hh, NULL);               \
+            if (_last_elt_hh) {                                                  \
+              HASH_HH_SET_NEXT(HASH_HH_TBL(_dst_hh), _last_elt_hh, _dst_hh);     \
+            }                                                                    \
+            HASH_TBL_SET_TAIL(HASH_HH_TBL(_dst_hh), _dst_hh);                    \
+            HASH_EXPAND_STEP(HASH_HH_TBL(_dst_hh));                              \
+            HASH_SELECT_HASHV(HASH_HH_TBL(_dst_hh), _dst_hh);                    \
+            HASH_TO_BKT(_dst_hh->hashv, HASH_HH_TBL(_dst_hh)->num_buckets,       \
+                        _dst_bkt);                                               \
+            HASH_ADD_TO_BKT(HASH_BKT(HASH_HH_TBL(_dst_hh), _dst_hh->hashv,       \
+                                     _dst_bkt),                                  \
+                            _dst_hh);                                            \
+            HASH_BLOOM_ADD(HASH_HH_TBL(_dst_hh),_dst_hh->hashv);                 \
+            HASH_TBL(hh_dst,dst)->num_items++;                                   \
             _last_elt_hh = _dst_hh;                                              \
           }                                                                      \
       }                                                                          \
@@ -821,31 +3721,133 @@ do {
 
 #define HASH_CLEAR(hh,head)                                                      \
 do {                                                                             \
+  UT_hash_table *_hcl_tbl;                                                       \
+  if (head) {                                                                    \
+    _hcl_tbl = HASH_TBL(hh,head);                                                \
+    HASH_RCU_ASSIGN(head,NULL);                                                  \
+    HASH_RCU_SYNC(_hcl_tbl);                                                     \
+    HASH_FREE_BUCKETS(_hcl_tbl);                                                 \
+    HASH_BLOOM_FREE(_hcl_tbl);                                                   \
+    HASH_TBL_FREE(_hcl_tbl, _hcl_tbl, sizeof(UT_hash_table));                    \
+  }                                                                              \
+} while(0)
+
+/* HASH_DESTROY frees a whole table at once: head is set to NULL, free_fn is
+ * called on each item in a tight loop, and the table goes as in HASH_CLEAR.
+ * None of the unlinking of HASH_DELETE is done. */
+#define HASH_DESTROY(hh,head,free_fn)                                            \
+do {                                                                             \
+  UT_hash_table *_hdy_tbl;                                                       \
+  struct UT_hash_handle *_hdy_hh, *_hdy_next;                                    \
   if (head) {                                                                    \
-    uthash_free((head)->hh.tbl->buckets,                                         \
-                (head)->hh.tbl->num_buckets*sizeof(struct UT_hash_bucket));      \
-    HASH_BLOOM_FREE((head)->hh.tbl);                                             \
-    uthash_free((head)->hh.tbl, sizeof(UT_hash_table));                          \
-    (head)=NULL;                                                                 \
+    _hdy_tbl = HASH_TBL(hh,head);                                                \
+    _hdy_hh = &((head)->hh);                                                     \
+    HASH_RCU_ASSIGN(head,NULL);                                                  \
+    HASH_RCU_SYNC(_hdy_tbl);                                                     \
+    for( ; _hdy_hh; _hdy_hh = _hdy_next) {                                       \
+      _hdy_next = HASH_HH_NEXT(_hdy_tbl, _hdy_hh);                               \
+      free_fn(DECLTYPE(head)ELMT_FROM_HH(_hdy_tbl, _hdy_hh));                    \
+    }                                                                            \
+    HASH_FREE_BUCKETS(_hdy_tbl);                                                 \
+    HASH_BLOOM_FREE(_hdy_tbl);                                                   \
+    HASH_TBL_FREE(_hdy_tbl, _hdy_tbl, sizeof(UT_hash_table));                    \
   }                                                                              \
 } while(0)
 
+/* A slab hands out items of one size from blocks of HASH_SLAB_ELTS, reusing
+ * those that are given back. Its items can be released all at once, with
+ * the table that holds them (HASH_DESTROY_SLAB) or on their own
+ * (HASH_SLAB_RELEASE), without visiting them. A slab starts zeroed, and is
+ * set up by HASH_SLAB_INIT(slab, type). */
+#ifndef HASH_SLAB_ELTS
+#define HASH_SLAB_ELTS 1024      /* items per block of a slab              */
+#endif
+#define HASH_SLAB_HDR 16         /* block header: its link, padded         */
+typedef struct UT_hash_slab {
+  size_t elt_size, per_block;
+  void *blocks;                  /* linked through their first word        */
+  void *free_list;               /* items given back, linked likewise      */
+  char *next;                    /* the unused tail of the newest block    */
+  size_t left;                   /* and how many items it has room for     */
+} UT_hash_slab;
+
+static HASH_INLINE void uthash_slab_init(UT_hash_slab *slab, size_t elt_size) {
+  memset(slab, 0, sizeof(*slab));
+  if (elt_size < sizeof(void*)) elt_size = sizeof(void*);
+  slab->elt_size = (elt_size + sizeof(void*) - 1) & ~(sizeof(void*) - 1);
+  slab->per_block = HASH_SLAB_ELTS;
+}
+
+static HASH_INLINE void *uthash_slab_alloc(UT_hash_slab *slab) {
+  void *p;
+  char *block;
+  if ((p = slab->free_list) != NULL) {
+    memcpy(&slab->free_list, p, sizeof(void*));
+    return p;
+  }
+  if (!slab->left) {
+    block = (char*)uthash_malloc(HASH_SLAB_HDR +
+                                 slab->per_block * slab->elt_size);
+    if (!block) { uthash_fatal( "out of memory"); return NULL; }
+    memcpy(block, &slab->blocks, sizeof(void*));
+    slab->blocks = block;
+    slab->next = block + HASH_SLAB_HDR;
+    slab->left = slab->per_block;
+  }
+  p = slab->next;
+  slab->next += slab->elt_size;
+  slab->left--;
+  return p;
+}
+
+static HASH_INLINE void uthash_slab_free(UT_hash_slab *slab, void *p) {
+  memcpy(p, &slab->free_list, sizeof(void*));
+  slab->free_list = p;
+}
+
+/* free every block; all the items of the slab are gone */
+static HASH_INLINE void uthash_slab_release(UT_hash_slab *slab) {
+  void *block, *next;
+  for (block = slab->blocks; block; block = next) {
+    memcpy(&next, block, sizeof(void*));
+    uthash_free(block, HASH_SLAB_HDR + slab->per_block * slab->elt_size);
+  }
+  uthash_slab_init(slab, slab->elt_size);
+}
+
+#define HASH_SLAB_INIT(slab,type) uthash_slab_init(slab, sizeof(type))
+#define HASH_SLAB_ALLOC(slab,out)                                                \
+  ((out) = DECLTYPE(out)uthash_slab_alloc(slab))
+#define HASH_SLAB_FREE(slab,elt) uthash_slab_free(slab, elt)
+#define HASH_SLAB_RELEASE(slab) uthash_slab_release(slab)
+
+/* free the table, and every item of the slab (in the table or not) */
+#define HASH_DESTROY_SLAB(hh,head,slab)                                          \
+do {                                                                             \
+  HASH_CLEAR(hh,head);                                                           \
+  uthash_slab_release(slab);                                                     \
+} while(0)
+
 #ifdef NO_DECLTYPE
 #define HASH_ITER(hh,head,el,tmp)                                                \
-for((el)=(head), (*(char**)(&(tmp)))=(char*)((head)?(head)->hh.next:NULL);       \
-  el; (el)=(tmp),(*(char**)(&(tmp)))=(char*)((tmp)?(tmp)->hh.next:NULL)) 
+for((el)=(head), (*(char**)(&(tmp)))=(char*)((head)?HASH_NEXT(hh,head):NULL);    \
+  el; (el)=(tmp),(*(char**)(&(tmp)))=(char*)((tmp)?HASH_NEXT(hh,tmp):NULL)) 
 #else
 #define HASH_ITER(hh,head,el,tmp)                                                \
-for((el)=(head),(tmp)=DECLTYPE(el)((head)?(head)->hh.next:NULL);                 \
-  el; (el)=(tmp),(tmp)=DECLTYPE(el)((tmp)?(tmp)->hh.next:NULL))
+for((el)=(head),(tmp)=DECLTYPE(el)((head)?HASH_NEXT(hh,head):NULL);              \
+  el; (el)=(tmp),(tmp)=DECLTYPE(el)((tmp)?HASH_NEXT(hh,tmp):NULL))
 #endif
 
 /* obtain a count of items in the hash */
 #define HASH_COUNT(head) HASH_CNT(hh,head) 
-#define HASH_CNT(hh,head) ((head)?((head)->hh.tbl->num_items):0)
+#define HASH_CNT(hh,head) ((head)?(HASH_TBL(hh,head)->num_items):0)
 
 typedef struct UT_hash_bucket {
+#ifdef HASH_RELOCATABLE
+   ptrdiff_t hh_head;                /* offset from uthash_reloc_base  */
+#else
    struct UT_hash_handle *hh_head;
+#endif
    unsigned count;
 
    /* expand_mult is normally set to 0. In this situation, the max chain length
@@ -862,27 +3864,61 @@ typedef struct UT_hash_bucket {
     */
    unsigned expand_mult;
 
+#ifdef HASH_FINGERPRINT
+   /* while count <= HASH_FP_SLOTS these mirror the chain: the hashv and the
+    * handle of each item, in no particular order. Otherwise they're unused.
+    * (With HASH_64BIT, the high half of the hashv: see HASH_FP_OF.) */
+   uint32_t fp[HASH_FP_SLOTS];
+   struct UT_hash_handle *fp_hh[HASH_FP_SLOTS];
+#endif
+
 } UT_hash_bucket;
 
 /* random signature used only to find hash tables in external analysis */
 #define HASH_SIGNATURE 0xa0111fe1
 #define HASH_BLOOM_SIGNATURE 0xb12220f2
 
+#ifdef HASH_RCU
+/* a set of lock-free readers (see HASH_RCU_READ_LOCK); zero-initialized */
+typedef struct UT_hash_rcu_reader {
+   unsigned long epoch; /* 0 outside a read section, else 1 + entry epoch */
+   char pad[HASH_RCU_LINE - sizeof(unsigned long)];
+} UT_hash_rcu_reader;
+
+typedef struct UT_hash_rcu {
+   unsigned long epoch;
+   char pad[HASH_RCU_LINE - sizeof(unsigned long)];
+   UT_hash_rcu_reader readers[HASH_RCU_READERS];
+} UT_hash_rcu;
+#endif
+
 typedef struct UT_hash_table {
+#ifdef HASH_RELOCATABLE
+   ptrdiff_t buckets;
+#else
    UT_hash_bucket *buckets;
-   unsigned num_buckets, log2_num_buckets;
-   unsigned num_items;
+#endif
+   UT_hash_size num_buckets;
+   unsigned log2_num_buckets;
+   UT_hash_size num_items;
+#ifdef HASH_RELOCATABLE
+   ptrdiff_t tail;
+#else
    struct UT_hash_handle *tail; /* tail hh in app order, for fast append    */
+#endif
    ptrdiff_t hho; /* hash handle offset (byte pos of hash handle in element */
+#if defined(HASH_COMPACT) && !defined(HASH_RELOCATABLE)
+   char *hh_base; /* compact handle links are offsets from this address     */
+#endif
 
    /* in an ideal situation (all buckets used equally), no bucket would have
     * more than ceil(#items/#buckets) items. that's the ideal chain length. */
-   unsigned ideal_chain_maxlen;
+   UT_hash_size ideal_chain_maxlen;
 
    /* nonideal_items is the number of items in the hash whose chain position
     * exceeds the ideal chain maxlen. these items pay the penalty for an uneven
     * hash distribution; reaching them in a chain traversal takes >ideal steps */
-   unsigned nonideal_items;
+   UT_hash_size nonideal_items;
 
    /* ineffective expands occur when a bucket doubling was performed, but 
     * afterward, more than half the items in the hash had nonideal chain
@@ -892,24 +3928,437 @@ typedef struct UT_hash_table {
     * the hash will still work, albeit no longer in constant time. */
    unsigned ineff_expands, noexpand;
 
+#ifdef HASH_SEEDED
+   /* seed of the hash function, and the number of times it was replaced
+    * after expansion proved ineffective (see HASH_RESEED) */
+   uint64_t seed;
+   unsigned reseeds;
+#endif
+
+#ifdef HASH_TABLE_FCN
+   UT_hash_fcn *fcn; /* hash function, or NULL for HASH_FCN (see HASH_SET_FCN) */
+#ifdef HASH_AUTO_FCN
+   unsigned fcn_chosen; /* the table has chosen its hash function */
+#endif
+#endif
+
+#ifdef HASH_RCU
+   /* the domain of the table's lock-free readers, or NULL if it has none,
+    * and the count that is odd while items are being redistributed */
+   struct UT_hash_rcu *rcu;
+   unsigned long rcu_seq;
+#endif
+
+#ifdef HASH_TABLE_ALLOC
+   /* the allocator of the table, its buckets and its filter, or NULL */
+   struct UT_hash_alloc *alloc;
+#endif
+
+#ifdef HASH_INCREMENTAL
+   /* while an incremental expansion is in flight, the pre-expansion buckets.
+    * Those below migrate_bkt are already empty; the rest still hold items. */
+   UT_hash_bucket *old_buckets;
+   UT_hash_size old_num_buckets, migrate_bkt;
+#endif
+
    uint32_t signature; /* used only to find hash tables in external analysis */
 #ifdef HASH_BLOOM
    uint32_t bloom_sig; /* used only to test bloom exists in external analysis */
+#ifdef HASH_RELOCATABLE
+   ptrdiff_t bloom_bv;
+#else
    uint8_t *bloom_bv;
+#endif
    char bloom_nbits;
 #endif
 
 } UT_hash_table;
 
 typedef struct UT_hash_handle {
+#ifdef HASH_RELOCATABLE
+   ptrdiff_t tbl;                    /* offset from uthash_reloc_base  */
+#else
    struct UT_hash_table *tbl;
+#endif
+#ifdef HASH_COMPACT
+   int32_t prev;                     /* prev hh in app order           */
+   int32_t next;                     /* next hh in app order           */
+   int32_t hh_next;                  /* next hh in bucket order        */
+   int32_t key;                      /* key offset from this hh        */
+#else
    void *prev;                       /* prev element in app order      */
    void *next;                       /* next element in app order      */
    struct UT_hash_handle *hh_prev;   /* previous hh in bucket order    */
    struct UT_hash_handle *hh_next;   /* next hh in bucket order        */
    void *key;                        /* ptr to enclosing struct's key  */
-   unsigned keylen;                  /* enclosing struct's key len     */
-   unsigned hashv;                   /* result of hash-fcn(key)        */
+#endif
+   UT_hash_size keylen;              /* enclosing struct's key len     */
+   UT_hash_value hashv;              /* result of hash-fcn(key)        */
 } UT_hash_handle;
 
+/* A snapshot (-DHASH_SNAPSHOT) is a file holding a table in a form that can
+ * be mapped and searched in place, by another process or a later run, with
+ * no parsing and no allocation. HASH_SAVE writes one; HASH_MAP maps one
+ * read-only into a UT_hash_map, which HASH_MAP_FIND searches. The file holds
+ * only offsets, in native byte order:
+ *
+ *   header     UT_hash_snap_hdr
+ *   buckets    num_buckets+1 uint64_t: the index of the first entry of each
+ *              bucket (a bucket's entries end where the next one's begin)
+ *   entries    num_items UT_hash_snap_ent, grouped by bucket
+ *   elements   num_items copies of the items, elt_size bytes each, in the
+ *              order of the entries, with their hash handles zeroed
+ *   keys       the keys that are not inside their item (HASH_ADD_KEYPTR)
+ *
+ * Each region starts on a multiple of HASH_SNAP_ALIGN bytes. Pointers inside
+ * the items are copied as they are, and mean nothing in the mapping. The
+ * header records the hash function (by number, for the built-in ones) and
+ * seed of the table, and the hash value of a probe key, so that a program
+ * that would hash keys differently is refused the file. */
+#ifdef HASH_SNAPSHOT
+#include <stdio.h>      /* fopen, fwrite, rename */
+#include <fcntl.h>      /* open */
+#include <unistd.h>     /* close, fsync */
+#include <sys/stat.h>   /* fstat */
+#include <sys/mman.h>   /* mmap, munmap */
+
+#define HASH_SNAP_SIGNATURE 0xc13330f3
+#define HASH_SNAP_VERSION 1
+#define HASH_SNAP_ALIGN 64
+#define HASH_SNAP_ROUND(off)                                                     \
+  (((off) + HASH_SNAP_ALIGN - 1) & ~(uint64_t)(HASH_SNAP_ALIGN - 1))
+#define HASH_SNAP_PROBE "uthash snapshot"
+#define HASH_SNAP_FCN_CUSTOM 255 /* a hash function set by the program     */
+#define HASH_SNAP_FCN_MAX 11     /* the highest number of a built-in one   */
+
+typedef struct UT_hash_snap_hdr {
+   uint32_t signature;
+   uint32_t version;
+   uint32_t hashv_size;    /* sizeof(UT_hash_value) of the writer            */
+   uint32_t fcn;           /* 0 for HASH_FCN, else see uthash_snap_fcn       */
+   uint64_t seed;
+   uint64_t probe;         /* hash value of HASH_SNAP_PROBE                  */
+   uint64_t num_buckets, num_items, elt_size, hho;
+   uint64_t bkt_off, ent_off, elt_off, key_off, file_size;
+} UT_hash_snap_hdr;
+
+typedef struct UT_hash_snap_ent {
+   uint64_t hashv;
+   uint64_t key;           /* file offset of the key                         */
+   uint64_t keylen;
+} UT_hash_snap_ent;
+
+/* a mapped snapshot. Its seed and fcn take the place of those of a table
+ * (HASH_FCN_TBL), so they keep the names of the table's fields. */
+typedef struct UT_hash_map {
+   const char *base;
+   size_t len;
+   const uint64_t *bkts;
+   const UT_hash_snap_ent *ents;
+   const char *elts;
+   UT_hash_size num_buckets, num_items;
+   size_t elt_size;
+#ifdef HASH_SEEDED
+   uint64_t seed;
+#endif
+#ifdef HASH_TABLE_FCN
+   UT_hash_fcn *fcn;
+#endif
+} UT_hash_map;
+
+#ifdef HASH_TABLE_FCN
+/* the built-in hash functions, numbered from 1 for the snapshot header */
+static HASH_INLINE UT_hash_fcn *uthash_snap_fcn(unsigned id) {
+  switch(id) {
+    case 1: return uthash_fcn_jen;
+    case 2: return uthash_fcn_ber;
+    case 3: return uthash_fcn_sax;
+    case 4: return uthash_fcn_oat;
+    case 5: return uthash_fcn_fnv;
+    case 6: return uthash_fcn_sfh;
+    case 7: return uthash_fcn_wyh;
+    case 8: return uthash_fcn_xxh;
+    case 9: return uthash_fcn_sip;
+#ifdef HASH_USING_NO_STRICT_ALIASING
+    case 10: return uthash_fcn_mur;
+#endif
+    case 11: return uthash_fcn_xx3;
+    default: return NULL;
+  }
+}
+static HASH_INLINE unsigned uthash_snap_fcn_id(UT_hash_fcn *fcn) {
+  unsigned id;
+  if (!fcn || fcn == uthash_fcn_default) return 0;
+  for(id = 1; id <= HASH_SNAP_FCN_MAX; id++) {
+    if (uthash_snap_fcn(id) == fcn) return id;
+  }
+  return HASH_SNAP_FCN_CUSTOM;
+}
+#define HASH_SNAP_FCN_ID(tbl) uthash_snap_fcn_id((tbl)->fcn)
+#else
+#define HASH_SNAP_FCN_ID(tbl) 0
+#endif
+
+/* the hash value of HASH_SNAP_PROBE in tbl (a table or a map) */
+#define HASH_SNAP_PROBE_HASHV(tbl,hashv)                                         \
+do {                                                                             \
+  UT_hash_size _hsp_bkt;                                                         \
+  HASH_FCN_TBL(tbl, HASH_SNAP_PROBE, strlen(HASH_SNAP_PROBE), 1, hashv,          \
+               _hsp_bkt);                                                        \
+  (void)_hsp_bkt;                                                                \
+} while(0)
+
+/* write the table tbl (NULL if empty) of items of elt_size bytes to path;
+ * 0 on success, -1 on an I/O error. No expansion may be in flight. The file
+ * is written as path.tmp, synced, then renamed over path, so a process that
+ * has the old snapshot mapped keeps it intact, and a crash leaves either the
+ * old file or the new one at path. */
+static HASH_INLINE int uthash_snap_save(const char *path, UT_hash_table *tbl,
+                                        size_t elt_size) {
+  static const char zeros[HASH_SNAP_ALIGN] = {0};
+  UT_hash_snap_hdr hdr;
+  UT_hash_snap_ent ent;
+  UT_hash_value probe;
+  UT_hash_size b, nb = tbl ? tbl->num_buckets : 1;
+  struct UT_hash_handle *hh;
+  uint64_t pos, idx = 0, keys = 0;
+  char *elt, *key, *buf = NULL, *tmp;
+  size_t tmp_len = strlen(path) + sizeof(".tmp");
+  int fd, rc;
+  FILE *fp;
+
+  if ((tmp = (char*)uthash_malloc(tmp_len)) == NULL) {
+    uthash_fatal( "out of memory");
+  }
+  memcpy(tmp, path, tmp_len - sizeof(".tmp"));
+  memcpy(tmp + tmp_len - sizeof(".tmp"), ".tmp", sizeof(".tmp"));
+  if ((fp = fopen(tmp, "wb")) == NULL) {
+    uthash_free(tmp, tmp_len);
+    return -1;
+  }
+  memset(&hdr, 0, sizeof(hdr));
+  hdr.signature = HASH_SNAP_SIGNATURE;
+  hdr.version = HASH_SNAP_VERSION;
+  hdr.hashv_size = sizeof(UT_hash_value);
+  hdr.num_buckets = nb;
+  hdr.elt_size = elt_size;
+  if (tbl) {
+    hdr.fcn = HASH_SNAP_FCN_ID(tbl);
+    hdr.seed = HASH_TBL_SEED(tbl);
+    HASH_SNAP_PROBE_HASHV(tbl, probe);
+    hdr.probe = probe;
+    hdr.num_items = tbl->num_items;
+    hdr.hho = (uint64_t)tbl->hho;
+    if ((buf = (char*)uthash_malloc(elt_size)) == NULL) {
+      uthash_fatal( "out of memory");
+    }
+  }
+  hdr.bkt_off = HASH_SNAP_ROUND(sizeof(hdr));
+  hdr.ent_off = HASH_SNAP_ROUND(hdr.bkt_off + (nb + 1) * sizeof(uint64_t));
+  hdr.elt_off = HASH_SNAP_ROUND(hdr.ent_off + hdr.num_items * sizeof(ent));
+  hdr.key_off = HASH_SNAP_ROUND(hdr.elt_off + hdr.num_items * elt_size);
+
+#define HASH_SNAP_PUT(p,n)                                                       \
+  do { if (fwrite((p), 1, (n), fp) != (n)) goto fail; pos += (n); } while(0)
+#define HASH_SNAP_PAD(off)                                                       \
+  do { if ((off) > pos) HASH_SNAP_PUT(zeros, (size_t)((off) - pos)); } while(0)
+#define HASH_SNAP_EACH(hh)                                                       \
+  for(b = 0; tbl && b < nb; b++)                                                 \
+    for(hh = HASH_BKT_HEAD(&HASH_TBL_BUCKETS(tbl)[b]); hh; hh = HASH_HH_CHAIN_NEXT(tbl, hh))
+
+  pos = 0;
+  HASH_SNAP_PUT(&hdr, sizeof(hdr));             /* rewritten at the end */
+  HASH_SNAP_PAD(hdr.bkt_off);
+  for(b = 0; b < nb; b++) {
+    HASH_SNAP_PUT(&idx, sizeof(idx));
+    idx += tbl ? HASH_TBL_BUCKETS(tbl)[b].count : 0;
+  }
+  HASH_SNAP_PUT(&idx, sizeof(idx));
+  HASH_SNAP_PAD(hdr.ent_off);
+  idx = 0;
+  HASH_SNAP_EACH(hh) {
+    elt = (char*)ELMT_FROM_HH(tbl, hh);
+    key = (char*)HASH_HH_KEY(hh);
+    ent.hashv = hh->hashv;
+    ent.keylen = hh->keylen;
+    if (key >= elt && key + hh->keylen <= elt + elt_size) {
+      ent.key = hdr.elt_off + idx * elt_size + (uint64_t)(key - elt);
+    } else {
+      ent.key = hdr.key_off + keys;
+      keys += hh->keylen;
+    }
+    HASH_SNAP_PUT(&ent, sizeof(ent));
+    idx++;
+  }
+  HASH_SNAP_PAD(hdr.elt_off);
+  HASH_SNAP_EACH(hh) {
+    memcpy(buf, ELMT_FROM_HH(tbl, hh), elt_size);
+    memset(buf + tbl->hho, 0, sizeof(UT_hash_handle));
+    HASH_SNAP_PUT(buf, elt_size);
+  }
+  HASH_SNAP_PAD(hdr.key_off);
+  HASH_SNAP_EACH(hh) {
+    elt = (char*)ELMT_FROM_HH(tbl, hh);
+    key = (char*)HASH_HH_KEY(hh);
+    if (!(key >= elt && key + hh->keylen <= elt + elt_size)) {
+      HASH_SNAP_PUT(key, hh->keylen);
+    }
+  }
+  hdr.file_size = pos;
+  if (fseek(fp, 0L, SEEK_SET) != 0) goto fail;
+  HASH_SNAP_PUT(&hdr, sizeof(hdr));
+#undef HASH_SNAP_PUT
+#undef HASH_SNAP_PAD
+#undef HASH_SNAP_EACH
+  rc = fclose(fp);
+  fp = NULL;
+  if (rc != 0) goto fail;
+  /* sync through a descriptor of our own: fileno is not in ISO C stdio */
+  if ((fd = open(tmp, O_WRONLY)) < 0) goto fail;
+  rc = fsync(fd);
+  close(fd);
+  if (rc != 0 || rename(tmp, path) != 0) goto fail;
+  if (buf) uthash_free(buf, elt_size);
+  uthash_free(tmp, tmp_len);
+  return 0;
+ fail:
+  if (buf) uthash_free(buf, elt_size);
+  if (fp) fclose(fp);
+  remove(tmp);
+  uthash_free(tmp, tmp_len);
+  return -1;
+}
+
+/* 1 if n elements of sz bytes at offset off fit in len bytes, and off is a
+ * multiple of HASH_SNAP_ALIGN; computed so that nothing can overflow */
+static HASH_INLINE int uthash_snap_fits(uint64_t off, uint64_t n, uint64_t sz,
+                                        size_t len) {
+  return off <= len && (off % HASH_SNAP_ALIGN) == 0 &&
+         (sz == 0 || n <= (len - off) / sz);
+}
+
+/* set up map to search the snapshot of len bytes at base; 0 if it's a
+ * snapshot this program can search, else -1. Every offset and count in the
+ * file is checked against len, so a damaged file is refused rather than
+ * read out of bounds. Under HASH_TABLE_FCN, a table that used a hash function
+ * of the program's own needs map->fcn to be set to that function beforehand. */
+static HASH_INLINE int uthash_snap_open(UT_hash_map *map, const void *base,
+                                        size_t len) {
+  const UT_hash_snap_hdr *hdr = (const UT_hash_snap_hdr*)base;
+  const uint64_t *bkts;
+  const UT_hash_snap_ent *ents;
+  UT_hash_value probe;
+  uint64_t i;
+  if (len < sizeof(*hdr) || hdr->signature != HASH_SNAP_SIGNATURE ||
+      hdr->version != HASH_SNAP_VERSION ||
+      hdr->hashv_size != sizeof(UT_hash_value) || hdr->file_size != len ||
+      hdr->num_buckets == 0 || (hdr->num_buckets & (hdr->num_buckets - 1)) ||
+      (UT_hash_size)hdr->num_buckets != hdr->num_buckets ||
+      (UT_hash_size)hdr->num_items != hdr->num_items ||
+      (size_t)hdr->elt_size != hdr->elt_size ||
+      !uthash_snap_fits(hdr->bkt_off, hdr->num_buckets + 1, sizeof(uint64_t),
+                        len) ||
+      !uthash_snap_fits(hdr->ent_off, hdr->num_items, sizeof(UT_hash_snap_ent),
+                        len) ||
+      !uthash_snap_fits(hdr->elt_off, hdr->num_items, hdr->elt_size, len) ||
+      !uthash_snap_fits(hdr->key_off, 0, 0, len)) {
+    return -1;
+  }
+  /* the buckets must divide the entries into runs, in order */
+  bkts = (const uint64_t*)((const char*)base + hdr->bkt_off);
+  if (bkts[0] != 0 || bkts[hdr->num_buckets] != hdr->num_items) return -1;
+  for(i = 0; i < hdr->num_buckets; i++) {
+    if (bkts[i] > bkts[i+1]) return -1;
+  }
+  ents = (const UT_hash_snap_ent*)((const char*)base + hdr->ent_off);
+  for(i = 0; i < hdr->num_items; i++) {
+    if (ents[i].key > len || ents[i].keylen > len - ents[i].key) return -1;
+  }
+  map->base = (const char*)base;
+  map->len = len;
+  map->bkts = bkts;
+  map->ents = ents;
+  map->elts = map->base + hdr->elt_off;
+  map->num_buckets = (UT_hash_size)hdr->num_buckets;
+  map->num_items = (UT_hash_size)hdr->num_items;
+  map->elt_size = (size_t)hdr->elt_size;
+#ifdef HASH_SEEDED
+  map->seed = hdr->seed;
+#else
+  if (hdr->seed != 0) return -1;
+#endif
+#ifdef HASH_TABLE_FCN
+  if (hdr->fcn != HASH_SNAP_FCN_CUSTOM) map->fcn = uthash_snap_fcn(hdr->fcn);
+  if (hdr->fcn != 0 && !map->fcn) return -1;     /* unknown, or not set */
+#else
+  if (hdr->fcn != 0) return -1;
+#endif
+  if (hdr->num_items) {
+    HASH_SNAP_PROBE_HASHV(map, probe);
+    if ((uint64_t)probe != hdr->probe) return -1;
+  }
+  return 0;
+}
+
+/* the item of map with the given key and hash value, or NULL */
+static HASH_INLINE const void *uthash_snap_find(const UT_hash_map *map,
+                                                const void *key, size_t keylen,
+                                                UT_hash_value hashv) {
+  const UT_hash_snap_ent *ent;
+  UT_hash_size bkt;
+  uint64_t i, end;
+  HASH_TO_BKT(hashv, map->num_buckets, bkt);
+  for(i = map->bkts[bkt], end = map->bkts[bkt+1]; i < end; i++) {
+    ent = &map->ents[i];
+    if (ent->hashv == (uint64_t)hashv && ent->keylen == keylen &&
+        HASH_KEYCMP(map->base + ent->key, key, keylen) == 0) {
+      return map->elts + i * map->elt_size;
+    }
+  }
+  return NULL;
+}
+
+/* map the snapshot at path read-only; rc is 0, or -1 if it can't be opened
+ * or searched (see uthash_snap_open) */
+static HASH_INLINE int uthash_snap_map(UT_hash_map *map, const char *path) {
+  struct stat st;
+  void *p;
+  int fd;
+  if ((fd = open(path, O_RDONLY)) < 0) return -1;
+  if (fstat(fd, &st) != 0 || st.st_size <= 0) { close(fd); return -1; }
+  p = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+  close(fd);
+  if (p == MAP_FAILED) return -1;
+  if (uthash_snap_open(map, p, (size_t)st.st_size) != 0) {
+    munmap(p, (size_t)st.st_size);
+    return -1;
+  }
+  return 0;
+}
+
+#define HASH_SAVE(hh,head,path,rc)                                               \
+do {                                                                             \
+  if (head) { HASH_EXPAND_COMPLETE(HASH_TBL(hh,head)); }                         \
+  (rc) = uthash_snap_save(path, (head) ? HASH_TBL(hh,head) : NULL,               \
+                         sizeof(*(head)));                                       \
+} while(0)
+#define HASH_MAP(map,path,rc) ((rc) = uthash_snap_map(map, path))
+#define HASH_UNMAP(map) munmap((void*)(map)->base, (map)->len)
+#define HASH_MAP_FIND(map,keyptr,keylen,out)                                     \
+do {                                                                             \
+  UT_hash_value _hmf_hashv;                                                      \
+  UT_hash_size _hmf_bkt;                                                         \
+  HASH_FCN_TBL(map, keyptr, keylen, (map)->num_buckets, _hmf_hashv, _hmf_bkt);   \
+  (void)_hmf_bkt;                                                                \
+  (out) = DECLTYPE(out)uthash_snap_find(map, keyptr, keylen, _hmf_hashv);        \
+} while(0)
+#define HASH_MAP_FIND_STR(map,findstr,out)                                       \
+    HASH_MAP_FIND(map,findstr,strlen(findstr),out)
+#define HASH_MAP_FIND_INT(map,findint,out)                                       \
+    HASH_MAP_FIND(map,findint,sizeof(int),out)
+#define HASH_MAP_COUNT(map) ((map)->num_items)
+/* the i-th item of map (i < HASH_MAP_COUNT), in bucket order */
+#define HASH_MAP_ITEM(map,i) ((const void*)((map)->elts + (i) * (map)->elt_size))
+#endif /* HASH_SNAPSHOT */
+
 #endif /* UTHASH_H */
@@ -27,6 +27,8 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #define UTLIST_VERSION 1.9.6
 
 #include <assert.h>
+#include <stdlib.h>   /* malloc */
+#include <stddef.h>   /* size_t */
 
 /* 
  * This file contains macros to manipulate singly and doubly-linked lists.
@@ -99,7 +101,7 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
  * The sort macro is an adaptation of Simon Tatham's O(n log(n)) mergesort    *
  * Unwieldy variable names used here to avoid shadowing passed-in variables.  *
  *****************************************************************************/
-#define LL_SORT(list, cmp)                                                                     \
+#define _LL_SORT_LIST(list, cmp)                                                               \
 do {                                                                                           \
   LDECLTYPE(list) _ls_p;                                                                       \
   LDECLTYPE(list) _ls_q;                                                                       \
@@ -155,7 +157,7 @@ do {
   } else _tmp=NULL; /* quiet gcc unused variable warning */                                    \
 } while (0)
 
-#define DL_SORT(list, cmp)                                                                     \
+#define _DL_SORT_LIST(list, cmp)                                                               \
 do {                                                                                           \
   LDECLTYPE(list) _ls_p;                                                                       \
   LDECLTYPE(list) _ls_q;                                                                       \
@@ -213,7 +215,7 @@ do {
   } else _tmp=NULL; /* quiet gcc unused variable warning */                                    \
 } while (0)
 
-#define CDL_SORT(list, cmp)                                                                    \
+#define _CDL_SORT_LIST(list, cmp)                                                              \
 do {                                                                                           \
   LDECLTYPE(list) _ls_p;                                                                       \
   LDECLTYPE(list) _ls_q;                                                                       \
@@ -283,6 +285,190 @@ do {
   } else _tmp=NULL; /* quiet gcc unused variable warning */                                    \
 } while (0)
 
+/******************************************************************************
+ * The sort macros sort lists of UTLIST_SORT_ARRAY or more items in an array: *
+ * one walk of the list counts the items, another copies pointers to them   *
+ * into an array, and a third relinks them in sorted order. The array sort  *
+ * is a stable mergesort of the runs already in the list (ascending runs,   *
+ * and strictly descending ones reversed), so a nearly sorted list costs    *
+ * one pass. Shorter lists, and lists whose array cannot be allocated, are  *
+ * sorted in place by the list mergesort.                                   *
+ *****************************************************************************/
+#ifndef UTLIST_SORT_ARRAY
+#define UTLIST_SORT_ARRAY 256
+#endif
+#define UTLIST_SORT_RUN 16       /* shortest run of the array sort */
+#ifndef utlist_malloc
+#define utlist_malloc(sz) malloc(sz)      /* malloc fcn, for the array sort */
+#endif
+#ifndef utlist_free
+#define utlist_free(ptr,sz) free(ptr)     /* free fcn                       */
+#endif
+#define _LS_BYTES(a,n) (2*(n)*sizeof(*(a)) + ((n)/UTLIST_SORT_RUN+2)*sizeof(size_t))
+
+/* count the items of the list, and if there are enough, copy them into a
+ * new array a; else a is NULL. Circular lists stop at the head. */
+#define _LS_GATHER(list,a,n)                                                                   \
+do {                                                                                           \
+  LDECLTYPE(list) _lsg_e;                                                                      \
+  LDECLTYPE(list) _lsg_head;                                                                   \
+  size_t _lsg_i;                                                                               \
+  (a) = NULL;                                                                                  \
+  (n) = 0;                                                                                     \
+  _CASTASGN(_lsg_head,list);                                                                   \
+  _CASTASGN(_lsg_e,list);                                                                      \
+  while (_lsg_e) {                                                                             \
+    (n)++;                                                                                     \
+    _SV(_lsg_e,list); _lsg_e = _NEXT(_lsg_e,list); _RS(list);                                  \
+    if (_lsg_e == _lsg_head) break;                                                            \
+  }                                                                                            \
+  if ((n) >= UTLIST_SORT_ARRAY) {                                                              \
+    (a) = (LDECLTYPE(list)*)utlist_malloc(_LS_BYTES(a,n));                                     \
+  }                                                                                            \
+  if (a) {                                                                                     \
+    _CASTASGN(_lsg_e,list);                                                                    \
+    for (_lsg_i = 0; _lsg_i < (n); _lsg_i++) {                                                 \
+      (a)[_lsg_i] = _lsg_e;                                                                    \
+      _SV(_lsg_e,list); _lsg_e = _NEXT(_lsg_e,list); _RS(list);                                \
+    }                                                                                          \
+  }                                                                                            \
+} while (0)
+
+/* stably sort the n items of a, using the rest of the _LS_BYTES(a,n) there
+ * as scratch; out is set to the array that holds the result */
+#define _LS_ASORT(list,cmp,a,n,out)                                                            \
+do {                                                                                           \
+  size_t _lsa_i, _lsa_j, _lsa_k, _lsa_lo, _lsa_mid, _lsa_hi, _lsa_m, _lsa_r;                   \
+  LDECLTYPE(list) _lsa_e;                                                                      \
+  LDECLTYPE(list) *_lsa_src = (a);                                                             \
+  LDECLTYPE(list) *_lsa_dst = (a) + (n);                                                       \
+  LDECLTYPE(list) *_lsa_sw;                                                                    \
+  size_t *_lsa_runs = (size_t*)((a) + 2*(n));                                                  \
+  for (_lsa_m = 0, _lsa_i = 0; _lsa_i < (n); _lsa_m++) {                                       \
+    _lsa_lo = _lsa_i++;                                                                        \
+    if ((_lsa_i < (n)) && (cmp(_lsa_src[_lsa_i-1], _lsa_src[_lsa_i]) > 0)) {                   \
+      for (_lsa_i++; (_lsa_i < (n)) &&                                                         \
+                     (cmp(_lsa_src[_lsa_i-1], _lsa_src[_lsa_i]) > 0); _lsa_i++) ;              \
+      for (_lsa_j = _lsa_lo, _lsa_k = _lsa_i-1; _lsa_j < _lsa_k; _lsa_j++, _lsa_k--) {         \
+        _lsa_e = _lsa_src[_lsa_j];                                                             \
+        _lsa_src[_lsa_j] = _lsa_src[_lsa_k];                                                   \
+        _lsa_src[_lsa_k] = _lsa_e;                                                             \
+      }                                                                                        \
+    } else if (_lsa_i < (n)) {                                                                 \
+      for (_lsa_i++; (_lsa_i < (n)) &&                                                         \
+             (cmp(_lsa_src[_lsa_i-1], _lsa_src[_lsa_i]) <= 0); _lsa_i++) ;                     \
+    }                                                                                          \
+    _lsa_hi = ((n) - _lsa_lo < UTLIST_SORT_RUN) ? (n) : _lsa_lo + UTLIST_SORT_RUN;             \
+    for (; _lsa_i < _lsa_hi; _lsa_i++) {                                                       \
+      _lsa_e = _lsa_src[_lsa_i];                                                               \
+      for (_lsa_k = _lsa_i;                                                                    \
+           (_lsa_k > _lsa_lo) && (cmp(_lsa_src[_lsa_k-1], _lsa_e) > 0); _lsa_k--) {            \
+        _lsa_src[_lsa_k] = _lsa_src[_lsa_k-1];                                                 \
+      }                                                                                        \
+      _lsa_src[_lsa_k] = _lsa_e;                                                               \
+    }                                                                                          \
+    _lsa_runs[_lsa_m] = _lsa_lo;                                                               \
+  }                                                                                            \
+  _lsa_runs[_lsa_m] = (n);                                                                     \
+  while (_lsa_m > 1) {                                                                         \
+    for (_lsa_r = 0; _lsa_r + 1 < _lsa_m; _lsa_r += 2) {                                       \
+      _lsa_lo = _lsa_runs[_lsa_r];                                                             \
+      _lsa_mid = _lsa_runs[_lsa_r+1];                                                          \
+      _lsa_hi = _lsa_runs[_lsa_r+2];                                                           \
+      _lsa_i = _lsa_lo; _lsa_j = _lsa_mid; _lsa_k = _lsa_lo;                                   \
+      if (cmp(_lsa_src[_lsa_mid-1], _lsa_src[_lsa_mid]) > 0) {                                 \
+        while ((_lsa_i < _lsa_mid) && (_lsa_j < _lsa_hi)) {                                    \
+          if (cmp(_lsa_src[_lsa_i], _lsa_src[_lsa_j]) <= 0) {                                  \
+            _lsa_dst[_lsa_k++] = _lsa_src[_lsa_i++];                                           \
+          } else {                                                                             \
+            _lsa_dst[_lsa_k++] = _lsa_src[_lsa_j++];                                           \
+          }                                                                                    \
+        }                                                                                      \
+      }                                                                                        \
+      while (_lsa_i < _lsa_mid) _lsa_dst[_lsa_k++] = _lsa_src[_lsa_i++];                       \
+      while (_lsa_j < _lsa_hi) _lsa_dst[_lsa_k++] = _lsa_src[_lsa_j++];                        \
+      _lsa_runs[_lsa_r/2] = _lsa_lo;                                                           \
+    }                                                                                          \
+    if (_lsa_r < _lsa_m) {                                                                     \
+      for (_lsa_i = _lsa_runs[_lsa_r]; _lsa_i < (n); _lsa_i++) {                               \
+        _lsa_dst[_lsa_i] = _lsa_src[_lsa_i];                                                   \
+      }                                                                                        \
+      _lsa_runs[_lsa_r/2] = _lsa_runs[_lsa_r];                                                 \
+    }                                                                                          \
+    _lsa_m = (_lsa_m + 1) / 2;                                                                 \
+    _lsa_runs[_lsa_m] = (n);                                                                   \
+    _lsa_sw = _lsa_src; _lsa_src = _lsa_dst; _lsa_dst = _lsa_sw;                               \
+  }                                                                                            \
+  (out) = _lsa_src;                                                                            \
+} while (0)
+
+#define LL_SORT(list, cmp)                                                                     \
+do {                                                                                           \
+  LDECLTYPE(list) *_ls_a;                                                                      \
+  LDECLTYPE(list) *_ls_out;                                                                    \
+  LDECLTYPE(list) _tmp;                                                                        \
+  size_t _ls_n, _ls_i;                                                                         \
+  _tmp = NULL; (void)_tmp; /* used by _SV only without decltype */                             \
+  _LS_GATHER(list,_ls_a,_ls_n);                                                                \
+  if (_ls_a) {                                                                                 \
+    _LS_ASORT(list,cmp,_ls_a,_ls_n,_ls_out);                                                   \
+    for (_ls_i = 0; _ls_i + 1 < _ls_n; _ls_i++) {                                              \
+      _SV(_ls_out[_ls_i],list); _NEXTASGN(_ls_out[_ls_i],list,_ls_out[_ls_i+1]); _RS(list);    \
+    }                                                                                          \
+    _SV(_ls_out[_ls_n-1],list); _NEXTASGN(_ls_out[_ls_n-1],list,NULL); _RS(list);              \
+    _CASTASGN(list,_ls_out[0]);                                                                \
+    utlist_free(_ls_a, _LS_BYTES(_ls_a,_ls_n));                                                \
+  } else {                                                                                     \
+    _LL_SORT_LIST(list,cmp);                                                                   \
+  }                                                                                            \
+} while (0)
+
+#define DL_SORT(list, cmp)                                                                     \
+do {                                                                                           \
+  LDECLTYPE(list) *_ls_a;                                                                      \
+  LDECLTYPE(list) *_ls_out;                                                                    \
+  LDECLTYPE(list) _tmp;                                                                        \
+  size_t _ls_n, _ls_i;                                                                         \
+  _tmp = NULL; (void)_tmp; /* used by _SV only without decltype */                             \
+  _LS_GATHER(list,_ls_a,_ls_n);                                                                \
+  if (_ls_a) {                                                                                 \
+    _LS_ASORT(list,cmp,_ls_a,_ls_n,_ls_out);                                                   \
+    for (_ls_i = 0; _ls_i + 1 < _ls_n; _ls_i++) {                                              \
+      _SV(_ls_out[_ls_i],list); _NEXTASGN(_ls_out[_ls_i],list,_ls_out[_ls_i+1]); _RS(list);    \
+      _SV(_ls_out[_ls_i+1],list); _PREVASGN(_ls_out[_ls_i+1],list,_ls_out[_ls_i]); _RS(list);  \
+    }                                                                                          \
+    _SV(_ls_out[_ls_n-1],list); _NEXTASGN(_ls_out[_ls_n-1],list,NULL); _RS(list);              \
+    _SV(_ls_out[0],list); _PREVASGN(_ls_out[0],list,_ls_out[_ls_n-1]); _RS(list);              \
+    _CASTASGN(list,_ls_out[0]);                                                                \
+    utlist_free(_ls_a, _LS_BYTES(_ls_a,_ls_n));                                                \
+  } else {                                                                                     \
+    _DL_SORT_LIST(list,cmp);                                                                   \
+  }                                                                                            \
+} while (0)
+
+#define CDL_SORT(list, cmp)                                                                    \
+do {                                                                                           \
+  LDECLTYPE(list) *_ls_a;                                                                      \
+  LDECLTYPE(list) *_ls_out;                                                                    \
+  LDECLTYPE(list) _tmp;                                                                        \
+  size_t _ls_n, _ls_i;                                                                         \
+  _tmp = NULL; (void)_tmp; /* used by _SV only without decltype */                             \
+  _LS_GATHER(list,_ls_a,_ls_n);                                                                \
+  if (_ls_a) {                                                                                 \
+    _LS_ASORT(list,cmp,_ls_a,_ls_n,_ls_out);                                                   \
+    for (_ls_i = 0; _ls_i + 1 < _ls_n; _ls_i++) {                                              \
+      _SV(_ls_out[_ls_i],list); _NEXTASGN(_ls_out[_ls_i],list,_ls_out[_ls_i+1]); _RS(list);    \
+      _SV(_ls_out[_ls_i+1],list); _PREVASGN(_ls_out[_ls_i+1],list,_ls_out[_ls_i]); _RS(list);  \
+    }                                                                                          \
+    _SV(_ls_out[_ls_n-1],list); _NEXTASGN(_ls_out[_ls_n-1],list,_ls_out[0]); _RS(list);        \
+    _SV(_ls_out[0],list); _PREVASGN(_ls_out[0],list,_ls_out[_ls_n-1]); _RS(list);              \
+    _CASTASGN(list,_ls_out[0]);                                                                \
+    utlist_free(_ls_a, _LS_BYTES(_ls_a,_ls_n));                                                \
+  } else {                                                                                     \
+    _CDL_SORT_LIST(list,cmp);                                                                  \
+  }                                                                                            \
+} while (0)
+
 /******************************************************************************
  * singly linked list macros (non-circular)                                   *
  *****************************************************************************/
@@ -20,6 +20,10 @@ int main(int argc,char *argv[]) {
     char linebuf[BUFLEN];
     FILE *file;
     int i=0,j,nloops=3,loopnum=0,miss;
+#ifdef HASH_BLOOM
+    int misses=0,passed=0;
+    UT_hash_value hashv;
+#endif
     struct timeval tv1,tv2;
     long elapsed_usec;
     if (argc > 1) nloops = atoi(argv[1]);
@@ -36,6 +40,24 @@ int main(int argc,char *argv[]) {
         HASH_ADD_STR(names,boy_name,name);
     }
 
+#ifdef HASH_BLOOM
+    /* the false positive rate: of the keys not in the hash, how many the
+     * filter lets through to the bucket walk */
+    if (fseek(file,0,SEEK_SET) == -1) {
+       fprintf(stderr,"fseek failed: %s\n", strerror(errno));
+    }
+    while (fgets(linebuf,BUFLEN,file) != NULL) {
+        linebuf[0]++; if (linebuf[1] != '\0') linebuf[1]++;
+        HASH_FIND_STR(names,linebuf,name);
+        if (name) continue;
+        misses++;
+        HASH_VALUE(hh,names,linebuf,strlen(linebuf),hashv);
+        if (HASH_BLOOM_TEST(names->hh.tbl,hashv)) passed++;
+    }
+    printf("filter passed %d of %d misses (%.2f%% false positives)\n", passed,
+       misses, misses ? passed*100.0/misses : 0.0);
+#endif
+
   again:
     if (fseek(file,0,SEEK_SET) == -1) {
        fprintf(stderr,"fseek failed: %s\n", strerror(errno));
@@ -1,17 +1,25 @@
 #!/bin/bash
 
-BITS="16"
+BITS="16 20"
 
 cc -I../src  -O3 -Wall   -m64    bloom_perf.c   -o bloom_perf.none
 for bits in $BITS
 do
 cc -I../src  -DHASH_BLOOM=$bits -O3 -Wall   -m64    bloom_perf.c   -o bloom_perf.$bits
+cc -I../src  -DHASH_BLOOM=$bits -DHASH_BLOOM_BLOCKED -O3 -Wall   -m64    bloom_perf.c   -o bloom_perf.${bits}b
 done
 
 for bits in none $BITS
 do
+for kind in "" b
+do
+if [ "$bits" = none ] && [ -n "$kind" ]; then continue; fi
 echo
+if [ -n "$kind" ]; then
+echo "using $bits-bit blocked filter:"
+else
 echo "using $bits-bit filter:"
-./bloom_perf.$bits 10
+fi
+./bloom_perf.$bits$kind 10
+done
 done
-
@@ -72,8 +72,13 @@ int getkeys=0;
 #define FNV 5
 #define OAT 6
 #define MUR 7
-#define NUM_HASH_FUNCS 8 /* includes id 0, the non-function */
-char *hash_fcns[] = {"???","JEN","BER","SFH","SAX","FNV","OAT","MUR"};
+#define WYH 8
+#define XXH 9
+#define SIP 10
+#define XX3 11
+#define NUM_HASH_FUNCS 12 /* includes id 0, the non-function */
+char *hash_fcns[] = {"???","JEN","BER","SFH","SAX","FNV","OAT","MUR","WYH","XXH","SIP",
+                     "XX3"};
 
 /* given a peer key/len/hashv, reverse engineer its hash function */
 int infer_hash_function(char *key, size_t keylen, uint32_t hashv) {
@@ -86,6 +91,10 @@ int infer_hash_function(char *key, size_t keylen, uint32_t hashv) {
   HASH_FNV(key,keylen,num_bkts,ohashv,obkt); if (ohashv == hashv) return FNV;
   HASH_OAT(key,keylen,num_bkts,ohashv,obkt); if (ohashv == hashv) return OAT;
   HASH_MUR(key,keylen,num_bkts,ohashv,obkt); if (ohashv == hashv) return MUR;
+  HASH_WYH(key,keylen,num_bkts,ohashv,obkt); if (ohashv == hashv) return WYH;
+  HASH_XXH(key,keylen,num_bkts,ohashv,obkt); if (ohashv == hashv) return XXH;
+  HASH_SIP(key,keylen,num_bkts,ohashv,obkt); if (ohashv == hashv) return SIP;
+  HASH_XX3(key,keylen,num_bkts,ohashv,obkt); if (ohashv == hashv) return XX3;
   return 0;
 }
 
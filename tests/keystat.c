@@ -175,6 +175,11 @@ int main(int argc, char *argv[]) {
       fprintf(stderr,"keystats memory: %u\n", 
         (unsigned)((sizeof(stat_key)+max_keylen)*key_count));
       hash_chain_len_histogram(keys->hh.tbl);
+      /* with -DHASH_HUGE_BUCKETS, compare find_usec with and without */
+      fprintf(stderr,"bucket array: %lu bytes, %s\n",
+        (unsigned long)(keys->hh.tbl->num_buckets*sizeof(UT_hash_bucket)),
+        HASH_BKT_HUGE(keys->hh.tbl->num_buckets) ? "mapped (huge pages)" :
+                                                   "allocated");
     }
 
     /* add all keys to a new hash, so we can measure add time w/o malloc */
@@ -0,0 +1,52 @@
+#include <stdlib.h>   /* malloc */
+#include <stdio.h>    /* printf */
+
+/* with seeded tables and per-table hash functions, HASH_VALUE hashes a key
+ * the way the given table does, so items added by hash value are found by
+ * HASH_FIND, in a table with its own seed and in one with its own function */
+#define HASH_SEEDED
+#define HASH_TABLE_FCN
+#include "uthash.h"
+
+#define NUM 1000
+
+typedef struct example_user_t {
+    int id;
+    UT_hash_handle hh;
+    UT_hash_handle ah;
+} example_user_t;
+
+int main(int argc,char *argv[]) {
+    int i, found=0, byvalue=0;
+    UT_hash_value hashv;
+    example_user_t *user, *tmp, *users=NULL, *alt=NULL, *one;
+
+    for(i=0; i<NUM; i++) {
+        if ( (user = (example_user_t*)malloc(sizeof(example_user_t))) == NULL) exit(-1);
+        user->id = i;
+        HASH_VALUE(hh, users, &user->id, sizeof(int), hashv);
+        HASH_ADD_BYHASHVALUE(hh, users, id, sizeof(int), hashv, user);
+        HASH_VALUE(ah, alt, &user->id, sizeof(int), hashv);
+        HASH_ADD_BYHASHVALUE(ah, alt, id, sizeof(int), hashv, user);
+        if (i == 0) HASH_SET_FCN(ah, alt, uthash_fcn_wyh);
+    }
+    printf("seeds differ: %s\n",
+           (users->hh.tbl->seed != alt->ah.tbl->seed) ? "yes" : "no");
+    for(i=0; i<NUM; i++) {
+        HASH_FIND_INT(users, &i, one);
+        if (one && one->id == i) found++;
+        HASH_FIND(ah, alt, &i, sizeof(int), one);
+        if (one && one->id == i) found++;
+        HASH_VALUE(ah, alt, &i, sizeof(int), hashv);
+        HASH_FIND_BYHASHVALUE(ah, alt, &i, sizeof(int), hashv, one);
+        if (one && one->id == i) byvalue++;
+    }
+    printf("found %d, by value %d\n", found, byvalue);
+
+    HASH_CLEAR(ah, alt);
+    HASH_ITER(hh, users, user, tmp) {
+        HASH_DEL(users, user);
+        free(user);
+    }
+    return 0;
+}
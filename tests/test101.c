@@ -0,0 +1,39 @@
+#include <stdlib.h>   /* malloc */
+#include <stdio.h>    /* printf */
+
+/* a seeded table hashing with SipHash still chooses its function, but only
+ * among keyed ones; sequential keys, which some unkeyed functions spread
+ * evenly, must not tempt it away from SipHash */
+#define HASH_SEEDED
+#define HASH_AUTO_FCN
+#define HASH_FUNCTION HASH_SIP
+#include "uthash.h"
+
+#define NUM 20000
+
+typedef struct example_user_t {
+    int id;
+    UT_hash_handle hh;
+} example_user_t;
+
+int main(int argc,char *argv[]) {
+    int i, found=0;
+    example_user_t *user, *tmp, *users=NULL;
+
+    for(i=0; i<NUM; i++) {
+        if ( (user = (example_user_t*)malloc(sizeof(example_user_t))) == NULL) exit(-1);
+        user->id = i;
+        HASH_ADD_INT(users, id, user);
+    }
+    for(i=0; i<NUM; i++) {
+        HASH_FIND_INT(users, &i, user);
+        if (user) found++;
+    }
+    printf("chosen: %s, keyed: %s, found %d\n",
+           users->hh.tbl->fcn_chosen ? "yes" : "no",
+           (!users->hh.tbl->fcn || users->hh.tbl->fcn == uthash_fcn_sip) ?
+             "yes" : "no", found);
+
+    HASH_ITER(hh, users, user, tmp) { HASH_DEL(users, user); free(user); }
+    return 0;
+}
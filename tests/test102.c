@@ -0,0 +1,74 @@
+#include <stdlib.h>   /* exit */
+#include <stdio.h>    /* printf, sprintf */
+#include <string.h>   /* strlen */
+#include <sys/mman.h> /* mmap */
+
+/* compact handles count from a region the program maps, so items spread
+ * gigabytes apart over it are in range whichever is added first; with the
+ * unit the size of an item, the table on the second handle counts from
+ * that handle's place in the first item */
+static char *region;
+#define HASH_COMPACT
+#define HASH_COMPACT_UNIT sizeof(struct item)
+#define uthash_compact_base region
+#include "uthash.h"
+
+#define NUM 1000
+
+struct item {
+    int id;
+    char name[12];
+    UT_hash_handle hh;
+    UT_hash_handle ah;
+};
+
+int main(int argc,char *argv[]) {
+    int i, found=0, named=0;
+    size_t bytes = (size_t)1 << ((sizeof(void*) == 8) ? 33 : 28), nslots;
+    struct item *item, *tmp, *ids=NULL, *names=NULL, *first, *last;
+
+    region = (char*)mmap(NULL, bytes, PROT_READ|PROT_WRITE,
+                         MAP_PRIVATE|MAP_ANONYMOUS|MAP_NORESERVE, -1, 0);
+    if (region == (char*)MAP_FAILED) exit(-1);
+    nslots = bytes / sizeof(struct item);
+
+    /* the farthest item first */
+    for(i=NUM-1; i>=0; i--) {
+        item = (struct item*)region + (nslots / NUM) * (size_t)i;
+        item->id = i;
+        sprintf(item->name, "item-%d", i);
+        HASH_ADD_INT(ids, id, item);
+        HASH_ADD_KEYPTR(ah, names, item->name, strlen(item->name), item);
+    }
+    for(i=0; i<NUM; i++) {
+        char name[12];
+        HASH_FIND_INT(ids, &i, item);
+        if (item && item->id == i) found++;
+        sprintf(name, "item-%d", i);
+        HASH_FIND(ah, names, name, strlen(name), item);
+        if (item && item->id == i) named++;
+    }
+    first = (struct item*)region;
+    last = (struct item*)region + (nslots / NUM) * (NUM-1);
+    printf("spread over %u GB: found %d by id, %d by name\n",
+           (unsigned)((size_t)((char*)last - (char*)first) >> 30), found, named);
+
+    /* delete the even ids from both, and walk what is left */
+    HASH_ITER(hh, ids, item, tmp) {
+        if ((item->id & 1) == 0) {
+            HASH_DEL(ids, item);
+            HASH_DELETE(ah, names, item);
+        }
+    }
+    found = 0;
+    for(item=names; item != NULL; item=(struct item*)HASH_NEXT(ah,item)) {
+        if (item->id & 1) found++;
+    }
+    printf("%u left by id, %u by name, %d odd\n", HASH_COUNT(ids),
+           HASH_CNT(ah, names), found);
+
+    HASH_CLEAR(hh, ids);
+    HASH_CLEAR(ah, names);
+    munmap(region, bytes);
+    return 0;
+}
@@ -17,14 +17,14 @@ int main(int argc, char *argvp[]) {
   item_t *item1, *item2, *tmp1, *tmp2;
 
   /* make initial element */
-  item_t *i = malloc(sizeof(*i));
+  item_t *i = (item_t*)malloc(sizeof(*i));
   strcpy(i->name, "bob");
   i->sub = NULL;
   i->val = 0;
   HASH_ADD_STR(items, name, i);
 
   /* add a sub hash table off this element */
-  item_t *s = malloc(sizeof(*s));
+  item_t *s = (item_t*)malloc(sizeof(*s));
   strcpy(s->name, "age");
   s->sub = NULL;
   s->val = 37;
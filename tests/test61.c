@@ -32,7 +32,7 @@ int main() {
   while ( (p=(char**)utarray_next(strs,p))) {
     s = *p;
     printf("finding %s\n",s);
-    p = utarray_find(strs,&s,strsort);
+    p = (char**)utarray_find(strs,&s,strsort);
     printf(" %s\n", p ? (*p) : "failed");
   }
 
@@ -32,7 +32,7 @@ char * /*value*/ find_in_cache(char *key)
 void add_to_cache(char *key, char *value)
 {
     struct CacheEntry *entry, *tmp_entry;
-    entry = malloc(sizeof(struct CacheEntry));
+    entry = (struct CacheEntry*)malloc(sizeof(struct CacheEntry));
     entry->key = strdup(key);
     entry->value = strdup(value);
     HASH_ADD_KEYPTR(hh, cache, entry->key, strlen(entry->key), entry);
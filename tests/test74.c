@@ -0,0 +1,58 @@
+#define HASH_FINGERPRINT
+#define HASH_FP_SLOTS 2   /* small, so both slot scans and chain walks occur */
+#include "uthash.h"
+#include <stdlib.h>   /* malloc */
+#include <stdio.h>    /* printf */
+
+typedef struct example_user_t {
+    int id;
+    int cookie;
+    UT_hash_handle hh;
+} example_user_t;
+
+int main(int argc,char *argv[]) {
+    int i, hits, misses;
+    example_user_t *user, *tmp, *users=NULL;
+
+    /* create elements */
+    for(i=0;i<1000;i++) {
+        if ( (user = (example_user_t*)malloc(sizeof(example_user_t))) == NULL) exit(-1);
+        user->id = i;
+        user->cookie = i*i;
+        HASH_ADD_INT(users,id,user);
+    }
+
+    /* look up every id that exists, and as many that don't */
+    hits = misses = 0;
+    for(i=0;i<2000;i++) {
+        HASH_FIND_INT(users,&i,tmp);
+        if (tmp) {
+            if (tmp->cookie != i*i) printf("wrong user for id %d\n", i);
+            hits++;
+        } else misses++;
+    }
+    printf("%d hits, %d misses\n", hits, misses);
+
+    /* delete the odd id's, so chains shrink back into their slots */
+    for(i=1;i<1000;i+=2) {
+        HASH_FIND_INT(users,&i,tmp);
+        if (tmp) {
+            HASH_DEL(users,tmp);
+            free(tmp);
+        } else printf("user id %d not found\n", i);
+    }
+
+    hits = misses = 0;
+    for(i=0;i<1000;i++) {
+        HASH_FIND_INT(users,&i,tmp);
+        if (tmp) hits++; else misses++;
+    }
+    printf("%d hits, %d misses\n", hits, misses);
+
+    HASH_ITER(hh, users, user, tmp) {
+        HASH_DEL(users,user);
+        free(user);
+    }
+    printf("%u users\n", HASH_COUNT(users));
+    return 0;
+}
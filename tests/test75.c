@@ -0,0 +1,63 @@
+#define HASH_INCREMENTAL
+#include "uthash.h"
+#include <stdlib.h>   /* malloc */
+#include <stdio.h>    /* printf */
+
+typedef struct example_user_t {
+    int id;
+    int cookie;
+    UT_hash_handle hh;
+    UT_hash_handle ah;
+} example_user_t;
+
+#define is_even(x) ((((example_user_t*)(x))->id % 2) == 0)
+
+int main(int argc,char *argv[]) {
+    int i, found, inflight=0, count;
+    example_user_t *user, *tmp, *found_user, *users=NULL, *evens=NULL;
+
+    /* add items, checking every key added so far whenever a migration is
+     * in flight; this covers finds in both old and new bucket arrays */
+    for(i=0;i<2000;i++) {
+        if ( (user = (example_user_t*)malloc(sizeof(example_user_t))) == NULL) exit(-1);
+        user->id = i;
+        user->cookie = i*i;
+        HASH_ADD_INT(users,id,user);
+        if (users->hh.tbl->old_buckets && (i % 32 == 0)) {
+            inflight++;
+            for(found=0; found <= i; found++) {
+                HASH_FIND_INT(users,&found,tmp);
+                if (!tmp || tmp->cookie != found*found) printf("lost id %d\n", found);
+            }
+        }
+    }
+    printf("checked %s\n", inflight ? "during migration" : "only after migration");
+
+    /* select into a second hash while its own expansions are in flight */
+    HASH_SELECT(ah,evens,hh,users,is_even);
+    printf("%u selected\n", HASH_CNT(ah,evens));
+
+    /* delete every third item, both hashes must stay consistent */
+    for(i=0;i<2000;i+=3) {
+        HASH_FIND_INT(users,&i,tmp);
+        if (!tmp) { printf("user id %d not found\n", i); continue; }
+        HASH_DEL(users,tmp);
+        if (is_even(tmp)) HASH_DELETE(ah,evens,tmp);
+    }
+
+    count = 0;
+    HASH_ITER(hh, users, user, tmp) {
+        HASH_FIND_INT(users,&user->id,found_user);
+        if (found_user != user) printf("iteration found id %d but lookup didn't\n", user->id);
+        count++;
+    }
+    printf("%d users, %u evens\n", count, HASH_CNT(ah,evens));
+
+    HASH_CLEAR(ah,evens);
+    HASH_ITER(hh, users, user, tmp) {
+        HASH_DEL(users,user);
+        free(user);
+    }
+    printf("%u users\n", HASH_COUNT(users));
+    return 0;
+}
@@ -0,0 +1,60 @@
+#include "uthash.h"
+#include <stdlib.h>   /* malloc */
+#include <stdio.h>    /* printf */
+
+typedef struct example_user_t {
+    int id;
+    int cookie;
+    UT_hash_handle hh;
+} example_user_t;
+
+int main(int argc,char *argv[]) {
+    int i, found;
+    unsigned grown;
+    example_user_t *user, *tmp, *users=NULL;
+
+    for(i=0;i<10000;i++) {
+        if ( (user = (example_user_t*)malloc(sizeof(example_user_t))) == NULL) exit(-1);
+        user->id = i;
+        user->cookie = i*i;
+        HASH_ADD_INT(users,id,user);
+    }
+    grown = users->hh.tbl->num_buckets;
+
+    /* delete all but 100 items; the bucket array doesn't contract by itself */
+    for(i=100;i<10000;i++) {
+        HASH_FIND_INT(users,&i,tmp);
+        if (tmp) {
+            HASH_DEL(users,tmp);
+            free(tmp);
+        } else printf("user id %d not found\n", i);
+    }
+    printf("%u users, buckets unchanged: %s\n", HASH_COUNT(users),
+        (users->hh.tbl->num_buckets == grown) ? "yes" : "no");
+
+    HASH_SHRINK(hh,users);
+    printf("%u users in %u buckets\n", HASH_COUNT(users), users->hh.tbl->num_buckets);
+
+    found = 0;
+    for(i=0;i<10000;i++) {
+        HASH_FIND_INT(users,&i,tmp);
+        if (tmp && tmp->cookie == i*i) found++;
+    }
+    printf("found %d\n", found);
+
+    /* the table grows again as usual */
+    for(i=100;i<10000;i++) {
+        if ( (user = (example_user_t*)malloc(sizeof(example_user_t))) == NULL) exit(-1);
+        user->id = i;
+        user->cookie = i*i;
+        HASH_ADD_INT(users,id,user);
+    }
+    printf("%u users, regrown: %s\n", HASH_COUNT(users),
+        (users->hh.tbl->num_buckets > 128) ? "yes" : "no");
+
+    HASH_ITER(hh, users, user, tmp) {
+        HASH_DEL(users,user);
+        free(user);
+    }
+    return 0;
+}
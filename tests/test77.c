@@ -0,0 +1,54 @@
+#define HASH_AUTO_SHRINK
+#include "uthash.h"
+#include <stdlib.h>   /* malloc */
+#include <stdio.h>    /* printf */
+
+typedef struct example_user_t {
+    int id;
+    int cookie;
+    UT_hash_handle hh;
+} example_user_t;
+
+static unsigned contractions = 0;
+
+int main(int argc,char *argv[]) {
+    int i, found;
+    unsigned nbkts;
+    example_user_t *user, *tmp, *users=NULL;
+
+    for(i=0;i<10000;i++) {
+        if ( (user = (example_user_t*)malloc(sizeof(example_user_t))) == NULL) exit(-1);
+        user->id = i;
+        user->cookie = i*i;
+        HASH_ADD_INT(users,id,user);
+    }
+
+    /* deletes halve the bucket array whenever the load drops below 25% */
+    nbkts = users->hh.tbl->num_buckets;
+    for(i=10000-1;i>=10;i--) {
+        HASH_FIND_INT(users,&i,tmp);
+        if (!tmp) { printf("user id %d not found\n", i); continue; }
+        HASH_DEL(users,tmp);
+        free(tmp);
+        if (users->hh.tbl->num_buckets != nbkts) {
+            if (users->hh.tbl->num_buckets * 2 != nbkts) printf("not halved\n");
+            nbkts = users->hh.tbl->num_buckets;
+            contractions++;
+        }
+    }
+    printf("%u users in %u buckets, contracted: %s\n", HASH_COUNT(users),
+        users->hh.tbl->num_buckets, contractions ? "yes" : "no");
+
+    found = 0;
+    for(i=0;i<10000;i++) {
+        HASH_FIND_INT(users,&i,tmp);
+        if (tmp && tmp->cookie == i*i) found++;
+    }
+    printf("found %d\n", found);
+
+    HASH_ITER(hh, users, user, tmp) {
+        HASH_DEL(users,user);
+        free(user);
+    }
+    return 0;
+}
@@ -0,0 +1,74 @@
+#include <stdlib.h>   /* malloc */
+#include <stdio.h>    /* printf */
+
+/* count bucket expansions, and size new tables from a variable */
+static unsigned expansions = 0;
+static unsigned hint = 0;
+#define uthash_expand_fyi(tbl) expansions++
+#define uthash_capacity_hint(head) hint
+#include "uthash.h"
+
+typedef struct example_user_t {
+    int id;
+    int cookie;
+    UT_hash_handle hh;
+} example_user_t;
+
+#define NUM_USERS 5000
+
+static void add_users(example_user_t **users, int from, int to) {
+    int i;
+    example_user_t *user;
+    for(i=from;i<to;i++) {
+        if ( (user = (example_user_t*)malloc(sizeof(example_user_t))) == NULL) exit(-1);
+        user->id = i;
+        user->cookie = i*i;
+        HASH_ADD_INT(*users,id,user);
+    }
+}
+
+static int find_users(example_user_t *users) {
+    int i, found = 0;
+    example_user_t *tmp;
+    for(i=0;i<NUM_USERS;i++) {
+        HASH_FIND_INT(users,&i,tmp);
+        if (tmp && tmp->cookie == i*i) found++;
+    }
+    return found;
+}
+
+static void delete_users(example_user_t **users) {
+    example_user_t *user, *tmp;
+    HASH_ITER(hh, *users, user, tmp) {
+        HASH_DEL(*users,user);
+        free(user);
+    }
+}
+
+int main(int argc,char *argv[]) {
+    example_user_t *users=NULL;
+
+    /* without a reservation the table doubles repeatedly */
+    add_users(&users, 0, NUM_USERS);
+    printf("unreserved: %d found, expanded: %s\n", find_users(users),
+        expansions ? "yes" : "no");
+    delete_users(&users);
+
+    /* reserve after the first add */
+    expansions = 0;
+    add_users(&users, 0, 1);
+    HASH_RESERVE(hh,users,NUM_USERS);
+    printf("reserved %u buckets\n", users->hh.tbl->num_buckets);
+    add_users(&users, 1, NUM_USERS);
+    printf("reserved: %d found, %u expansions\n", find_users(users), expansions);
+    delete_users(&users);
+
+    /* create the table at its final size with the capacity hint */
+    expansions = 0;
+    hint = NUM_USERS;
+    add_users(&users, 0, NUM_USERS);
+    printf("hinted: %u buckets, %d found, %u expansions\n",
+        users->hh.tbl->num_buckets, find_users(users), expansions);
+    delete_users(&users);
+    return 0;
+}
@@ -0,0 +1,68 @@
+#define HASH_64BIT
+#include "uthash.h"
+#include <stdlib.h>   /* malloc */
+#include <stdio.h>    /* printf, sprintf */
+
+typedef struct example_user_t {
+    char name[16];
+    int id;
+    UT_hash_handle hh;
+} example_user_t;
+
+/* how many distinct high halves the hash function gives n keys */
+#define HIGH_HALVES(fcn,n,distinct)                                            \
+do {                                                                           \
+    int _i, _j;                                                                \
+    char _key[32];                                                             \
+    UT_hash_value _hashv[n];                                                   \
+    UT_hash_size _bkt;                                                         \
+    distinct = 0;                                                              \
+    for(_i=0;_i<n;_i++) {                                                      \
+        sprintf(_key,"%d-key-number",_i);                                      \
+        fcn(_key,strlen(_key),32,_hashv[_i],_bkt);                             \
+        if (_bkt != (_hashv[_i] & 31)) printf("bad bucket for %s\n", _key);   \
+        for(_j=0;_j<_i;_j++) {                                                 \
+            if ((_hashv[_j] >> 32) == (_hashv[_i] >> 32)) break;               \
+        }                                                                      \
+        if (_j == _i) distinct++;                                              \
+    }                                                                          \
+} while(0)
+
+int main(int argc,char *argv[]) {
+    int i, found, distinct;
+    example_user_t *user, *tmp, *users=NULL;
+
+    printf("hashv bytes: %u, keylen bytes: %u, count bytes: %u\n",
+           (unsigned)sizeof(user->hh.hashv), (unsigned)sizeof(user->hh.keylen),
+           (unsigned)sizeof(UT_hash_size));
+
+    for(i=0;i<1000;i++) {
+        if ( (user = (example_user_t*)malloc(sizeof(example_user_t))) == NULL) exit(-1);
+        sprintf(user->name,"user%d",i);
+        user->id = i;
+        HASH_ADD_STR(users,name,user);
+    }
+
+    found = 0;
+    for(i=0;i<1000;i++) {
+        char name[16];
+        sprintf(name,"user%d",i);
+        HASH_FIND_STR(users,name,tmp);
+        if (tmp && tmp->id == i) found++;
+    }
+    printf("%d found, count %lu\n", found, (unsigned long)HASH_COUNT(users));
+
+    /* every built-in function fills the high half of the hashv */
+    HIGH_HALVES(HASH_BER,100,distinct); printf("BER: %d\n", distinct);
+    HIGH_HALVES(HASH_SAX,100,distinct); printf("SAX: %d\n", distinct);
+    HIGH_HALVES(HASH_FNV,100,distinct); printf("FNV: %d\n", distinct);
+    HIGH_HALVES(HASH_OAT,100,distinct); printf("OAT: %d\n", distinct);
+    HIGH_HALVES(HASH_JEN,100,distinct); printf("JEN: %d\n", distinct);
+    HIGH_HALVES(HASH_SFH,100,distinct); printf("SFH: %d\n", distinct);
+
+    HASH_ITER(hh,users,user,tmp) {
+        HASH_DEL(users,user);
+        free(user);
+    }
+    return 0;
+}
@@ -0,0 +1,78 @@
+/* the items come from one arena, whose start the links count from */
+static char *arena;
+#define HASH_COMPACT
+#define uthash_compact_base arena
+#include "uthash.h"
+#include <stdlib.h>   /* malloc */
+#include <stdio.h>    /* printf */
+
+typedef struct example_user_t {
+    int id;
+    int cookie;
+    UT_hash_handle hh;
+    UT_hash_handle ah;
+} example_user_t;
+
+static int rev(example_user_t *a, example_user_t *b) {
+    return b->id - a->id;
+}
+
+#define EVENS(u) ((((example_user_t*)u)->id % 2) == 0)
+
+int main(int argc,char *argv[]) {
+    int i, found;
+    example_user_t *user, *tmp, *found_user, *users=NULL, *ausers=NULL;
+    example_user_t *pool, *top;
+
+    printf("handle bytes: %u\n", (unsigned)sizeof(UT_hash_handle));
+
+    /* items from an array at the start of the arena, and handed out one by
+     * one from its end, in one table */
+    if ( (arena = (char*)malloc(1000*sizeof(example_user_t))) == NULL) exit(-1);
+    pool = (example_user_t*)arena;
+    top = pool + 1000;
+    for(i=0;i<1000;i++) {
+        if (i < 500) user = &pool[i];
+        else user = --top;
+        user->id = i;
+        user->cookie = i*i;
+        HASH_ADD_INT(users,id,user);
+    }
+
+    found = 0;
+    for(i=0;i<1000;i++) {
+        HASH_FIND_INT(users,&i,tmp);
+        if (tmp && tmp->cookie == i*i) found++;
+    }
+    printf("%d found\n", found);
+
+    /* delete every third item */
+    for(i=0;i<1000;i+=3) {
+        HASH_FIND_INT(users,&i,tmp);
+        HASH_DEL(users,tmp);
+    }
+    printf("%u left\n", HASH_COUNT(users));
+
+    /* sort, then walk to the end and look back */
+    HASH_SORT(users,rev);
+    printf("sorted: %d %d ...", users->id, ((example_user_t*)HASH_NEXT(hh,users))->id);
+    for(user=users; HASH_NEXT(hh,user); user=(example_user_t*)HASH_NEXT(hh,user)) ;
+    printf(" %d %d\n", ((example_user_t*)HASH_PREV(hh,user))->id, user->id);
+
+    /* select the even ids into a second table */
+    HASH_SELECT(ah,ausers,hh,users,EVENS);
+    found = 0;
+    HASH_ITER(ah,ausers,user,tmp) {
+        HASH_FIND(ah,ausers,&user->id,sizeof(int),found_user);
+        if (found_user == user) found++;
+    }
+    printf("%u selected, %d found\n", HASH_CNT(ah,ausers), found);
+    HASH_CLEAR(ah,ausers);
+
+    HASH_ITER(hh,users,user,tmp) {
+        HASH_DEL(users,user);
+    }
+    free(arena);
+    printf("%u left\n", HASH_COUNT(users));
+    return 0;
+}
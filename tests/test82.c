@@ -0,0 +1,94 @@
+#define HASH_SEEDED
+#include <stdint.h>
+#include <stdio.h>    /* printf */
+#include <stdlib.h>   /* malloc */
+
+/* a deterministic seed sequence, and a count of reseeds */
+static unsigned seeds_drawn = 0, reseeds_seen = 0;
+#define uthash_seed(tbl) ((uint64_t)++seeds_drawn)
+#define uthash_reseed_fyi(tbl) reseeds_seen++
+
+/* Jenkins, except that every key collides under the first seed drawn,
+ * as if an attacker had prepared keys against it */
+#define HASH_FUNCTION HASH_FLOOD
+#define HASH_FLOOD(key,keylen,num_bkts,hashv,bkt)                              \
+  HASH_FLOOD_SEED(key,keylen,num_bkts,hashv,bkt,0)
+#define HASH_FLOOD_SEED(key,keylen,num_bkts,hashv,bkt,seed)                    \
+do {                                                                           \
+  HASH_JEN_SEED(key,keylen,num_bkts,hashv,bkt,seed);                           \
+  if (seeds_drawn == 1) { hashv = 0; bkt = 0; }                                \
+} while(0)
+
+#include "uthash.h"
+
+typedef struct example_user_t {
+    int id;
+    UT_hash_handle hh;
+    UT_hash_handle ah;
+} example_user_t;
+
+#define EVENS(x) (((x)->id & 1) == 0)
+int evens(void *userv) {
+  example_user_t *user = (example_user_t*)userv;
+  return EVENS(user);
+}
+
+int main(int argc,char *argv[]) {
+    int i, found;
+    unsigned b, longest;
+    uint64_t sip;
+    unsigned char msg[16];
+    example_user_t *user, *tmp, *users=NULL, *others=NULL, *evens_tbl=NULL;
+    example_user_t *found_user;
+
+    /* SipHash-2-4 reference values, key 00..0f, messages 00..0e and empty */
+    for(i=0;i<16;i++) msg[i] = (unsigned char)i;
+    HASH_SIP64(msg,15,0x0706050403020100ULL,0x0f0e0d0c0b0a0908ULL,sip);
+    printf("sip 15: %s\n", (sip == 0xa129ca6149be45e5ULL) ? "ok" : "bad");
+    HASH_SIP64(msg,0,0x0706050403020100ULL,0x0f0e0d0c0b0a0908ULL,sip);
+    printf("sip 0: %s\n", (sip == 0x726fdb47dd0e0e31ULL) ? "ok" : "bad");
+
+    /* every key collides until the table reseeds; it should then expand */
+    for(i=0;i<2000;i++) {
+        if ( (user = (example_user_t*)malloc(sizeof(example_user_t))) == NULL) exit(-1);
+        user->id = i;
+        HASH_ADD_INT(users,id,user);
+    }
+    longest = 0;
+    HASH_EXPAND_COMPLETE(users->hh.tbl);
+    for(b=0; b < users->hh.tbl->num_buckets; b++) {
+        if (users->hh.tbl->buckets[b].count > longest) {
+            longest = users->hh.tbl->buckets[b].count;
+        }
+    }
+    printf("reseeds: %u (fyi %u), noexpand: %u, short chains: %s\n",
+           users->hh.tbl->reseeds, reseeds_seen, users->hh.tbl->noexpand,
+           (longest < 30) ? "yes" : "no");
+    for(i=0,found=0;i<2000;i++) {
+        HASH_FIND_INT(users,&i,found_user);
+        if (found_user) found++;
+    }
+    printf("found %d of 2000\n", found);
+
+    /* the same keys in another table hash under a different seed */
+    for(i=0;i<10;i++) {
+        if ( (user = (example_user_t*)malloc(sizeof(example_user_t))) == NULL) exit(-1);
+        user->id = i;
+        HASH_ADD_INT(others,id,user);
+    }
+    printf("seeds differ: %s\n",
+           (users->hh.tbl->seed != others->hh.tbl->seed) ? "yes" : "no");
+
+    /* selected items are rehashed under the destination table's seed */
+    HASH_SELECT(ah,evens_tbl,hh,users,evens);
+    for(i=0,found=0;i<2000;i++) {
+        HASH_FIND(ah,evens_tbl,&i,sizeof(int),found_user);
+        if (found_user) found++;
+    }
+    printf("selected %u, found %d\n", HASH_CNT(ah,evens_tbl), found);
+
+    HASH_CLEAR(ah,evens_tbl);
+    HASH_ITER(hh,others,user,tmp) { HASH_DEL(others,user); free(user); }
+    HASH_ITER(hh,users,user,tmp) { HASH_DEL(users,user); free(user); }
+    return 0;
+}
@@ -0,0 +1,89 @@
+#define HASH_AUTO_FCN
+#include <stdio.h>    /* printf, sprintf */
+#include <stdlib.h>   /* malloc */
+
+/* a poor default: the hash is the key length, so keys of equal length
+ * all collide */
+#define HASH_FUNCTION HASH_LEN
+#define HASH_LEN(key,keylen,num_bkts,hashv,bkt)                                \
+  HASH_LEN_SEED(key,keylen,num_bkts,hashv,bkt,0)
+#define HASH_LEN_SEED(key,keylen,num_bkts,hashv,bkt,seed)                      \
+do {                                                                           \
+  hashv = (UT_hash_value)(keylen);                                             \
+  bkt = hashv & (num_bkts-1);                                                  \
+} while(0)
+
+/* compare the candidates on ideal% alone, and count the choices made */
+static unsigned choices = 0;
+#define uthash_fcn_clock() 0
+#define uthash_fcn_fyi(tbl) choices++
+
+#include "uthash.h"
+
+typedef struct example_user_t {
+    char name[16];
+    int id;
+    UT_hash_handle hh;
+    UT_hash_handle ah;
+} example_user_t;
+
+#define EVENS(x) (((x)->id & 1) == 0)
+int evens(void *userv) {
+  example_user_t *user = (example_user_t*)userv;
+  return EVENS(user);
+}
+
+int main(int argc,char *argv[]) {
+    int i, found;
+    char name[16];
+    example_user_t *user, *tmp, *users=NULL, *others=NULL, *evens_tbl=NULL;
+    example_user_t *found_user;
+
+    /* the table replaces the default once it has sampled its keys */
+    for(i=0;i<1000;i++) {
+        if ( (user = (example_user_t*)malloc(sizeof(example_user_t))) == NULL) exit(-1);
+        sprintf(user->name,"user-%d",i);
+        user->id = i;
+        HASH_ADD_STR(users,name,user);
+    }
+    for(i=0,found=0;i<1000;i++) {
+        sprintf(name,"user-%d",i);
+        HASH_FIND_STR(users,name,found_user);
+        if (found_user) found++;
+    }
+    printf("users: chose %s, found %d, noexpand %u\n",
+           users->hh.tbl->fcn ? "another function" : "the default", found,
+           users->hh.tbl->noexpand);
+
+    /* an explicit choice, made after the first add and again midway */
+    for(i=0;i<1000;i++) {
+        if ( (user = (example_user_t*)malloc(sizeof(example_user_t))) == NULL) exit(-1);
+        sprintf(user->name,"other-%d",i);
+        user->id = i;
+        HASH_ADD_STR(others,name,user);
+        if (i == 0) HASH_SET_FCN(hh,others,uthash_fcn_sip);
+        if (i == 500) HASH_SET_FCN(hh,others,uthash_fcn_wyh);
+    }
+    for(i=0,found=0;i<1000;i++) {
+        sprintf(name,"other-%d",i);
+        HASH_FIND_STR(others,name,found_user);
+        if (found_user) found++;
+    }
+    printf("others: kept wyh %s, found %d\n",
+           (others->hh.tbl->fcn == uthash_fcn_wyh) ? "yes" : "no", found);
+
+    /* selected items are rehashed by the destination's function */
+    HASH_SELECT(ah,evens_tbl,hh,users,evens);
+    for(i=0,found=0;i<1000;i++) {
+        sprintf(name,"user-%d",i);
+        HASH_FIND(ah,evens_tbl,name,strlen(name),found_user);
+        if (found_user) found++;
+    }
+    printf("selected %u, found %d\n", (unsigned)HASH_CNT(ah,evens_tbl), found);
+    printf("choices made: %u\n", choices);
+
+    HASH_CLEAR(ah,evens_tbl);
+    HASH_ITER(hh,others,user,tmp) { HASH_DEL(others,user); free(user); }
+    HASH_ITER(hh,users,user,tmp) { HASH_DEL(users,user); free(user); }
+    return 0;
+}
@@ -0,0 +1,54 @@
+#include "uthash.h"
+#include <stdlib.h>   /* malloc */
+#include <stdio.h>    /* printf */
+
+typedef struct example_user_t {
+    int id;
+    int cookie;
+    UT_hash_handle hh;
+} example_user_t;
+
+#define NKEYS 300
+
+int main(int argc,char *argv[]) {
+    int i, ids[NKEYS], *keyptrs[NKEYS], found, agree;
+    unsigned keylens[NKEYS];
+    example_user_t *user, *tmp, *users=NULL, *outs[NKEYS], *one;
+
+    /* odd ids only, so even keys miss */
+    for(i=0;i<10000;i++) {
+        if ( (user = (example_user_t*)malloc(sizeof(example_user_t))) == NULL) exit(-1);
+        user->id = 2*i+1;
+        user->cookie = i*i;
+        HASH_ADD_INT(users,id,user);
+    }
+
+    /* a batch that is not a multiple of HASH_BATCH_GROUP */
+    for(i=0;i<NKEYS;i++) {
+        ids[i] = (i*37) % 20003;
+        keyptrs[i] = &ids[i];
+        keylens[i] = sizeof(int);
+    }
+    HASH_FIND_BATCH(hh,users,keyptrs,keylens,NKEYS,outs);
+    found = agree = 0;
+    for(i=0;i<NKEYS;i++) {
+        HASH_FIND_INT(users,&ids[i],one);
+        if (one == outs[i]) agree++;
+        if (outs[i]) {
+            found++;
+            if (outs[i]->id != ids[i]) printf("wrong item for %d\n", ids[i]);
+        }
+    }
+    printf("batch of %d: found %d, agree with HASH_FIND %d\n", NKEYS, found, agree);
+
+    /* short batches, and a batch on an empty hash */
+    HASH_FIND_BATCH(hh,users,keyptrs+1,keylens,1,outs);
+    printf("batch of 1: %s\n", (outs[0] && outs[0]->id == 37) ? "found 37" : "bad");
+    HASH_FIND_BATCH(hh,users,keyptrs,keylens,0,outs);
+    HASH_ITER(hh,users,user,tmp) { HASH_DEL(users,user); free(user); }
+    outs[0] = (example_user_t*)keyptrs;
+    HASH_FIND_BATCH(hh,users,keyptrs,keylens,NKEYS,outs);
+    for(i=0,found=0;i<NKEYS;i++) if (outs[i]) found++;
+    printf("empty hash: found %d\n", found);
+    return 0;
+}
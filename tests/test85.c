@@ -0,0 +1,56 @@
+#include "uthash.h"
+#include <stdlib.h>   /* malloc */
+#include <stdio.h>    /* printf */
+
+typedef struct example_user_t {
+    int id;
+    int cookie;
+    UT_hash_handle hh;
+} example_user_t;
+
+int main(int argc,char *argv[]) {
+    int i, found=0, agree=0;
+    UT_hash_value hashv;
+    example_user_t *user, *tmp, *users=NULL, *one, *two;
+
+    /* add by hash value; even ids only */
+    for(i=0;i<1000;i++) {
+        if ( (user = (example_user_t*)malloc(sizeof(example_user_t))) == NULL) exit(-1);
+        user->id = 2*i;
+        user->cookie = i*i;
+        HASH_VALUE(hh, users, &user->id, sizeof(int), hashv);
+        HASH_ADD_BYHASHVALUE(hh,users,id,sizeof(int),hashv,user);
+    }
+    printf("count: %u\n", HASH_COUNT(users));
+
+    /* the hash value matches the one the table computes itself */
+    for(i=0;i<2000;i++) {
+        HASH_VALUE(hh, users, &i, sizeof(int), hashv);
+        HASH_FIND_BYHASHVALUE(hh,users,&i,sizeof(int),hashv,one);
+        HASH_FIND_INT(users,&i,two);
+        if (one == two) agree++;
+        if (one) {
+            found++;
+            if (one->hh.hashv != hashv) printf("hashv differs for %d\n", i);
+        }
+    }
+    printf("found %d, agree %d\n", found, agree);
+
+    /* an item added by HASH_ADD is found by hash value too */
+    if ( (user = (example_user_t*)malloc(sizeof(example_user_t))) == NULL) exit(-1);
+    user->id = 1;
+    HASH_ADD_INT(users,id,user);
+    i = 1;
+    HASH_VALUE(hh, users, &i, sizeof(int), hashv);
+    HASH_FIND_BYHASHVALUE(hh,users,&i,sizeof(int),hashv,one);
+    printf("1 %s\n", (one == user) ? "found" : "missing");
+
+    HASH_ITER(hh,users,user,tmp) {
+        HASH_DEL(users,user);
+        free(user);
+    }
+    HASH_VALUE(hh, users, &i, sizeof(int), hashv);
+    HASH_FIND_BYHASHVALUE(hh,users,&i,sizeof(int),hashv,one);
+    printf("empty: %s\n", one ? "no" : "yes");
+    return 0;
+}
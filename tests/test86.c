@@ -0,0 +1,111 @@
+#include "uthash.h"
+#include "utlist.h"
+#include <stdlib.h>   /* malloc */
+#include <stdio.h>    /* printf */
+
+/* the array sorts of HASH_SORT and of the utlist sorts: order, stability,
+ * links, and one pass over input that is already in order */
+#define NUM 10000
+
+typedef struct item {
+    int id;
+    int grp;     /* sort key with many ties */
+    int seq;     /* order before sorting */
+    UT_hash_handle hh;
+    struct item *prev, *next;
+} item;
+
+static long ncmp;
+
+static int grpcmp(item *a, item *b) {
+    ncmp++;
+    return (a->grp > b->grp) - (a->grp < b->grp);
+}
+static int idcmp(item *a, item *b) {
+    ncmp++;
+    return (a->id > b->id) - (a->id < b->id);
+}
+static int revcmp(item *a, item *b) {
+    ncmp++;
+    return (a->id < b->id) - (a->id > b->id);
+}
+
+/* check the order of a sorted list of n items: 1 if grp order is stable */
+static int check(item *head, int n, int circular) {
+    item *e = head, *prev = NULL;
+    int i, ok = 1;
+    for (i = 0; i < n; i++, prev = e, e = e->next) {
+        if (prev && (e->prev != prev)) ok = 0;
+        if (prev && ((prev->grp > e->grp) ||
+                     ((prev->grp == e->grp) && (prev->seq > e->seq)))) ok = 0;
+    }
+    if (circular ? ((e != head) || (head->prev != prev)) : (e != NULL)) ok = 0;
+    return ok;
+}
+
+int main(int argc, char *argv[]) {
+    int i, n, ok;
+    item *e, *prev, *items = NULL, *list = NULL;
+
+    for (i = 0; i < NUM; i++) {
+        if ((e = (item*)malloc(sizeof(item))) == NULL) exit(-1);
+        e->id = i;
+        e->grp = (int)(((unsigned)i * 2654435761U) % 100);
+        e->seq = i;
+        HASH_ADD_INT(items, id, e);
+    }
+
+    HASH_SORT(items, grpcmp);
+    ok = 1; n = 0;
+    for (prev = NULL, e = items; e; prev = e, e = (item*)HASH_NEXT(hh,e), n++) {
+        if ((item*)HASH_PREV(hh,e) != prev) ok = 0;
+        if (prev && ((prev->grp > e->grp) ||
+                     ((prev->grp == e->grp) && (prev->seq > e->seq)))) ok = 0;
+    }
+    if (ELMT_FROM_HH(items->hh.tbl, items->hh.tbl->tail) != prev) ok = 0;
+    printf("HASH_SORT: %d items, %s\n", n, ok ? "ok" : "wrong");
+
+    HASH_SORT(items, idcmp);
+    ncmp = 0;
+    HASH_SORT(items, idcmp);
+    printf("HASH_SORT sorted: %ld comparisons\n", ncmp);
+    ncmp = 0;
+    HASH_SORT(items, revcmp);
+    printf("HASH_SORT reversed: %ld comparisons, first %d\n", ncmp, items->id);
+    i = 42;
+    HASH_FIND_INT(items, &i, e);
+    printf("found %d\n", e ? e->id : -1);
+
+    /* the same items on a list, in id order */
+    for (e = items; e; e = (item*)HASH_NEXT(hh,e)) DL_PREPEND(list, e);
+    for (e = list, i = 0; e; e = e->next) e->seq = i++;
+    DL_SORT(list, grpcmp);
+    printf("DL_SORT: %s\n", check(list, NUM, 0) ? "ok" : "wrong");
+    ncmp = 0;
+    DL_SORT(list, grpcmp);
+    printf("DL_SORT sorted: %ld comparisons, %s\n", ncmp,
+           check(list, NUM, 0) ? "ok" : "wrong");
+
+    LL_SORT(list, idcmp);
+    for (e = list, i = 0; e; e = e->next, i++) if (e->id != i) break;
+    printf("LL_SORT: %s\n", (i == NUM) ? "ok" : "wrong");
+
+    /* and on a circular list */
+    list = NULL;
+    for (e = items; e; e = (item*)HASH_NEXT(hh,e)) CDL_PREPEND(list, e);
+    for (e = list, i = 0; i < NUM; e = e->next) e->seq = i++;
+    CDL_SORT(list, grpcmp);
+    printf("CDL_SORT: %s\n", check(list, NUM, 1) ? "ok" : "wrong");
+    CDL_SORT(list, idcmp);
+    ncmp = 0;
+    CDL_SORT(list, revcmp);
+    printf("CDL_SORT: %ld comparisons to reverse a sorted list\n", ncmp);
+
+    HASH_CLEAR(hh, items);
+    for (e = list, i = 0; i < NUM; i++) {
+        prev = e;
+        e = e->next;
+        free(prev);
+    }
+    return 0;
+}
@@ -0,0 +1,93 @@
+#include "uthash.h"
+#include <stdlib.h>   /* malloc */
+#include <stdio.h>    /* printf */
+
+/* the radix sorts: HASH_SORT_BY_UINT and HASH_SORT_BY_INT on fields of
+ * several widths, and HASH_SORT_BY_HASHV; order, stability and links */
+#define NUM 5000
+
+typedef struct item {
+    int id;
+    unsigned u;
+    int s;
+    unsigned char c;
+    unsigned long long big;
+    int seq;
+    UT_hash_handle hh;
+} item;
+
+/* 1 if the table is in order of key(field), stable by seq, and well linked */
+#define CHECK(items, key, ok)                                                    \
+do {                                                                             \
+    item *_e, *_prev = NULL;                                                     \
+    int _n = 0;                                                                  \
+    (ok) = 1;                                                                    \
+    for (_e = items; _e; _prev = _e, _e = (item*)HASH_NEXT(hh,_e), _n++) {       \
+        if ((item*)HASH_PREV(hh,_e) != _prev) (ok) = 0;                          \
+        if (_prev && ((key(_prev) > key(_e)) ||                                  \
+            ((key(_prev) == key(_e)) && (_prev->seq > _e->seq)))) (ok) = 0;      \
+    }                                                                            \
+    if (_n != NUM) (ok) = 0;                                                     \
+    if (ELMT_FROM_HH((items)->hh.tbl, (items)->hh.tbl->tail) != _prev) (ok) = 0; \
+} while (0)
+#define KEY_U(e) ((e)->u)
+#define KEY_S(e) ((e)->s)
+#define KEY_C(e) ((e)->c)
+#define KEY_BIG(e) ((e)->big)
+#define KEY_HASHV(e) ((e)->hh.hashv)
+
+static void renumber(item *items) {
+    int i = 0;
+    item *e;
+    for (e = items; e; e = (item*)HASH_NEXT(hh,e)) e->seq = i++;
+}
+
+int main(int argc, char *argv[]) {
+    int i, ok;
+    unsigned r;
+    item *e, *items = NULL;
+
+    for (i = 0; i < NUM; i++) {
+        if ((e = (item*)malloc(sizeof(item))) == NULL) exit(-1);
+        r = (unsigned)i * 2654435761U;
+        e->id = i;
+        e->u = r % 1000;
+        e->s = (int)(r % 2001) - 1000;
+        e->c = (unsigned char)(r >> 24);
+        e->big = ((unsigned long long)(r % 7) << 40) | (r % 3);
+        HASH_ADD_INT(items, id, e);
+    }
+
+    renumber(items);
+    HASH_SORT_BY_UINT(hh, items, u);
+    CHECK(items, KEY_U, ok);
+    printf("by unsigned: %s\n", ok ? "ok" : "wrong");
+
+    renumber(items);
+    HASH_SORT_BY_INT(hh, items, s);
+    CHECK(items, KEY_S, ok);
+    printf("by int: %s, first %d\n", ok ? "ok" : "wrong", items->s);
+
+    renumber(items);
+    HASH_SORT_BY_UINT(hh, items, c);
+    CHECK(items, KEY_C, ok);
+    printf("by unsigned char: %s\n", ok ? "ok" : "wrong");
+
+    renumber(items);
+    HASH_SORT_BY_UINT(hh, items, big);
+    CHECK(items, KEY_BIG, ok);
+    printf("by unsigned long long: %s\n", ok ? "ok" : "wrong");
+
+    renumber(items);
+    HASH_SORT_BY_HASHV(hh, items);
+    CHECK(items, KEY_HASHV, ok);
+    printf("by hash value: %s\n", ok ? "ok" : "wrong");
+
+    HASH_SORT_BY_INT(hh, items, id);
+    i = 1234;
+    HASH_FIND_INT(items, &i, e);
+    printf("first %d, found %d\n", items->id, e ? e->id : -1);
+
+    HASH_CLEAR(hh, items);
+    return 0;
+}
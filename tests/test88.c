@@ -0,0 +1,85 @@
+#include <stdlib.h>   /* malloc */
+#include <stdio.h>    /* printf */
+#include <string.h>   /* strlen */
+
+/* HASH_ADD_BULK, HASH_ADD_BULK_ARRAY and HASH_ADD_KEYPTR_BULK: the items
+ * are found, in app order, and the bucket array is sized once */
+static int expansions = 0;
+#define uthash_expand_fyi(tbl) expansions++
+#include "uthash.h"
+
+#define NUM 10000
+
+typedef struct item {
+    int id;
+    char name[16];
+    const char *alias;
+    UT_hash_handle hh;
+    UT_hash_handle ah;
+} item;
+
+int main(int argc, char *argv[]) {
+    int i, found, inorder;
+    item *e, *prev, *items = NULL, *aliases = NULL, **ptrs, *arr;
+    const char **keys;
+    unsigned *lens;
+
+    /* pointers to items, into an empty table */
+    ptrs = (item**)malloc(NUM * sizeof(item*));
+    if (!ptrs) exit(-1);
+    for (i = 0; i < NUM; i++) {
+        if ((ptrs[i] = (item*)malloc(sizeof(item))) == NULL) exit(-1);
+        ptrs[i]->id = i;
+    }
+    HASH_ADD_BULK(hh, items, id, sizeof(int), ptrs, NUM);
+    printf("count: %u, buckets: %u, expansions: %d\n", HASH_COUNT(items),
+           (unsigned)items->hh.tbl->num_buckets, expansions);
+
+    /* a contiguous array of items, into a table that has them already */
+    arr = (item*)malloc(NUM * sizeof(item));
+    if (!arr) exit(-1);
+    for (i = 0; i < NUM; i++) arr[i].id = NUM + i;
+    HASH_ADD_BULK_ARRAY(hh, items, id, sizeof(int), arr, NUM);
+    printf("count: %u, buckets: %u, expansions: %d\n", HASH_COUNT(items),
+           (unsigned)items->hh.tbl->num_buckets, expansions);
+
+    found = 0;
+    for (i = 0; i < 2*NUM + 10; i++) {
+        HASH_FIND_INT(items, &i, e);
+        if (e && (e->id == i)) found++;
+    }
+    inorder = 1;
+    for (i = 0, prev = NULL, e = items; e; prev = e, e = (item*)HASH_NEXT(hh,e), i++) {
+        if ((e->id != i) || ((item*)HASH_PREV(hh,e) != prev)) inorder = 0;
+    }
+    if (ELMT_FROM_HH(items->hh.tbl, items->hh.tbl->tail) != prev) inorder = 0;
+    printf("found: %d, in order: %s\n", found, inorder ? "yes" : "no");
+
+    /* keys by pointer, through a second handle */
+    keys = (const char**)malloc(NUM * sizeof(char*));
+    lens = (unsigned*)malloc(NUM * sizeof(unsigned));
+    if (!keys || !lens) exit(-1);
+    for (i = 0; i < NUM; i++) {
+        sprintf(arr[i].name, "item-%d", i);
+        arr[i].alias = arr[i].name;
+        keys[i] = arr[i].alias;
+        lens[i] = (unsigned)strlen(arr[i].alias);
+        ptrs[i] = &arr[i];
+    }
+    HASH_ADD_KEYPTR_BULK(ah, aliases, keys, lens, ptrs, NUM);
+    found = 0;
+    for (i = 0; i < NUM; i++) {
+        HASH_FIND(ah, aliases, keys[i], lens[i], e);
+        if (e == &arr[i]) found++;
+    }
+    HASH_FIND(ah, aliases, "item-", 5, e);
+    printf("aliases: %u, found: %d, %s\n", HASH_CNT(ah, aliases), found,
+           e ? "wrong" : "no stray");
+
+    HASH_ADD_BULK(hh, items, id, sizeof(int), ptrs, 0);
+    printf("count after adding none: %u\n", HASH_COUNT(items));
+
+    HASH_CLEAR(ah, aliases);
+    HASH_CLEAR(hh, items);
+    return 0;
+}
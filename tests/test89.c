@@ -0,0 +1,62 @@
+#ifndef HASH_BLOOM
+#define HASH_BLOOM 18
+#endif
+#define HASH_BLOOM_BLOCKED
+#include "uthash.h"
+#include <stdlib.h>   /* malloc */
+#include <stdio.h>    /* printf */
+
+/* the blocked Bloom filter: no false negatives, and few false positives on
+ * hash values that no item has */
+#define NUM 10000
+#define PROBES 100000
+
+typedef struct example_user_t {
+    int id;
+    UT_hash_handle hh;
+} example_user_t;
+
+int main(int argc,char *argv[]) {
+    int i, found=0, passed=0, rejected=0;
+    uint64_t r = 88172645463325252ULL;
+    UT_hash_value hashv;
+    example_user_t *user, *tmp, *users=NULL;
+
+    for(i=0; i<NUM; i++) {
+        if ( (user = (example_user_t*)malloc(sizeof(example_user_t))) == NULL) exit(-1);
+        user->id = 2*i;
+        HASH_ADD_INT(users,id,user);
+    }
+    for(user=users; user; user=(example_user_t*)HASH_NEXT(hh,user)) {
+        if (HASH_BLOOM_TEST(users->hh.tbl, user->hh.hashv)) passed++;
+    }
+    printf("items passing the filter: %d of %d\n", passed, NUM);
+
+    /* random hash values stand in for keys that were never added */
+    for(i=0, passed=0; i<PROBES; i++) {
+        r ^= r << 13; r ^= r >> 7; r ^= r << 17;
+        hashv = (UT_hash_value)r;
+        if (HASH_BLOOM_TEST(users->hh.tbl, hashv)) passed++;
+    }
+    printf("false positives under 10%%: %s\n", (passed < PROBES/10) ? "yes" : "no");
+
+    for(i=0; i<2*NUM; i++) {
+        HASH_FIND_INT(users,&i,user);
+        if (user) found++;
+        else if (i % 2 == 0) printf("key %d not found\n", i);
+    }
+    printf("found: %d\n", found);
+
+    /* a filter rebuilt by an expansion holds the same items */
+    HASH_RESERVE(hh, users, 8*NUM);
+    for(user=users; user; user=(example_user_t*)HASH_NEXT(hh,user)) {
+        if (!HASH_BLOOM_TEST(users->hh.tbl, user->hh.hashv)) rejected++;
+    }
+    printf("rejected after reserve: %d\n", rejected);
+
+    HASH_ITER(hh, users, user, tmp) {
+        HASH_DEL(users,user);
+        free(user);
+    }
+    return 0;
+}
@@ -0,0 +1,77 @@
+#ifndef HASH_BLOOM
+#define HASH_BLOOM 8
+#endif
+#define HASH_BLOOM_GROW
+#define HASH_BLOOM_COUNTING
+#include "uthash.h"
+#include <stdlib.h>   /* malloc */
+#include <stdio.h>    /* printf */
+
+/* a counting filter sized by the table: it grows as the buckets do, its
+ * items pass it, and deletes take them back out of it */
+#define NUM 50000
+#define PROBES 100000
+
+typedef struct example_user_t {
+    int id;
+    UT_hash_handle hh;
+} example_user_t;
+
+/* the fraction, in tenths of a percent, of random hash values it passes */
+static int false_positives(UT_hash_table *tbl) {
+    uint64_t r = 88172645463325252ULL;
+    int i, passed = 0;
+    for(i=0; i<PROBES; i++) {
+        r ^= r << 13; r ^= r >> 7; r ^= r << 17;
+        if (HASH_BLOOM_TEST(tbl, (UT_hash_value)r)) passed++;
+    }
+    return passed / (PROBES/1000);
+}
+
+static int rejected(example_user_t *users) {
+    example_user_t *user;
+    int n = 0;
+    for(user=users; user; user=(example_user_t*)HASH_NEXT(hh,user)) {
+        if (!HASH_BLOOM_TEST(users->hh.tbl, user->hh.hashv)) n++;
+    }
+    return n;
+}
+
+int main(int argc,char *argv[]) {
+    int i, fp_full, fp_few;
+    example_user_t *user, *tmp, *users=NULL;
+
+    for(i=0; i<NUM; i++) {
+        if ( (user = (example_user_t*)malloc(sizeof(example_user_t))) == NULL) exit(-1);
+        user->id = i;
+        HASH_ADD_INT(users,id,user);
+    }
+    printf("filter counters per bucket: %d\n",
+           1 << (users->hh.tbl->bloom_nbits - users->hh.tbl->log2_num_buckets));
+    printf("rejected: %d\n", rejected(users));
+    fp_full = false_positives(users->hh.tbl);
+    printf("false positives under 10%%: %s\n", (fp_full < 100) ? "yes" : "no");
+
+    /* delete nine items in ten: the filter empties with the table */
+    HASH_ITER(hh, users, user, tmp) {
+        if (user->id % 10) {
+            HASH_DEL(users,user);
+            free(user);
+        }
+    }
+    fp_few = false_positives(users->hh.tbl);
+    printf("count: %u, rejected: %d\n", HASH_COUNT(users), rejected(users));
+    printf("false positives fell: %s\n", (fp_few <= fp_full/2) ? "yes" : "no");
+
+    /* a shrink rebuilds it for the smaller bucket array */
+    HASH_SHRINK(hh, users);
+    printf("after shrink, counters per bucket: %d, rejected: %d\n",
+           1 << (users->hh.tbl->bloom_nbits - users->hh.tbl->log2_num_buckets),
+           rejected(users));
+
+    HASH_ITER(hh, users, user, tmp) {
+        HASH_DEL(users,user);
+        free(user);
+    }
+    return 0;
+}
@@ -0,0 +1,123 @@
+#include <stdlib.h>   /* malloc */
+#include <stdio.h>    /* printf */
+#include <stddef.h>   /* size_t */
+
+/* tables with allocators of their own (-DHASH_TABLE_ALLOC): one in an arena
+ * that is dropped whole, one in a pool that must balance, one using the
+ * global uthash_malloc; none of them touches another's memory */
+static long global_allocs = 0;
+#define uthash_malloc(sz) (global_allocs++, malloc(sz))
+#define uthash_free(ptr,sz) do { global_allocs--; free(ptr); } while (0)
+
+#define HASH_TABLE_ALLOC
+struct UT_hash_alloc;
+static struct UT_hash_alloc *current_alloc = NULL;
+#define uthash_table_alloc(head) current_alloc
+#include "uthash.h"
+
+#define NUM 10000
+
+typedef struct example_user_t {
+    int id;
+    UT_hash_handle hh;
+} example_user_t;
+
+/* a bump arena: frees are no-ops, and the arena goes in one piece */
+typedef struct arena_t {
+    char *base;
+    size_t used, size;
+    long frees;
+} arena_t;
+
+static void *arena_alloc(void *ctx, size_t sz) {
+    arena_t *a = (arena_t*)ctx;
+    void *p;
+    sz = (sz + 15) & ~(size_t)15;
+    if (a->used + sz > a->size) return NULL;
+    p = a->base + a->used;
+    a->used += sz;
+    return p;
+}
+static void arena_free(void *ctx, void *ptr, size_t sz) {
+    ((arena_t*)ctx)->frees++;
+    (void)ptr; (void)sz;
+}
+
+/* a pool that counts the bytes it has out */
+static void *pool_alloc(void *ctx, size_t sz) {
+    *(size_t*)ctx += sz;
+    return malloc(sz);
+}
+static void pool_free(void *ctx, void *ptr, size_t sz) {
+    *(size_t*)ctx -= sz;
+    free(ptr);
+}
+
+static example_user_t *fill(example_user_t *users, example_user_t *items) {
+    int i;
+    for(i=0; i<NUM; i++) {
+        items[i].id = i;
+        HASH_ADD_INT(users,id,&items[i]);
+    }
+    return users;
+}
+
+int main(int argc,char *argv[]) {
+    arena_t arena;
+    size_t pool_out = 0;
+    UT_hash_alloc in_arena, in_pool;
+    example_user_t *a=NULL, *b=NULL, *c=NULL, *items, *user;
+    long before;
+    int i, found=0;
+
+    arena.size = 4*1024*1024;
+    arena.used = 0;
+    arena.frees = 0;
+    if ( (arena.base = (char*)malloc(arena.size)) == NULL) exit(-1);
+    in_arena.alloc_fcn = arena_alloc;
+    in_arena.free_fcn = arena_free;
+    in_arena.realloc_fcn = NULL;
+    in_arena.ctx = &arena;
+    in_pool.alloc_fcn = pool_alloc;
+    in_pool.free_fcn = pool_free;
+    in_pool.realloc_fcn = NULL;
+    in_pool.ctx = &pool_out;
+
+    /* the items of the arena table come from the arena too */
+    items = (example_user_t*)arena_alloc(&arena, NUM*sizeof(example_user_t));
+    before = global_allocs;
+    current_alloc = &in_arena;
+    a = fill(a, items);
+    current_alloc = &in_pool;
+    if ( (items = (example_user_t*)malloc(NUM*sizeof(example_user_t))) == NULL) exit(-1);
+    b = fill(b, items);
+    printf("global allocations for the arena and pool tables: %ld\n",
+           global_allocs - before);
+    printf("arena used: %s, pool out: %s\n", arena.used ? "yes" : "no",
+           pool_out ? "yes" : "no");
+
+    current_alloc = NULL;
+    c = fill(c, (example_user_t*)malloc(NUM*sizeof(example_user_t)));
+    printf("global allocations for the third table: %s\n",
+           (global_allocs > before) ? "yes" : "no");
+
+    for(i=0; i<NUM; i++) {
+        HASH_FIND_INT(a,&i,user); if (user) found++;
+        HASH_FIND_INT(b,&i,user); if (user) found++;
+        HASH_FIND_INT(c,&i,user); if (user) found++;
+    }
+    printf("found: %d\n", found);
+
+    /* the pool table hands everything back; the arena table just goes */
+    items = b;
+    HASH_CLEAR(hh,b);
+    free(items);
+    printf("pool out after clear: %lu\n", (unsigned long)pool_out);
+    free(arena.base);
+    printf("arena took back old buckets: %s\n", arena.frees ? "yes" : "no");
+    items = c;
+    HASH_CLEAR(hh,c);
+    free(items);
+    printf("global allocations left: %ld\n", global_allocs - before);
+    return 0;
+}
@@ -0,0 +1,76 @@
+#include <stdlib.h>   /* malloc */
+#include <stdio.h>    /* printf */
+
+/* HASH_DESTROY with a free callback, and items from a slab that goes with
+ * its table in HASH_DESTROY_SLAB; count the memory that comes and goes */
+static long blocks = 0;
+#define uthash_malloc(sz) (blocks++, malloc(sz))
+#define uthash_free(ptr,sz) do { blocks--; free(ptr); } while (0)
+#include "uthash.h"
+
+#define NUM 20000
+
+typedef struct example_user_t {
+    int id;
+    char name[12];
+    UT_hash_handle hh;
+} example_user_t;
+
+static long freed = 0;
+static void free_user(example_user_t *user) {
+    freed++;
+    free(user);
+}
+
+int main(int argc,char *argv[]) {
+    UT_hash_slab slab;
+    example_user_t *user, *tmp, *last=NULL, *users=NULL;
+    int i, found=0, bad=0;
+
+    /* a table of malloc'd items, torn down with a callback */
+    for(i=0; i<NUM; i++) {
+        if ( (user = (example_user_t*)malloc(sizeof(example_user_t))) == NULL) exit(-1);
+        user->id = i;
+        HASH_ADD_INT(users,id,user);
+    }
+    HASH_DESTROY(hh, users, free_user);
+    printf("freed: %ld, head: %s, blocks left: %ld\n", freed,
+           users ? "set" : "NULL", blocks);
+
+    /* the same from a slab */
+    HASH_SLAB_INIT(&slab, example_user_t);
+    for(i=0; i<NUM; i++) {
+        HASH_SLAB_ALLOC(&slab, user);
+        user->id = i;
+        sprintf(user->name, "user %d", i);
+        HASH_ADD_INT(users,id,user);
+    }
+    /* items given back to the slab are handed out again */
+    HASH_ITER(hh, users, user, tmp) {
+        if (user->id % 2) {
+            HASH_DEL(users, user);
+            HASH_SLAB_FREE(&slab, user);
+            last = user;
+        }
+    }
+    HASH_SLAB_ALLOC(&slab, user);
+    printf("reused: %s\n", (user == last) ? "yes" : "no");
+    user->id = NUM;
+    HASH_ADD_INT(users,id,user);
+    for(i=0; i<=NUM; i++) {
+        HASH_FIND_INT(users,&i,user);
+        if (!user) continue;
+        found++;
+        if ((i < NUM) && (atoi(user->name + 5) != i)) bad++;
+    }
+    printf("found: %d, bad: %d, count: %u\n", found, bad, HASH_COUNT(users));
+
+    HASH_DESTROY_SLAB(hh, users, &slab);
+    printf("head: %s, blocks left: %ld\n", users ? "set" : "NULL", blocks);
+
+    /* an empty table is fine too */
+    HASH_DESTROY(hh, users, free_user);
+    HASH_SLAB_RELEASE(&slab);
+    printf("blocks left: %ld\n", blocks);
+    return 0;
+}
@@ -0,0 +1,60 @@
+#include <stdlib.h>   /* malloc */
+#include <stdio.h>    /* printf */
+
+/* bucket arrays past HASH_HUGE_MIN are mapped, aligned to a huge page, and
+ * come zeroed; smaller ones are malloc'd as usual */
+#define HASH_HUGE_BUCKETS
+#ifndef HASH_HUGE_MIN
+#define HASH_HUGE_MIN 4096
+#endif
+#include "uthash.h"
+
+#define NUM 5000
+
+typedef struct example_user_t {
+    int id;
+    UT_hash_handle hh;
+} example_user_t;
+
+static const char *where(UT_hash_table *tbl) {
+    UT_hash_bucket *start = tbl->buckets;
+#ifdef HASH_RCU
+    start--;        /* the array is mapped from its size bucket on */
+#endif
+    if (!HASH_BKT_HUGE(tbl->num_buckets)) return "malloc";
+    return ((size_t)start % HASH_HUGE_PAGE) ? "unaligned mmap" : "mmap";
+}
+
+int main(int argc,char *argv[]) {
+    int i, found=0;
+    example_user_t *user, *tmp, *users=NULL;
+
+    for(i=0; i<NUM; i++) {
+        if ( (user = (example_user_t*)malloc(sizeof(example_user_t))) == NULL) exit(-1);
+        user->id = i;
+        HASH_ADD_INT(users,id,user);
+        if (i == 10) printf("small buckets: %s\n", where(users->hh.tbl));
+    }
+    printf("large buckets: %s\n", where(users->hh.tbl));
+    for(i=0; i<NUM; i++) {
+        HASH_FIND_INT(users,&i,user);
+        if (user) found++;
+    }
+    printf("found: %d\n", found);
+
+    /* shrink back under the threshold, then to a mapped size again */
+    HASH_ITER(hh, users, user, tmp) {
+        if (user->id >= 10) {
+            HASH_DEL(users,user);
+            free(user);
+        }
+    }
+    HASH_SHRINK(hh, users);
+    printf("after shrink: %s\n", where(users->hh.tbl));
+    HASH_RESERVE(hh, users, NUM);
+    printf("after reserve: %s, count: %u\n", where(users->hh.tbl),
+           HASH_COUNT(users));
+    HASH_DESTROY(hh, users, free);
+    printf("head: %s\n", users ? "set" : "NULL");
+    return 0;
+}
@@ -0,0 +1,57 @@
+#include <stdlib.h>   /* malloc */
+#include <stdio.h>    /* printf */
+
+/* with HASH_EXPAND_INPLACE every doubling reallocs the one bucket array
+ * and splits each chain into buckets i and i+N */
+#define HASH_EXPAND_INPLACE
+static int mallocs, reallocs, expands;
+#define uthash_malloc(sz) (mallocs++, malloc(sz))
+#define uthash_realloc(ptr,old_sz,sz) (reallocs++, realloc(ptr,sz))
+#define uthash_expand_fyi(tbl) (expands++)
+#include "uthash.h"
+
+#define NUM 10000
+
+typedef struct example_user_t {
+    int id;
+    UT_hash_handle hh;
+} example_user_t;
+
+int main(int argc,char *argv[]) {
+    int i, found=0, misplaced=0;
+    unsigned b, n, len, total=0;
+    example_user_t *user, *users=NULL;
+    UT_hash_table *tbl;
+    UT_hash_bucket *bkt;
+    struct UT_hash_handle *thh;
+
+    for(i=0; i<NUM; i++) {
+        if ( (user = (example_user_t*)malloc(sizeof(example_user_t))) == NULL) exit(-1);
+        user->id = i;
+        HASH_ADD_INT(users,id,user);
+    }
+    for(i=0; i<NUM; i++) {
+        HASH_FIND_INT(users,&i,user);
+        if (user) found++;
+    }
+    printf("found: %d\n", found);
+
+    /* every chain is as long as its count and holds only its own items */
+    tbl = users->hh.tbl;
+    for(b=0; b < tbl->num_buckets; b++) {
+        bkt = &tbl->buckets[b];
+        for(len=0, thh = bkt->hh_head; thh; thh = HASH_HH_CHAIN_NEXT(tbl,thh)) {
+            HASH_TO_BKT(thh->hashv, tbl->num_buckets, n);
+            if (n != b) misplaced++;
+            len++;
+        }
+        if (len != bkt->count) misplaced++;
+        total += len;
+    }
+    printf("buckets: %u, chained: %u, misplaced: %d\n", tbl->num_buckets,
+           total, misplaced);
+    printf("expansions reallocated: %s, bucket arrays allocated: %d\n",
+           (reallocs == expands) ? "all" : "not all", mallocs - 1);
+    HASH_DESTROY(hh, users, free);
+    return 0;
+}
@@ -0,0 +1,101 @@
+#include <stdlib.h>   /* malloc */
+#include <stdio.h>    /* printf, remove */
+#include <string.h>   /* strcpy */
+
+/* save two tables as snapshots, one keyed inside its items and one by
+ * pointers to keys kept elsewhere, then map them and search them in place */
+#define HASH_SNAPSHOT
+#include "uthash.h"
+
+#define NUM 1000
+
+typedef struct example_user_t {
+    int id;
+    char name[16];
+    UT_hash_handle hh;
+} example_user_t;
+
+typedef struct example_name_t {
+    const char *name;
+    int id;
+    UT_hash_handle hh;
+} example_name_t;
+
+static char names[NUM][16];
+
+int main(int argc,char *argv[]) {
+    int i, rc, found=0, right=0, zeroed=0;
+    example_user_t *user, *users=NULL;
+    example_name_t *nm, *byname=NULL;
+    const example_user_t *muser;
+    const example_name_t *mname;
+    UT_hash_map map;
+
+    for(i=0; i<NUM; i++) {
+        if ( (user = (example_user_t*)malloc(sizeof(example_user_t))) == NULL) exit(-1);
+        user->id = i;
+        sprintf(user->name, "user%d", i);
+        HASH_ADD_INT(users,id,user);
+        if ( (nm = (example_name_t*)malloc(sizeof(example_name_t))) == NULL) exit(-1);
+        sprintf(names[i], "name%d", i);
+        nm->name = names[i];
+        nm->id = i;
+        HASH_ADD_KEYPTR(hh,byname,nm->name,strlen(nm->name),nm);
+    }
+
+    HASH_SAVE(hh, users, "test95.snap", rc);
+    printf("saved users: %d\n", rc);
+    HASH_DESTROY(hh, users, free);
+    memset(&map, 0, sizeof(map));
+    HASH_MAP(&map, "test95.snap", rc);
+    printf("mapped users: %d, count: %u\n", rc, HASH_MAP_COUNT(&map));
+    for(i=0; i<NUM; i++) {
+        HASH_MAP_FIND_INT(&map, &i, muser);
+        if (!muser) continue;
+        found++;
+        if (muser->id == i && atoi(muser->name + 4) == i) right++;
+        if (muser->hh.tbl == NULL && muser->hh.next == NULL) zeroed++;
+    }
+    printf("found: %d, right: %d, zeroed handles: %d\n", found, right, zeroed);
+    i = NUM;
+    HASH_MAP_FIND_INT(&map, &i, muser);
+    printf("id %d: %s\n", i, muser ? "found" : "not found");
+
+    /* saving over the file replaces it, leaving the old one mapped intact */
+    HASH_SAVE(hh, byname, "test95.snap", rc);
+    printf("saved names: %d\n", rc);
+    for(found=0, i=0; i<NUM; i++) {
+        HASH_MAP_FIND_INT(&map, &i, muser);
+        if (muser && muser->id == i) found++;
+    }
+    printf("still mapped users: %d\n", found);
+    HASH_UNMAP(&map);
+    HASH_DESTROY(hh, byname, free);
+    memset(&map, 0, sizeof(map));
+    HASH_MAP(&map, "test95.snap", rc);
+    printf("mapped names: %d, count: %u\n", rc, HASH_MAP_COUNT(&map));
+    for(found=0, right=0, i=0; i<NUM; i++) {
+        HASH_MAP_FIND_STR(&map, names[i], mname);
+        if (!mname) continue;
+        found++;
+        if (mname->id == i) right++;
+    }
+    printf("found: %d, right: %d\n", found, right);
+    HASH_MAP_FIND_STR(&map, "name", mname);
+    printf("name: %s\n", mname ? "found" : "not found");
+    HASH_UNMAP(&map);
+
+    /* an empty table makes an empty snapshot */
+    HASH_SAVE(hh, byname, "test95.snap", rc);
+    HASH_MAP(&map, "test95.snap", rc);
+    printf("empty: %d, count: %u\n", rc, HASH_MAP_COUNT(&map));
+    HASH_MAP_FIND_STR(&map, "name1", mname);
+    printf("name1: %s\n", mname ? "found" : "not found");
+    HASH_UNMAP(&map);
+    remove("test95.snap");
+    HASH_MAP(&map, "test95.snap", rc);
+    printf("missing file: %d\n", rc);
+    HASH_SAVE(hh, byname, "no such dir/test95.snap", rc);
+    printf("unwritable: %d\n", rc);
+    return 0;
+}
@@ -0,0 +1,122 @@
+#include <stdlib.h>   /* exit */
+#include <stdio.h>    /* printf, remove */
+#include <string.h>   /* memcpy */
+#include <fcntl.h>    /* open */
+#include <unistd.h>   /* ftruncate, close */
+#include <sys/mman.h> /* mmap */
+
+/* a relocatable table is built in a shared file mapping, then used, and
+ * changed, through a second mapping of the same file at another address,
+ * as another process would see it */
+static char *base;
+static size_t used;
+#define REGION (1024*1024)
+static void *region_alloc(void *old, size_t old_sz, size_t sz) {
+    void *p;
+    sz = (sz + 15) & ~(size_t)15;
+    if (used + sz > REGION) return NULL;
+    p = base + used;
+    used += sz;
+    if (old != NULL) memcpy(p, old, old_sz);
+    return p;
+}
+#define HASH_RELOCATABLE
+#define uthash_reloc_base base
+#define uthash_malloc(sz) region_alloc(NULL,0,sz)
+#define uthash_realloc(ptr,old_sz,sz) region_alloc(ptr,old_sz,sz)
+#define uthash_free(ptr,sz) ((void)(ptr))
+#include "uthash.h"
+
+typedef struct region_hdr {
+    size_t used;
+    ptrdiff_t users;    /* the head, as an offset */
+    char pad[48];       /* so that no item starts at offset 0 */
+} region_hdr;
+
+typedef struct example_user_t {
+    int id;
+    int cookie;
+    UT_hash_handle hh;
+} example_user_t;
+
+static int count_ids(example_user_t *users, int *sum) {
+    example_user_t *user, *tmp;
+    int n = 0;
+    *sum = 0;
+    HASH_ITER(hh, users, user, tmp) {
+        n++;
+        *sum += user->id;
+    }
+    return n;
+}
+
+int main(int argc,char *argv[]) {
+    int i, fd, found=0, inside=0, n, sum;
+    char *view1, *view2;
+    region_hdr *hdr;
+    example_user_t *user, *users=NULL;
+
+    fd = open("test96.shm", O_RDWR|O_CREAT|O_TRUNC, 0600);
+    if (fd < 0 || ftruncate(fd, REGION) != 0) exit(-1);
+    view1 = (char*)mmap(NULL, REGION, PROT_READ|PROT_WRITE, MAP_SHARED, fd, 0);
+    view2 = (char*)mmap(NULL, REGION, PROT_READ|PROT_WRITE, MAP_SHARED, fd, 0);
+    if (view1 == (char*)MAP_FAILED || view2 == (char*)MAP_FAILED) exit(-1);
+    printf("views differ: %s\n", (view1 != view2) ? "yes" : "no");
+
+    /* build the table through the first view */
+    base = view1;
+    used = sizeof(region_hdr);
+    for(i=0; i<1000; i++) {
+        if ( (user = (example_user_t*)region_alloc(NULL,0,sizeof(example_user_t))) == NULL) exit(-1);
+        user->id = i;
+        user->cookie = i*i;
+        HASH_ADD_INT(users,id,user);
+    }
+    for(i=0; i<1000; i+=10) {
+        HASH_FIND_INT(users,&i,user);
+        if (user) HASH_DEL(users,user);
+    }
+    hdr = (region_hdr*)base;
+    hdr->users = HASH_REL_OFF(users);
+    hdr->used = used;
+
+    /* look up and add through the second view */
+    base = view2;
+    hdr = (region_hdr*)base;
+    used = hdr->used;
+    users = HASH_REL_PTR(example_user_t*, hdr->users);
+    for(i=0; i<1000; i++) {
+        HASH_FIND_INT(users,&i,user);
+        if (!user) continue;
+        if (user->cookie == i*i) found++;
+        if ((char*)user >= view2 && (char*)user < view2 + REGION) inside++;
+    }
+    printf("view 2 found: %d, inside view 2: %d\n", found, inside);
+    for(i=1000; i<1100; i++) {
+        if ( (user = (example_user_t*)region_alloc(NULL,0,sizeof(example_user_t))) == NULL) exit(-1);
+        user->id = i;
+        user->cookie = i*i;
+        HASH_ADD_INT(users,id,user);
+    }
+    hdr->users = HASH_REL_OFF(users);
+    hdr->used = used;
+    n = count_ids(users, &sum);
+    printf("view 2 items: %d, sum: %d\n", n, sum);
+
+    /* and see the additions back in the first view */
+    base = view1;
+    hdr = (region_hdr*)base;
+    users = HASH_REL_PTR(example_user_t*, hdr->users);
+    n = count_ids(users, &sum);
+    printf("view 1 items: %d (count %u), sum: %d\n", n,
+           (unsigned)HASH_COUNT(users), sum);
+    i = 1050;
+    HASH_FIND_INT(users,&i,user);
+    printf("view 1 id 1050: %s\n", (user && (char*)user < view1 + REGION &&
+                                     (char*)user >= view1) ? "found" : "missing");
+    munmap(view1, REGION);
+    munmap(view2, REGION);
+    close(fd);
+    remove("test96.shm");
+    return 0;
+}
@@ -0,0 +1,108 @@
+#include <stdlib.h>   /* malloc */
+#include <stdio.h>    /* printf, remove */
+#include <string.h>   /* memcpy */
+
+/* damage a snapshot in various ways; HASH_MAP must refuse each copy rather
+ * than read outside the file */
+#define HASH_SNAPSHOT
+#include "uthash.h"
+
+#define NUM 100
+
+typedef struct example_user_t {
+    int id;
+    UT_hash_handle hh;
+} example_user_t;
+
+static char *good;
+static size_t good_len;
+
+/* write the first len bytes of the good snapshot to test97.bad, after
+ * letting damage() change them, then map it */
+static int try_map(size_t len, void (*damage)(char *buf, size_t len)) {
+    UT_hash_map map;
+    FILE *fp;
+    char *buf;
+    int rc;
+    if ( (buf = (char*)malloc(good_len)) == NULL) exit(-1);
+    memcpy(buf, good, good_len);
+    if (damage) damage(buf, len);
+    if ( (fp = fopen("test97.bad", "wb")) == NULL) exit(-1);
+    if (fwrite(buf, 1, len, fp) != len) exit(-1);
+    fclose(fp);
+    free(buf);
+    memset(&map, 0, sizeof(map));
+    HASH_MAP(&map, "test97.bad", rc);
+    if (rc == 0) HASH_UNMAP(&map);
+    remove("test97.bad");
+    return rc;
+}
+
+#define HDR(buf) ((UT_hash_snap_hdr*)(buf))
+#define BKTS(buf) ((uint64_t*)((buf) + HDR(buf)->bkt_off))
+#define ENTS(buf) ((UT_hash_snap_ent*)((buf) + HDR(buf)->ent_off))
+
+static void fix_size(char *buf, size_t len) { HDR(buf)->file_size = len; }
+static void bkt_off_far(char *buf, size_t len) {
+    HDR(buf)->bkt_off = (uint64_t)1 << 40;
+}
+static void ent_off_unaligned(char *buf, size_t len) {
+    HDR(buf)->ent_off += 8;
+}
+static void many_items(char *buf, size_t len) {
+    HDR(buf)->num_items = 1000000;
+}
+static void huge_elt_size(char *buf, size_t len) {
+    HDR(buf)->elt_size = ~(uint64_t)0 / 2;
+}
+static void buckets_out_of_order(char *buf, size_t len) {
+    BKTS(buf)[1] = NUM + 1;
+}
+static void buckets_short(char *buf, size_t len) {
+    BKTS(buf)[HDR(buf)->num_buckets] = NUM - 1;
+}
+static void key_past_end(char *buf, size_t len) {
+    ENTS(buf)[NUM-1].key = len;
+}
+static void key_wraps(char *buf, size_t len) {
+    ENTS(buf)[0].keylen = ~(uint64_t)0;
+}
+
+int main(int argc,char *argv[]) {
+    int i, rc;
+    example_user_t *user, *users=NULL;
+    FILE *fp;
+    long n;
+
+    for(i=0; i<NUM; i++) {
+        if ( (user = (example_user_t*)malloc(sizeof(example_user_t))) == NULL) exit(-1);
+        user->id = i;
+        HASH_ADD_INT(users,id,user);
+    }
+    HASH_SAVE(hh, users, "test97.snap", rc);
+    HASH_DESTROY(hh, users, free);
+    if (rc != 0 || (fp = fopen("test97.snap", "rb")) == NULL) exit(-1);
+    fseek(fp, 0L, SEEK_END);
+    n = ftell(fp);
+    rewind(fp);
+    good_len = (size_t)n;
+    if ( (good = (char*)malloc(good_len)) == NULL) exit(-1);
+    if (fread(good, 1, good_len, fp) != good_len) exit(-1);
+    fclose(fp);
+    remove("test97.snap");
+
+    printf("intact: %d\n", try_map(good_len, NULL));
+    printf("truncated: %d\n", try_map(good_len / 2, NULL));
+    printf("truncated, size fixed: %d\n", try_map(good_len / 2, fix_size));
+    printf("header only: %d\n", try_map(sizeof(UT_hash_snap_hdr), fix_size));
+    printf("buckets far away: %d\n", try_map(good_len, bkt_off_far));
+    printf("entries unaligned: %d\n", try_map(good_len, ent_off_unaligned));
+    printf("too many items: %d\n", try_map(good_len, many_items));
+    printf("huge items: %d\n", try_map(good_len, huge_elt_size));
+    printf("buckets out of order: %d\n", try_map(good_len, buckets_out_of_order));
+    printf("buckets end early: %d\n", try_map(good_len, buckets_short));
+    printf("key past end: %d\n", try_map(good_len, key_past_end));
+    printf("key length wraps: %d\n", try_map(good_len, key_wraps));
+    free(good);
+    return 0;
+}
@@ -0,0 +1,49 @@
+#include <stdlib.h>   /* malloc */
+#include <stdio.h>    /* printf */
+
+/* with HASH_EXPAND_INPLACE, a program that supplies uthash_malloc and
+ * uthash_free but no uthash_realloc has its bucket array grown by copying
+ * between blocks of its own allocator. Its blocks start past a header, so
+ * libc realloc could not be given them. */
+#define HASH_EXPAND_INPLACE
+#define HDR 16
+static int outstanding;
+static void *hdr_malloc(size_t sz) {
+    char *p = (char*)malloc(sz + HDR);
+    if (!p) return NULL;
+    outstanding++;
+    return p + HDR;
+}
+static void hdr_free(void *ptr) {
+    outstanding--;
+    free((char*)ptr - HDR);
+}
+#define uthash_malloc(sz) hdr_malloc(sz)
+#define uthash_free(ptr,sz) hdr_free(ptr)
+#include "uthash.h"
+
+#define NUM 10000
+
+typedef struct example_user_t {
+    int id;
+    UT_hash_handle hh;
+} example_user_t;
+
+int main(int argc,char *argv[]) {
+    int i, found=0;
+    example_user_t *user, *users=NULL;
+
+    for(i=0; i<NUM; i++) {
+        if ( (user = (example_user_t*)malloc(sizeof(example_user_t))) == NULL) exit(-1);
+        user->id = i;
+        HASH_ADD_INT(users,id,user);
+    }
+    for(i=0; i<NUM; i++) {
+        HASH_FIND_INT(users,&i,user);
+        if (user) found++;
+    }
+    printf("found: %d, buckets: %u\n", found, users->hh.tbl->num_buckets);
+    HASH_DESTROY(hh, users, free);
+    printf("blocks outstanding: %d\n", outstanding);
+    return 0;
+}
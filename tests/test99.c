@@ -0,0 +1,37 @@
+#include <stdlib.h>   /* malloc */
+#include <stdio.h>    /* printf */
+
+/* the default seed comes from the system's random source, so tables made
+ * one after another, even at the same address within the same second, get
+ * unrelated seeds */
+#define HASH_SEEDED
+#include "uthash.h"
+
+#define NUM 8
+
+typedef struct example_user_t {
+    int id;
+    UT_hash_handle hh;
+} example_user_t;
+
+int main(int argc,char *argv[]) {
+    int i, j, same=0;
+    uint64_t seeds[NUM];
+    example_user_t *user, *users=NULL;
+
+    if ( (user = (example_user_t*)malloc(sizeof(example_user_t))) == NULL) exit(-1);
+    user->id = 1;
+    for(i=0; i<NUM; i++) {
+        HASH_ADD_INT(users,id,user);
+        seeds[i] = users->hh.tbl->seed;
+        HASH_DEL(users,user);       /* frees the table */
+    }
+    for(i=0; i<NUM; i++) {
+        for(j=0; j<i; j++) {
+            if (seeds[i] == seeds[j]) same++;
+        }
+    }
+    printf("tables: %d, equal seeds: %d\n", NUM, same);
+    free(user);
+    return 0;
+}
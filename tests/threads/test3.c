@@ -0,0 +1,105 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <pthread.h>
+#include <sched.h>
+
+/* lock-free readers with -DHASH_RCU: the main thread adds, reserves and
+ * deletes, while the readers look keys up without any lock */
+#define HASH_RCU
+#define uthash_rcu_domain(head) (&rcu)
+#include "uthash.h"
+
+#define NREADERS 4
+#define KEYS 10000
+
+typedef struct {
+  int i;
+  int v;
+  UT_hash_handle hh;
+} elt;
+
+UT_hash_rcu rcu;    /* the domain of the readers */
+elt *elts=NULL;     /* the table they read */
+int added=0;        /* keys below this have been added */
+int deleted=0;      /* once set, the odd keys may be gone */
+int done=0;
+
+void *thread_routine_r( void *arg ) {
+    long reader = (long)arg, errors=0;
+    unsigned r = (unsigned)reader + 1;
+    int k, a;
+    elt *e;
+
+    while (!__atomic_load_n(&done, __ATOMIC_ACQUIRE)) {
+      r = r * 1103515245 + 12345;
+      k = (int)((r >> 8) % (KEYS + KEYS/10));
+      a = __atomic_load_n(&added, __ATOMIC_ACQUIRE);
+      HASH_RCU_READ_LOCK(&rcu, reader);
+      HASH_FIND_INT(elts, &k, e);
+      if (e && ((e->i != k) || (e->v != 2*k))) errors++;
+      if (!e && (k < a) && ((k % 2 == 0) ||
+                            !__atomic_load_n(&deleted, __ATOMIC_ACQUIRE))) {
+        errors++;
+      }
+      if (e && (k >= KEYS)) errors++;
+      HASH_RCU_READ_UNLOCK(&rcu, reader);
+    }
+    return (void*)errors;
+}
+
+int main() {
+    long i, errors=0;
+    pthread_t readers[NREADERS];
+    void *thread_result;
+    elt *e, *tmp, **gone;
+
+    for(i=0; i < NREADERS; i++) {
+      if (pthread_create( &readers[i], NULL, thread_routine_r, (void*)i )) {
+        printf("failure: pthread_create\n");
+        exit(-1);
+      }
+    }
+
+    for(i=0; i < KEYS; i++) {
+      if ( (e = (elt*)malloc(sizeof(elt))) == NULL) exit(-1);
+      e->i = (int)i;
+      e->v = 2*(int)i;
+      HASH_ADD_INT(elts, i, e);
+      __atomic_store_n(&added, (int)i+1, __ATOMIC_RELEASE);
+      if (i % 64 == 0) sched_yield();  /* let the readers in, even on one cpu */
+    }
+    HASH_RESERVE(hh, elts, 4*KEYS);
+
+    /* unlink the odd keys, then wait out the readers before freeing them */
+    if ( (gone = (elt**)malloc(KEYS/2 * sizeof(elt*))) == NULL) exit(-1);
+    __atomic_store_n(&deleted, 1, __ATOMIC_RELEASE);
+    for(i=1; i < KEYS; i += 2) {
+      HASH_FIND_INT(elts, &i, e);
+      HASH_DEL(elts, e);
+      gone[i/2] = e;
+      if (i % 64 == 1) sched_yield();
+    }
+    HASH_SHRINK(hh, elts);
+    HASH_RCU_SYNCHRONIZE(&rcu);
+    for(i=0; i < KEYS/2; i++) {
+      gone[i]->v = -1;
+      free(gone[i]);
+    }
+    free(gone);
+
+    __atomic_store_n(&done, 1, __ATOMIC_RELEASE);
+    for(i=0; i < NREADERS; i++) {
+      pthread_join( readers[i], &thread_result );
+      errors += (long)thread_result;
+    }
+    printf("readers: %d, errors: %ld\n", NREADERS, errors);
+    printf("count: %u, buckets: %u\n", HASH_COUNT(elts),
+           (unsigned)elts->hh.tbl->num_buckets);
+
+    HASH_ITER(hh, elts, e, tmp) {
+      HASH_DEL(elts, e);
+      free(e);
+    }
+    printf("empty: %s\n", elts ? "no" : "yes");
+    return 0;
+}
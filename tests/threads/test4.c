@@ -0,0 +1,92 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <pthread.h>
+#include "utchash.h"
+
+/* many writers on one utchash table: each thread adds and deletes its own
+ * keys, then they all race to add the same keys with CHASH_FIND_OR_ADD */
+#define NTHREADS 8
+#define PER_THREAD 10000
+#define SHARED 1000
+
+typedef struct {
+  int i;
+  int t;
+  UT_chash_handle hh;
+} elt;
+
+UT_chash_table tbl;
+
+void *thread_routine( void *arg ) {
+    long t = (long)arg, errors=0, won=0;
+    int j, k;
+    elt *e, *out;
+
+    for(j=0; j < PER_THREAD; j++) {
+      if ( (e = (elt*)malloc(sizeof(elt))) == NULL) exit(-1);
+      e->i = (int)t + NTHREADS*j;
+      e->t = (int)t;
+      CHASH_ADD_INT(&tbl, i, e);
+      CHASH_FIND_INT(&tbl, &e->i, out);
+      if (out != e) errors++;
+    }
+    for(j=1; j < PER_THREAD; j += 2) {
+      k = (int)t + NTHREADS*j;
+      CHASH_FIND_INT(&tbl, &k, e);
+      if (!e || (e->t != (int)t)) { errors++; continue; }
+      CHASH_DEL(&tbl, e);
+      free(e);
+      CHASH_FIND_INT(&tbl, &k, e);
+      if (e) errors++;
+    }
+    for(j=0; j < SHARED; j++) {
+      if ( (e = (elt*)malloc(sizeof(elt))) == NULL) exit(-1);
+      e->i = NTHREADS*PER_THREAD + j;
+      e->t = (int)t;
+      CHASH_FIND_OR_ADD(hh, &tbl, i, sizeof(int), e, out);
+      if (out == e) won++;
+      else free(e);
+    }
+    if (errors) printf("thread %ld: %ld errors\n", t, errors);
+    return (void*)won;
+}
+
+int main() {
+    long i, won=0;
+    int k;
+    UT_hash_size n;
+    pthread_t threads[NTHREADS];
+    void *thread_result;
+    elt *e;
+
+    CHASH_INIT(&tbl, elt, hh);
+    for(i=0; i < NTHREADS; i++) {
+      if (pthread_create( &threads[i], NULL, thread_routine, (void*)i )) {
+        printf("failure: pthread_create\n");
+        exit(-1);
+      }
+    }
+    for(i=0; i < NTHREADS; i++) {
+      pthread_join( threads[i], &thread_result );
+      won += (long)thread_result;
+    }
+    printf("shared keys added: %ld\n", won);
+    CHASH_COUNT(&tbl, n);
+    printf("count: %u\n", (unsigned)n);
+
+    /* every even key remains, and every shared key; free them all */
+    for(k=0, i=0; k < NTHREADS*PER_THREAD + SHARED; k++) {
+      CHASH_FIND_INT(&tbl, &k, e);
+      if (!e) continue;
+      if ((k < NTHREADS*PER_THREAD) && ((k / NTHREADS) % 2)) {
+        printf("key %d was deleted\n", k);
+      }
+      CHASH_DEL(&tbl, e);
+      free(e);
+      i++;
+    }
+    CHASH_COUNT(&tbl, n);
+    printf("freed: %ld, count: %u\n", i, (unsigned)n);
+    CHASH_FREE(&tbl);
+    return 0;
+}
@@ -0,0 +1,99 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <pthread.h>
+#include "utchash.h"
+
+/* eight writers on 16 sharded uthash tables */
+#define NTHREADS 8
+#define PER_THREAD 10000
+#define SHARED 1000
+
+typedef struct {
+  int i;
+  int t;
+  UT_hash_handle hh;
+} elt;
+
+UT_hash_shards(elt,4) shards;
+
+void *thread_routine( void *arg ) {
+    long t = (long)arg, errors=0, won=0;
+    int j, k;
+    elt *e, *out;
+
+    for(j=0; j < PER_THREAD; j++) {
+      if ( (e = (elt*)malloc(sizeof(elt))) == NULL) exit(-1);
+      e->i = (int)t + NTHREADS*j;
+      e->t = (int)t;
+      HASH_SHARD_ADD_INT(&shards, i, e);
+      HASH_SHARD_FIND_INT(&shards, &e->i, out);
+      if (out != e) errors++;
+    }
+    for(j=1; j < PER_THREAD; j += 2) {
+      k = (int)t + NTHREADS*j;
+      HASH_SHARD_FIND_INT(&shards, &k, e);
+      if (!e || (e->t != (int)t)) { errors++; continue; }
+      HASH_SHARD_DEL(&shards, e);
+      free(e);
+      HASH_SHARD_FIND_INT(&shards, &k, e);
+      if (e) errors++;
+    }
+    for(j=0; j < SHARED; j++) {
+      if ( (e = (elt*)malloc(sizeof(elt))) == NULL) exit(-1);
+      e->i = NTHREADS*PER_THREAD + j;
+      e->t = (int)t;
+      HASH_SHARD_FIND_OR_ADD(hh, &shards, i, sizeof(int), e, out);
+      if (out == e) won++;
+      else free(e);
+    }
+    if (errors) printf("thread %ld: %ld errors\n", t, errors);
+    return (void*)won;
+}
+
+int main() {
+    long i, won=0, seen=0, used=0;
+    unsigned s;
+    UT_hash_size n;
+    pthread_t threads[NTHREADS];
+    void *thread_result;
+    elt *e, *tmp;
+
+    HASH_SHARDS_INIT(&shards);
+    printf("shards: %u\n", (unsigned)HASH_SHARDS_NUM(&shards));
+    for(i=0; i < NTHREADS; i++) {
+      if (pthread_create( &threads[i], NULL, thread_routine, (void*)i )) {
+        printf("failure: pthread_create\n");
+        exit(-1);
+      }
+    }
+    for(i=0; i < NTHREADS; i++) {
+      pthread_join( threads[i], &thread_result );
+      won += (long)thread_result;
+    }
+    printf("shared keys added: %ld\n", won);
+    HASH_SHARDS_COUNT(hh, &shards, n);
+    printf("count: %u\n", (unsigned)n);
+
+    /* every shard has items, and expanded on its own */
+    for(s=0; s < HASH_SHARDS_NUM(&shards); s++) {
+      if (HASH_CNT(hh, shards.shard[s].head) > 0) used++;
+    }
+    printf("shards used: %ld\n", used);
+
+    HASH_SHARDS_ITER(hh, &shards, s, e, tmp) {
+      if ((e->i < NTHREADS*PER_THREAD) && ((e->i / NTHREADS) % 2)) {
+        printf("key %d was deleted\n", e->i);
+      }
+      seen++;
+    }
+    printf("iterated: %ld\n", seen);
+
+    HASH_SHARDS_ITER(hh, &shards, s, e, tmp) {
+      HASH_DEL(shards.shard[s].head, e);
+      free(e);
+    }
+    HASH_SHARDS_COUNT(hh, &shards, n);
+    printf("count: %u\n", (unsigned)n);
+    HASH_SHARDS_FREE(hh, &shards);
+    return 0;
+}
@@ -0,0 +1,97 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <pthread.h>
+
+/* HASH_SRT_PARALLEL with -DHASH_SORT_THREADS: sort a large table on four
+ * threads by a key with many ties, and check the order, its stability, and
+ * the links. HASH_SRT is unchanged by the option: it still takes a typed
+ * comparison function or a macro, and sorts in the calling thread. */
+#define HASH_SORT_THREADS
+#include "uthash.h"
+
+#define NUM 20000
+
+typedef struct {
+  int id;
+  int grp;      /* the sort key; many items share one */
+  int seq;      /* the item's place in the application order before sorting */
+  UT_hash_handle hh;
+} elt;
+
+pthread_t main_thread;
+int off_main;   /* set when a comparison runs on another thread */
+
+int grpcmp(const void *_a, const void *_b) {
+    const elt *a = (const elt*)_a, *b = (const elt*)_b;
+    if (!pthread_equal(pthread_self(), main_thread)) {
+      __atomic_store_n(&off_main, 1, __ATOMIC_RELAXED);
+    }
+    return (a->grp > b->grp) - (a->grp < b->grp);
+}
+
+#define idcmp(a,b) (((a)->id > (b)->id) - ((a)->id < (b)->id))
+
+int seqcmp(elt *a, elt *b) {
+    if (!pthread_equal(pthread_self(), main_thread)) {
+      __atomic_store_n(&off_main, 1, __ATOMIC_RELAXED);
+    }
+    return (a->seq > b->seq) - (a->seq < b->seq);
+}
+
+int main() {
+    int i, n, errors, unstable;
+    elt *e, *prev, *elts=NULL;
+
+    main_thread = pthread_self();
+    for(i=0; i < NUM; i++) {
+      if ( (e = (elt*)malloc(sizeof(elt))) == NULL) exit(-1);
+      e->id = i;
+      e->grp = (int)(((unsigned)i * 2654435761U) % 1000);
+      e->seq = i;
+      HASH_ADD_INT(elts, id, e);
+    }
+    HASH_SRT_PARALLEL(hh, elts, grpcmp, 4);
+    printf("UT_hash_cmp on sort threads: %s\n", off_main ? "yes" : "no");
+
+    n = errors = unstable = 0;
+    for(prev=NULL, e=elts; e; prev=e, e=(elt*)HASH_NEXT(hh,e)) {
+      if ((elt*)HASH_PREV(hh,e) != prev) errors++;
+      if (prev && (prev->grp > e->grp)) errors++;
+      if (prev && (prev->grp == e->grp) && (prev->seq > e->seq)) unstable++;
+      n++;
+    }
+    if (ELMT_FROM_HH(elts->hh.tbl, elts->hh.tbl->tail) != prev) errors++;
+    printf("sorted: %d, errors: %d, unstable: %d\n", n, errors, unstable);
+
+    for(i=0; i < NUM; i += 100) {
+      HASH_FIND_INT(elts, &i, e);
+      if (!e || (e->id != i)) errors++;
+    }
+    printf("found, errors: %d\n", errors);
+
+    off_main = 0;
+    HASH_SORT(elts, seqcmp);
+    n = errors = 0;
+    for(prev=NULL, e=elts; e; prev=e, e=(elt*)HASH_NEXT(hh,e)) {
+      if ((elt*)HASH_PREV(hh,e) != prev) errors++;
+      if (prev && (prev->seq > e->seq)) errors++;
+      n++;
+    }
+    printf("typed cmp on sort threads: %s\n", off_main ? "yes" : "no");
+    printf("sorted: %d, errors: %d\n", n, errors);
+
+    HASH_SORT(elts, idcmp);
+    n = errors = 0;
+    for(prev=NULL, e=elts; e; prev=e, e=(elt*)HASH_NEXT(hh,e)) {
+      if (prev && (prev->id > e->id)) errors++;
+      n++;
+    }
+    printf("macro cmp sorted: %d, errors: %d\n", n, errors);
+
+    while (elts) {
+      e = elts;
+      HASH_DEL(elts, e);
+      free(e);
+    }
+    return 0;
+}
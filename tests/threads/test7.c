@@ -0,0 +1,102 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <pthread.h>
+#include <sched.h>
+
+/* lock-free readers with -DHASH_RCU while the writer grows and shrinks the
+ * bucket array over and over. A lookup that indexed one array with the size
+ * of another would read past its end; built with "make asan", such a read
+ * stops the test. */
+#define HASH_RCU
+#define uthash_rcu_domain(head) (&rcu)
+#include "uthash.h"
+
+#define NREADERS 4
+#define RESIDENT 256     /* keys always present */
+#define KEYS 8192        /* keys added and deleted each round */
+#define ROUNDS 50
+
+typedef struct {
+  int i;
+  UT_hash_handle hh;
+} elt;
+
+UT_hash_rcu rcu;
+elt *elts=NULL;
+elt *pool[KEYS];
+int done=0;
+
+void *thread_routine_r( void *arg ) {
+    long reader = (long)arg, errors=0;
+    unsigned r = (unsigned)reader + 1;
+    UT_hash_value hashv;
+    int k;
+    elt *e;
+
+    while (!__atomic_load_n(&done, __ATOMIC_ACQUIRE)) {
+      r = r * 1103515245 + 12345;
+      k = (int)((r >> 8) % KEYS);
+      HASH_RCU_READ_LOCK(&rcu, reader);
+      if (r & 0x80) {
+        HASH_FIND_INT(elts, &k, e);
+      } else {
+        HASH_VALUE(hh, elts, &k, sizeof(int), hashv);
+        HASH_FIND_BYHASHVALUE(hh, elts, &k, sizeof(int), hashv, e);
+      }
+      if (e && e->i != k) errors++;
+      if (!e && k < RESIDENT) errors++;
+      HASH_RCU_READ_UNLOCK(&rcu, reader);
+    }
+    return (void*)errors;
+}
+
+int main() {
+    long i, round, errors=0, shrinks=0;
+    pthread_t readers[NREADERS];
+    void *thread_result;
+    unsigned grown=0;
+    elt *e, *tmp;
+
+    for(i=0; i < KEYS; i++) {
+      if ( (pool[i] = (elt*)malloc(sizeof(elt))) == NULL) exit(-1);
+      pool[i]->i = (int)i;
+    }
+    for(i=0; i < RESIDENT; i++) HASH_ADD_INT(elts, i, pool[i]);
+
+    for(i=0; i < NREADERS; i++) {
+      if (pthread_create( &readers[i], NULL, thread_routine_r, (void*)i )) {
+        printf("failure: pthread_create\n");
+        exit(-1);
+      }
+    }
+
+    for(round=0; round < ROUNDS; round++) {
+      for(i=RESIDENT; i < KEYS; i++) {
+        HASH_ADD_INT(elts, i, pool[i]);
+        if (i % 512 == 0) sched_yield();
+      }
+      if (elts->hh.tbl->num_buckets > grown) grown = elts->hh.tbl->num_buckets;
+      for(i=RESIDENT; i < KEYS; i++) {
+        HASH_DEL(elts, pool[i]);
+      }
+      HASH_SHRINK(hh, elts);
+      if (elts->hh.tbl->num_buckets < grown) shrinks++;
+      HASH_RCU_SYNCHRONIZE(&rcu);   /* before the deleted items are reused */
+    }
+
+    __atomic_store_n(&done, 1, __ATOMIC_RELEASE);
+    for(i=0; i < NREADERS; i++) {
+      pthread_join( readers[i], &thread_result );
+      errors += (long)thread_result;
+    }
+    printf("readers: %d, errors: %ld\n", NREADERS, errors);
+    printf("rounds: %d, shrunk each round: %s\n", ROUNDS,
+           (shrinks == ROUNDS) ? "yes" : "no");
+    printf("count: %u\n", HASH_COUNT(elts));
+
+    HASH_ITER(hh, elts, e, tmp) {
+      HASH_DEL(elts, e);
+    }
+    for(i=0; i < KEYS; i++) free(pool[i]);
+    return 0;
+}